@@ -0,0 +1,136 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  iconcache.cpp
+ * @brief IconCache class implementation
+ */
+
+#include "iconcache.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QThread>
+
+/**
+ * @brief Construct the cache and start its clock
+ */
+IconCache::IconCache()
+{
+    mTimer.start();
+}
+
+/**
+ * @brief The process-wide cache instance
+ * @return Reference to the shared cache
+ */
+IconCache &IconCache::instance()
+{
+    static IconCache cache;
+    return cache;
+}
+
+/**
+ * @brief Get the icon for the icon *type* and *name*
+ *
+ * The icon is loaded on the first request, and the same QIcon is
+ * returned for later requests. For Machine::IconFromFile, the icon is
+ * loaded again if the file has been modified.
+ *
+ * @pre This method must be called in the user interface thread.
+ *
+ * @param[in] type   How the *name* is interpreted
+ * @param[in] name   Icon name from the theme or path to the icon file
+ * @return Shared icon, or a null icon for Machine::NoIcon
+ */
+QIcon IconCache::icon(Machine::IconType type, const QString &name)
+{
+    if (type == Machine::NoIcon) {
+        return {};
+    }
+    Q_ASSERT(QCoreApplication::instance() == nullptr
+             || QThread::currentThread() == QCoreApplication::instance()->thread());
+
+    const auto now = mTimer.elapsed();
+    auto it = mIcons.find({type, name});
+    if (it != mIcons.end()) {
+        if (type != Machine::IconFromFile || now - it->checkedAt < mFileCheckInterval) {
+            ++mHits;
+            return it->icon;
+        }
+        it->checkedAt = now;
+        if (QFileInfo(name).lastModified() == it->modified) {
+            ++mHits;
+            return it->icon;
+        }
+    } else {
+        it = mIcons.insert({type, name}, {});
+    }
+
+    ++mMisses;
+    if (type == Machine::IconFromTheme) {
+        it->icon = QIcon::fromTheme(name);
+    } else {
+        it->modified = QFileInfo(name).lastModified();
+        it->checkedAt = now;
+        it->icon = QIcon(name);
+    }
+    return it->icon;
+}
+
+/**
+ * @brief Remove all icons from the cache
+ *
+ * This is needed if the icon theme changes. The counters are reset too.
+ */
+void IconCache::clear()
+{
+    mIcons.clear();
+    mHits = 0;
+    mMisses = 0;
+}
+
+/**
+ * @brief File check interval getter
+ * @return Minimum time between checks of an icon file in milliseconds
+ */
+int IconCache::fileCheckInterval() const
+{
+    return mFileCheckInterval;
+}
+
+/**
+ * @brief Set the minimum time between checks of an icon file
+ * @param[in] msec   Time in milliseconds, or zero to check on every request
+ */
+void IconCache::setFileCheckInterval(int msec)
+{
+    mFileCheckInterval = msec;
+}
+
+/**
+ * @brief Cache hit counter
+ * @return Number of requests served from the cache
+ */
+qint64 IconCache::hits() const
+{
+    return mHits;
+}
+
+/**
+ * @brief Cache miss counter
+ * @return Number of requests that loaded the icon
+ */
+qint64 IconCache::misses() const
+{
+    return mMisses;
+}
+
+/**
+ * @brief Number of cached icons
+ * @return Icon count in the cache
+ */
+int IconCache::size() const
+{
+    return static_cast<int>(mIcons.size());
+}
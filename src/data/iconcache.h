@@ -0,0 +1,79 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  iconcache.h
+ * @brief IconCache class definition
+ */
+
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIcon>
+#include "machine.h"
+
+/**
+ * @brief Process-wide cache for machine icons
+ *
+ * Most machines use one of a few theme icons, so the machines do not
+ * keep icons of their own. Instead, Machine::icon() asks the icon from
+ * this cache, and all machines with the same icon type and icon name
+ * share one QIcon.
+ *
+ * Icons from files are loaded again when the modification time of the
+ * file changes. The file is checked at most once per
+ * @ref setFileCheckInterval "check interval", so that painting a long
+ * list does not hit the file system for every row.
+ *
+ * The cache must only be used in the user interface thread, because
+ * QIcon objects for theme icons and icon files may only be created
+ * there. For the same reason, the cache has no locking, and a lookup
+ * while painting costs only a hash lookup.
+ */
+class IconCache
+{
+    Q_DISABLE_COPY_MOVE(IconCache)
+
+public:
+    static IconCache &instance();
+
+    QIcon icon(Machine::IconType type, const QString &name);
+    void clear();
+
+    [[nodiscard]] int fileCheckInterval() const;
+    void setFileCheckInterval(int msec);
+
+    [[nodiscard]] qint64 hits() const;
+    [[nodiscard]] qint64 misses() const;
+    [[nodiscard]] int size() const;
+
+private:
+    IconCache();
+    ~IconCache() = default;
+
+    /**
+     * @brief Cached icon with the information for invalidating it
+     */
+    struct Entry
+    {
+        QIcon icon;          /*!< @brief The shared icon */
+        QDateTime modified;  /*!< @brief Modification time of the icon file */
+        qint64 checkedAt{0}; /*!< @brief When the icon file was checked, in mTimer time */
+    };
+
+    /**
+     * @brief Key for cached icons
+     */
+    using Key = QPair<int, QString>;
+
+    QHash<Key, Entry> mIcons;     /*!< @brief Icons by icon type and icon name */
+    QElapsedTimer mTimer;         /*!< @brief Clock for the file check interval */
+    int mFileCheckInterval{1000}; /*!< @brief Minimum time between file checks in milliseconds */
+    qint64 mHits{0};              /*!< @brief Lookups served from the cache */
+    qint64 mMisses{0};            /*!< @brief Lookups that loaded the icon */
+};
+
+#endif // ICONCACHE_H
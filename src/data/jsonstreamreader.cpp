@@ -0,0 +1,497 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  jsonstreamreader.cpp
+ * @brief JsonStreamReader class implementation
+ */
+
+#include "jsonstreamreader.h"
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Deepest nesting of arrays and objects accepted by the reader
+ *
+ * This is the same limit that QJsonDocument uses.
+ */
+constexpr int MAX_DEPTH = 1024;
+
+// Check if the character is a decimal digit
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Convert four hexadecimal digits from an \u escape sequence
+bool readHex4(const char *hex, char16_t &code)
+{
+    code = 0;
+    for (int i = 0; i < 4; ++i) {
+        const auto c = hex[i];
+        int digit = 0;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        code = static_cast<char16_t>(code * 16 + digit);
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Construct a reader for the JSON text in *data*
+ * @param[in] data   UTF-8 encoded JSON text, which must outlive the reader
+ */
+JsonStreamReader::JsonStreamReader(const QByteArray &data)
+    : mBegin(data.constData())
+    , mPos(data.constData())
+    , mEnd(data.constData() + data.size())
+{}
+
+/**
+ * @brief Move to the next token
+ *
+ * The reader checks the JSON syntax while reading. On a syntax error
+ * Invalid is returned, and all further calls return Invalid too.
+ *
+ * @return Type of the new token
+ */
+JsonStreamReader::TokenType JsonStreamReader::readNext()
+{
+    if (hasError()) {
+        return Invalid;
+    }
+    if (mToken == EndDocument) {
+        return EndDocument;
+    }
+
+    skipWhitespace();
+    if (mNesting.isEmpty()) {
+        if (!mStarted) {
+            mStarted = true;
+            return mToken = readValueToken();
+        }
+        if (mPos != mEnd) {
+            return raiseError(QStringLiteral("Garbage at the end of the document"));
+        }
+        return mToken = EndDocument;
+    }
+
+    if (mPos == mEnd) {
+        return raiseError(QStringLiteral("Unexpected end of document"));
+    }
+
+    const auto container = mNesting.last();
+    const auto close = container == '[' ? ']' : '}';
+    if (*mPos == close && !mAfterName && !mAfterComma) {
+        mTokenOffset = mPos - mBegin;
+        ++mPos;
+        mNesting.removeLast();
+        mNeedSeparator = true;
+        return mToken = container == '[' ? EndArray : EndObject;
+    }
+
+    if (mNeedSeparator) {
+        if (*mPos != ',') {
+            return raiseError(QStringLiteral("Expected comma or closing bracket"));
+        }
+        ++mPos;
+        mNeedSeparator = false;
+        mAfterComma = true;
+        skipWhitespace();
+    }
+
+    if (container == '{' && !mAfterName) {
+        if (mPos == mEnd || *mPos != '"') {
+            return raiseError(QStringLiteral("Expected object name"));
+        }
+        mTokenOffset = mPos - mBegin;
+        if (readString(Name) == Invalid) {
+            return Invalid;
+        }
+        skipWhitespace();
+        if (mPos == mEnd || *mPos != ':') {
+            return raiseError(QStringLiteral("Expected colon after object name"));
+        }
+        ++mPos;
+        mAfterName = true;
+        mAfterComma = false;
+        return mToken = Name;
+    }
+
+    mAfterName = false;
+    mAfterComma = false;
+    return mToken = readValueToken();
+}
+
+/**
+ * @brief Current token getter
+ * @return Type of the token from the last @ref readNext() call
+ */
+JsonStreamReader::TokenType JsonStreamReader::tokenType() const
+{
+    return mToken;
+}
+
+/**
+ * @brief Text of the current token
+ * @return Decoded text for Name and String tokens, empty otherwise
+ */
+QString JsonStreamReader::text() const
+{
+    return mText;
+}
+
+/**
+ * @brief Value of the current token
+ *
+ * Integers that fit into qint64 are returned as `qlonglong`, and other
+ * numbers as `double`.
+ *
+ * @return Value for scalar tokens, null QVariant for other tokens
+ */
+QVariant JsonStreamReader::toVariant() const
+{
+    switch (mToken) {
+    case Name:
+    case String:
+        return mText;
+    case Number:
+    case Bool:
+        return mValue;
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief Start of the current token
+ * @return Byte offset of the first character of the current token
+ */
+qint64 JsonStreamReader::tokenOffset() const
+{
+    return mTokenOffset;
+}
+
+/**
+ * @brief End of the current token
+ *
+ * For Name tokens, this is after the colon that follows the name.
+ *
+ * @return Byte offset right after the current token
+ */
+qint64 JsonStreamReader::offset() const
+{
+    return mPos - mBegin;
+}
+
+/**
+ * @brief Read the current value completely
+ *
+ * Arrays are converted into QVariantList and objects into QVariantMap,
+ * like QJsonValue::toVariant() does. After the call, the current token
+ * is the last token of the value.
+ *
+ * This is meant for values that the caller does not know how to handle
+ * itself, so that they can be kept as they are.
+ *
+ * @return Current value as QVariant, or null QVariant on error
+ */
+QVariant JsonStreamReader::readValue()
+{
+    switch (mToken) {
+    case StartArray: {
+        QVariantList list;
+        while (true) {
+            const auto token = readNext();
+            if (token == EndArray) {
+                return list;
+            }
+            if (token == Invalid) {
+                return {};
+            }
+            list.append(readValue());
+        }
+    }
+
+    case StartObject: {
+        QVariantMap map;
+        while (readNext() == Name) {
+            const auto name = mText;
+            readNext();
+            map.insert(name, readValue());
+        }
+        if (mToken != EndObject) {
+            return {};
+        }
+        return map;
+    }
+
+    default:
+        return toVariant();
+    }
+}
+
+/**
+ * @brief Skip the current value
+ *
+ * If the current token starts an array or an object, the reader moves
+ * to the token that closes it. Otherwise nothing is done.
+ *
+ * @return `true` if the value was skipped, `false` on syntax error
+ */
+bool JsonStreamReader::skipValue()
+{
+    if (mToken != StartArray && mToken != StartObject) {
+        return !hasError();
+    }
+    const auto depth = mNesting.size();
+    while (mNesting.size() >= depth) {
+        if (readNext() == Invalid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check if the reader has found a syntax error
+ * @return `true` if the JSON text is not valid
+ */
+bool JsonStreamReader::hasError() const
+{
+    return !mErrorString.isEmpty();
+}
+
+/**
+ * @brief Description of the syntax error
+ * @return Error message with the byte offset, or empty string if there is no error
+ */
+QString JsonStreamReader::errorString() const
+{
+    return mErrorString;
+}
+
+/**
+ * @brief Read a value token at the current position
+ * @return Type of the value token
+ */
+JsonStreamReader::TokenType JsonStreamReader::readValueToken()
+{
+    if (mPos == mEnd) {
+        return raiseError(QStringLiteral("Unexpected end of document"));
+    }
+
+    mTokenOffset = mPos - mBegin;
+    mNeedSeparator = true;
+    switch (*mPos) {
+    case '[':
+    case '{':
+        if (mNesting.size() >= MAX_DEPTH) {
+            return raiseError(QStringLiteral("Too deeply nested document"));
+        }
+        mNesting.append(*mPos);
+        mNeedSeparator = false;
+        return *mPos++ == '[' ? StartArray : StartObject;
+    case '"':
+        return readString(String);
+    case 't':
+        return readLiteral("true", Bool, true);
+    case 'f':
+        return readLiteral("false", Bool, false);
+    case 'n':
+        return readLiteral("null", Null, false);
+    default:
+        if (*mPos == '-' || isDigit(*mPos)) {
+            return readNumber();
+        }
+        return raiseError(QStringLiteral("Unexpected character"));
+    }
+}
+
+/**
+ * @brief Read a string starting from the opening quote
+ *
+ * Strings without escape sequences are converted from UTF-8 in one
+ * piece. Otherwise the string is converted in chunks between the escape
+ * sequences.
+ *
+ * @param[in] type   Token type for the string, either Name or String
+ * @return *type* if the string was read, Invalid otherwise
+ */
+JsonStreamReader::TokenType JsonStreamReader::readString(TokenType type)
+{
+    ++mPos;
+    mText.clear();
+    const char *chunk = mPos;
+    while (true) {
+        if (mPos == mEnd) {
+            return raiseError(QStringLiteral("Unterminated string"));
+        }
+        const auto c = static_cast<uchar>(*mPos);
+        if (c == '"') {
+            mText += QString::fromUtf8(chunk, static_cast<int>(mPos - chunk));
+            ++mPos;
+            return type;
+        }
+        if (c < 0x20) {
+            return raiseError(QStringLiteral("Control character in string"));
+        }
+        if (c != '\\') {
+            ++mPos;
+            continue;
+        }
+
+        mText += QString::fromUtf8(chunk, static_cast<int>(mPos - chunk));
+        if (mEnd - mPos < 2) {
+            return raiseError(QStringLiteral("Unterminated string"));
+        }
+        mPos += 2;
+        switch (mPos[-1]) {
+        case '"':
+        case '\\':
+        case '/':
+            mText += QLatin1Char(mPos[-1]);
+            break;
+        case 'b':
+            mText += QLatin1Char('\b');
+            break;
+        case 'f':
+            mText += QLatin1Char('\f');
+            break;
+        case 'n':
+            mText += QLatin1Char('\n');
+            break;
+        case 'r':
+            mText += QLatin1Char('\r');
+            break;
+        case 't':
+            mText += QLatin1Char('\t');
+            break;
+        case 'u': {
+            // Surrogate pairs come as two escape sequences, and the
+            // halves are combined by appending them one after another.
+            char16_t code = 0;
+            if (mEnd - mPos < 4 || !readHex4(mPos, code)) {
+                return raiseError(QStringLiteral("Invalid unicode escape sequence"));
+            }
+            mText += QChar(code);
+            mPos += 4;
+            break;
+        }
+        default:
+            return raiseError(QStringLiteral("Invalid escape sequence"));
+        }
+        chunk = mPos;
+    }
+}
+
+/**
+ * @brief Read a number at the current position
+ * @return Number if the number was read, Invalid otherwise
+ */
+JsonStreamReader::TokenType JsonStreamReader::readNumber()
+{
+    const char *start = mPos;
+    bool integer = true;
+
+    if (*mPos == '-') {
+        ++mPos;
+    }
+    if (mPos == mEnd || !isDigit(*mPos)) {
+        return raiseError(QStringLiteral("Invalid number"));
+    }
+    if (*mPos == '0') {
+        ++mPos;
+    } else {
+        while (mPos != mEnd && isDigit(*mPos)) {
+            ++mPos;
+        }
+    }
+    if (mPos != mEnd && *mPos == '.') {
+        integer = false;
+        ++mPos;
+        if (mPos == mEnd || !isDigit(*mPos)) {
+            return raiseError(QStringLiteral("Invalid number"));
+        }
+        while (mPos != mEnd && isDigit(*mPos)) {
+            ++mPos;
+        }
+    }
+    if (mPos != mEnd && (*mPos == 'e' || *mPos == 'E')) {
+        integer = false;
+        ++mPos;
+        if (mPos != mEnd && (*mPos == '+' || *mPos == '-')) {
+            ++mPos;
+        }
+        if (mPos == mEnd || !isDigit(*mPos)) {
+            return raiseError(QStringLiteral("Invalid number"));
+        }
+        while (mPos != mEnd && isDigit(*mPos)) {
+            ++mPos;
+        }
+    }
+
+    const QLatin1String number(start, static_cast<int>(mPos - start));
+    if (integer) {
+        bool ok = false;
+        const auto value = number.toLongLong(&ok);
+        if (ok) {
+            mValue = value;
+            return Number;
+        }
+    }
+    mValue = number.toDouble();
+    return Number;
+}
+
+/**
+ * @brief Read `true`, `false` or `null` at the current position
+ * @param[in] literal   Expected literal
+ * @param[in] type      Token type for the literal
+ * @param[in] value     Value for the Bool token
+ * @return *type* if the literal was read, Invalid otherwise
+ */
+JsonStreamReader::TokenType JsonStreamReader::readLiteral(const char *literal,
+                                                          TokenType type,
+                                                          bool value)
+{
+    const auto length = static_cast<qptrdiff>(std::strlen(literal));
+    if (mEnd - mPos < length || std::memcmp(mPos, literal, length) != 0) {
+        return raiseError(QStringLiteral("Unexpected character"));
+    }
+    mPos += length;
+    mValue = type == Bool ? QVariant(value) : QVariant();
+    return type;
+}
+
+/**
+ * @brief Stop reading because of a syntax error
+ * @param[in] message   Description of the error
+ * @return Always Invalid
+ */
+JsonStreamReader::TokenType JsonStreamReader::raiseError(const QString &message)
+{
+    mErrorString = QStringLiteral("%1 at offset %2").arg(message).arg(mPos - mBegin);
+    return mToken = Invalid;
+}
+
+/**
+ * @brief Move the read position over whitespace
+ */
+void JsonStreamReader::skipWhitespace()
+{
+    while (mPos != mEnd && (*mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t')) {
+        ++mPos;
+    }
+}
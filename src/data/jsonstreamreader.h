@@ -0,0 +1,96 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  jsonstreamreader.h
+ * @brief JsonStreamReader class definition
+ */
+
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+#include <QVariant>
+
+/**
+ * @brief Pull-style reader for UTF-8 encoded JSON
+ *
+ * The reader walks the JSON text one token at a time, so that the
+ * caller can fill its own objects directly from the tokens. Unlike
+ * QJsonDocument, no document tree is built, and the memory used by the
+ * reader does not depend on the size of the input.
+ *
+ * Each call to @ref readNext() moves to the next token. Names and
+ * strings are available from @ref text(), and numbers and booleans
+ * from @ref toVariant(). When the caller is not interested in the
+ * current value, it can be skipped with @ref skipValue(), or converted
+ * into a QVariant with @ref readValue().
+ *
+ * The byte offsets of the current token are available from
+ * @ref tokenOffset() and @ref offset(), so that the caller can keep
+ * the raw text of a value for later.
+ *
+ * The reader does not take a copy of the data, so the data must stay
+ * valid while the reader is used.
+ */
+class JsonStreamReader
+{
+public:
+    /**
+     * @brief Token types returned by @ref readNext()
+     */
+    enum TokenType {
+        Invalid,     /*!< @brief Syntax error, see @ref errorString() */
+        StartArray,  /*!< @brief Opening bracket of an array */
+        EndArray,    /*!< @brief Closing bracket of an array */
+        StartObject, /*!< @brief Opening brace of an object */
+        EndObject,   /*!< @brief Closing brace of an object */
+        Name,        /*!< @brief Name of the next value in an object */
+        String,      /*!< @brief String value */
+        Number,      /*!< @brief Number value */
+        Bool,        /*!< @brief `true` or `false` */
+        Null,        /*!< @brief `null` */
+        EndDocument  /*!< @brief The document has been read */
+    };
+
+    explicit JsonStreamReader(const QByteArray &data);
+
+    TokenType readNext();
+    [[nodiscard]] TokenType tokenType() const;
+    [[nodiscard]] QString text() const;
+    [[nodiscard]] QVariant toVariant() const;
+    [[nodiscard]] qint64 tokenOffset() const;
+    [[nodiscard]] qint64 offset() const;
+
+    QVariant readValue();
+    bool skipValue();
+
+    [[nodiscard]] bool hasError() const;
+    [[nodiscard]] QString errorString() const;
+
+private:
+    TokenType readValueToken();
+    TokenType readString(TokenType type);
+    TokenType readNumber();
+    TokenType readLiteral(const char *literal, TokenType type, bool value);
+    TokenType raiseError(const QString &message);
+    void skipWhitespace();
+
+    const char *mBegin;                 /*!< @brief Start of the JSON text */
+    const char *mPos;                   /*!< @brief Current read position */
+    const char *mEnd;                   /*!< @brief End of the JSON text */
+    QVarLengthArray<char, 16> mNesting; /*!< @brief Open containers as `[` or `{` */
+    TokenType mToken{Invalid};          /*!< @brief Current token */
+    qint64 mTokenOffset{0};             /*!< @brief Byte offset where the current token starts */
+    QString mText;                      /*!< @brief Decoded name or string of the current token */
+    QVariant mValue;                    /*!< @brief Number or boolean of the current token */
+    QString mErrorString;               /*!< @brief Description of the syntax error */
+    bool mStarted{false};               /*!< @brief The first token has been read */
+    bool mNeedSeparator{false};         /*!< @brief A comma or closing bracket must come next */
+    bool mAfterName{false};             /*!< @brief Object name was read, and the value comes next */
+    bool mAfterComma{false};            /*!< @brief Comma was read, and a value or name comes next */
+};
+
+#endif // JSONSTREAMREADER_H
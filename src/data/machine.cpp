@@ -7,8 +7,15 @@
  */
 
 #include "machine.h"
+#include "iconcache.h"
+#include "jsonstreamreader.h"
 
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QDebug>
 #include <QIcon>
+#include <QMutex>
 #include <QVariantMap>
 
 // MachineData
@@ -16,22 +23,43 @@
 
 /**
  * @brief Implicitly shared data for Machine objects
+ *
+ * The properties are split into two groups. Name, summary and the icon
+ * key are needed for showing the machine in the list, and they are
+ * always restored. The rest of the properties may be left in the raw
+ * *record* after a lazy restore, and they are restored the first time
+ * they are needed by calling @ref load(). Icons are not kept here, but
+ * they are shared from the IconCache.
+ *
+ * Loading happens from const methods, and copies of the machine may be
+ * used from different threads, so the lazily loaded members are
+ * mutable and protected by the *mutex*. The same applies to the *id*,
+ * which is created when it is first read, so that temporary machines
+ * and machines restored with an ID do not create random IDs.
  */
 class MachineData : public QSharedData
 {
 public:
-    void loadIcon();
+    MachineData();
+    MachineData(const MachineData &other);
+    ~MachineData() = default;
+    MachineData &operator=(const MachineData &) = delete;
+
+    void load() const;
 
     //NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    mutable QUuid id;       /*!< @brief Persistent ID, or null until it is first read */
+    bool idAssigned{false}; /*!< @brief The ID was assigned instead of restored */
+
     /// @brief Icon type tells us how to interpret *iconName*
     Machine::IconType iconType{Machine::NoIcon};
-    QIcon icon;              /*!< @brief The icon will be loaded into this object */
-    QString iconName;        /*!< @brief Either the icon theme name or path to the icon file */
-    QString name;            /*!< @brief Name of the emulated machine */
-    QString summary;         /*!< @brief A summary that appears below the name */
-    QString configFile;      /*!< @brief Path to the machine configuration file*/
-    QString startCommand;    /*!< @brief Custom start command or empty for the default */
-    QString settingsCommand; /*!< @brief Custom settings command or empty for the default */
+    QString iconName; /*!< @brief Either the icon theme name or path to the icon file */
+    QString name;     /*!< @brief Name of the emulated machine */
+    QString summary;  /*!< @brief A summary that appears below the name */
+
+    mutable QString configFile;      /*!< @brief Path to the machine configuration file*/
+    mutable QString startCommand;    /*!< @brief Custom start command or empty for the default */
+    mutable QString settingsCommand; /*!< @brief Custom settings command or empty for the default */
 
     /**
      * @brief Extra variables from the restore content
@@ -39,28 +67,247 @@ public:
      * We keep any extra variables here so that we save them back. Additional variables can
      * be user-defined or from the newer version of the launcher.
      */
-    QVariantMap extraVariables;
+    mutable QVariantMap extraVariables;
+
+    mutable QByteArray record;   /*!< @brief Raw JSON or CBOR record waiting for @ref load() */
+    mutable bool recordIsCbor{}; /*!< @brief The *record* is CBOR instead of JSON */
+    mutable QMutex mutex;        /*!< @brief Protects the lazily loaded members */
     //NOLINTEND(misc-non-private-member-variables-in-classes)
 };
 
+namespace {
+
 /**
- * @brief Set the *icon* by *iconType* and *iconName*
+ * @brief Groups of machine properties for restoring
  */
-void MachineData::loadIcon()
+enum PropertyGroup {
+    IndexProperties = 0x1,    /*!< @brief Properties shown in the machine list */
+    DeferredProperties = 0x2, /*!< @brief Properties which may be restored lazily */
+    AllProperties = IndexProperties | DeferredProperties
+};
+
+// Find out the property group for the key
+PropertyGroup propertyGroup(const QString &key)
 {
-    switch (iconType) {
-    case Machine::NoIcon:
-        icon = {};
-        return;
+    if (key == QLatin1String("id") || key == QLatin1String("iconType")
+        || key == QLatin1String("iconName") || key == QLatin1String("name")
+        || key == QLatin1String("summary")) {
+        return IndexProperties;
+    }
+    return DeferredProperties;
+}
+
+// Use the ID from the *text*, or keep the current ID if the text is not a valid ID
+//
+// Returns `true` if the current ID was kept, so that it is an assigned ID
+// which has not been saved yet.
+bool restoreId(MachineData &data, const QString &text)
+{
+    const QUuid id(text);
+    if (!id.isNull()) {
+        data.id = id;
+    }
+    data.idAssigned = id.isNull();
+    return data.idAssigned;
+}
+
+// Clear the properties in the groups before restoring them
+//
+// The ID is not cleared, so that a machine without an ID keeps the one
+// it got when it was created. It is marked as assigned until an ID is
+// restored.
+void clearProperties(MachineData &data, int groups)
+{
+    if ((groups & IndexProperties) != 0) {
+        data.idAssigned = true;
+        data.iconType = Machine::NoIcon;
+        data.iconName.clear();
+        data.name.clear();
+        data.summary.clear();
+    }
+    if ((groups & DeferredProperties) != 0) {
+        data.configFile.clear();
+        data.startCommand.clear();
+        data.settingsCommand.clear();
+        data.extraVariables.clear();
+    }
+}
+
+// Read a complete string value, or convert any other value into a string
+QString readCborString(QCborStreamReader &reader)
+{
+    if (!reader.isString()) {
+        return QCborValue::fromCbor(reader).toVariant().toString();
+    }
+    QString string;
+    auto result = reader.readString();
+    while (result.status == QCborStreamReader::Ok) {
+        string += result.data;
+        result = reader.readString();
+    }
+    return string;
+}
+
+// Read properties in the groups from a CBOR map and skip the others
+bool readCbor(QCborStreamReader &reader, MachineData &data, int groups)
+{
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+
+    clearProperties(data, groups);
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        if (!reader.isString()) {
+            return false;
+        }
+        const auto key = readCborString(reader);
+        if ((groups & propertyGroup(key)) == 0) {
+            reader.next();
+        } else if (key == QLatin1String("id")) {
+            restoreId(data, readCborString(reader));
+        } else if (key == QLatin1String("iconType")) {
+            if (reader.isInteger()) {
+                data.iconType = static_cast<Machine::IconType>(reader.toInteger());
+                reader.next();
+            } else {
+                data.iconType = QCborValue::fromCbor(reader).toVariant().value<Machine::IconType>();
+            }
+        } else if (key == QLatin1String("iconName")) {
+            data.iconName = readCborString(reader);
+        } else if (key == QLatin1String("name")) {
+            data.name = readCborString(reader);
+        } else if (key == QLatin1String("summary")) {
+            data.summary = readCborString(reader);
+        } else if (key == QLatin1String("configFile")) {
+            data.configFile = readCborString(reader);
+        } else if (key == QLatin1String("startCommand")) {
+            data.startCommand = readCborString(reader);
+        } else if (key == QLatin1String("settingsCommand")) {
+            data.settingsCommand = readCborString(reader);
+        } else {
+            data.extraVariables.insert(key, QCborValue::fromCbor(reader).toVariant());
+        }
+    }
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+// Read properties in the groups from a JSON object and skip the others
+bool readJson(JsonStreamReader &reader, MachineData &data, int groups)
+{
+    if (reader.tokenType() != JsonStreamReader::StartObject) {
+        return false;
+    }
 
-    case Machine::IconFromTheme:
-        icon = QIcon::fromTheme(iconName);
-        break;
+    // Non-string values are converted like QVariant::toString() does
+    const auto readString = [&reader]() {
+        return reader.tokenType() == JsonStreamReader::String ? reader.text()
+                                                              : reader.readValue().toString();
+    };
+
+    clearProperties(data, groups);
+    while (reader.readNext() == JsonStreamReader::Name) {
+        const auto key = reader.text();
+        if (reader.readNext() == JsonStreamReader::Invalid) {
+            return false;
+        }
+        if ((groups & propertyGroup(key)) == 0) {
+            reader.skipValue();
+        } else if (key == QLatin1String("id")) {
+            restoreId(data, readString());
+        } else if (key == QLatin1String("iconType")) {
+            data.iconType = reader.readValue().value<Machine::IconType>();
+        } else if (key == QLatin1String("iconName")) {
+            data.iconName = readString();
+        } else if (key == QLatin1String("name")) {
+            data.name = readString();
+        } else if (key == QLatin1String("summary")) {
+            data.summary = readString();
+        } else if (key == QLatin1String("configFile")) {
+            data.configFile = readString();
+        } else if (key == QLatin1String("startCommand")) {
+            data.startCommand = readString();
+        } else if (key == QLatin1String("settingsCommand")) {
+            data.settingsCommand = readString();
+        } else {
+            data.extraVariables.insert(key, reader.readValue());
+        }
+    }
+    return reader.tokenType() == JsonStreamReader::EndObject;
+}
+
+} // namespace
 
-    case Machine::IconFromFile:
-        icon = QIcon(iconName);
-        break;
+/**
+ * @brief Construct empty data
+ *
+ * The ID is left null. A random ID is created when it is first read,
+ * see Machine::id().
+ */
+MachineData::MachineData() = default;
+
+/**
+ * @brief Copy the data for detaching
+ *
+ * A pending record is copied as it is, so that detaching does not
+ * force the copy to be loaded. If the *other* has no ID yet, it is
+ * created first, so that the copies have the same ID like copies of
+ * the machine before detaching.
+ *
+ * @param[in] other   Copy from this object
+ */
+MachineData::MachineData(const MachineData &other)
+    : QSharedData(other)
+{
+    QMutexLocker locker(&other.mutex);
+    if (other.id.isNull()) {
+        other.id = QUuid::createUuid();
     }
+    id = other.id;
+    idAssigned = other.idAssigned;
+    iconType = other.iconType;
+    iconName = other.iconName;
+    name = other.name;
+    summary = other.summary;
+    configFile = other.configFile;
+    startCommand = other.startCommand;
+    settingsCommand = other.settingsCommand;
+    extraVariables = other.extraVariables;
+    record = other.record;
+    recordIsCbor = other.recordIsCbor;
+}
+
+/**
+ * @brief Restore the deferred properties from the pending record
+ *
+ * Nothing is done if there is no pending record. The record was
+ * already checked by the lazy restore, so it is not expected to fail.
+ */
+void MachineData::load() const
+{
+    QMutexLocker locker(&mutex);
+    if (record.isNull()) {
+        return;
+    }
+
+    MachineData loaded;
+    bool ok = false;
+    if (recordIsCbor) {
+        QCborStreamReader reader(record);
+        ok = readCbor(reader, loaded, DeferredProperties);
+    } else {
+        JsonStreamReader reader(record);
+        reader.readNext();
+        ok = readJson(reader, loaded, DeferredProperties);
+    }
+    if (!ok) {
+        qCritical() << "Invalid machine record:" << record;
+    }
+
+    configFile = std::move(loaded.configFile);
+    startCommand = std::move(loaded.startCommand);
+    settingsCommand = std::move(loaded.settingsCommand);
+    extraVariables = std::move(loaded.extraVariables);
+    record = QByteArray();
 }
 
 // Machine
@@ -101,6 +348,51 @@ Machine::Machine(const QVariantMap &machine)
 
 Machine::~Machine() = default;
 
+/**
+ * @brief Machine ID getter
+ *
+ * A machine without a restored or set ID gets a random ID when the ID
+ * is read for the first time.
+ *
+ * @return Persistent ID of the machine
+ */
+QUuid Machine::id() const
+{
+    QMutexLocker locker(&data->mutex);
+    if (data->id.isNull()) {
+        data->id = QUuid::createUuid();
+    }
+    return data->id;
+}
+
+/**
+ * @brief Machine ID setter
+ *
+ * The ID is normally kept for the lifetime of the machine. A new ID is
+ * needed when a copy of a machine is added as a new machine.
+ *
+ * @param[in] id   New ID for the machine
+ */
+void Machine::setId(const QUuid &id)
+{
+    data->id = id;
+    data->idAssigned = true;
+}
+
+/**
+ * @brief Check if the ID was assigned instead of restored
+ *
+ * This is `true` when the restored data had no valid ID, so the machine
+ * has a random ID, or when the ID was changed with @ref setId. The ID then changes on every restore until
+ * the machine is saved again.
+ *
+ * @return `true` if the ID is not from the restored data
+ */
+bool Machine::idAssigned() const
+{
+    return data->idAssigned;
+}
+
 /**
  * @brief Icon type getter
  * @return Icon type for the machine
@@ -114,18 +406,24 @@ Machine::IconType Machine::iconType() const
  * @brief Icon name getter
  * @return Icon name for the machine
  */
-QString Machine::iconName() const
+const QString &Machine::iconName() const
 {
     return data->iconName;
 }
 
 /**
  * @brief Icon getter
+ *
+ * The icon is shared from the IconCache with other machines using the
+ * same icon.
+ *
+ * @pre This method must be called in the user interface thread.
+ *
  * @return Icon for the machine
  */
 QIcon Machine::icon() const
 {
-    return data->icon;
+    return IconCache::instance().icon(data->iconType, data->iconName);
 }
 
 /**
@@ -144,14 +442,13 @@ void Machine::setIcon(IconType type, const QString &name)
 {
     data->iconType = type;
     data->iconName = name;
-    data->loadIcon();
 }
 
 /**
  * @brief Machine name getter
  * @return Name for the machine
  */
-QString Machine::name() const
+const QString &Machine::name() const
 {
     return data->name;
 }
@@ -169,7 +466,7 @@ void Machine::setName(const QString &name)
  * @brief Machine summary getter
  * @return Summary for the machine
  */
-QString Machine::summary() const
+const QString &Machine::summary() const
 {
     return data->summary;
 }
@@ -189,6 +486,7 @@ void Machine::setSummary(const QString &summary)
  */
 QString Machine::configFile() const
 {
+    data->load();
     return data->configFile;
 }
 
@@ -198,6 +496,7 @@ QString Machine::configFile() const
  */
 void Machine::setConfigFile(const QString &configFile)
 {
+    data->load();
     data->configFile = configFile;
 }
 
@@ -207,6 +506,7 @@ void Machine::setConfigFile(const QString &configFile)
  */
 QString Machine::startCommand() const
 {
+    data->load();
     return data->startCommand;
 }
 
@@ -216,6 +516,7 @@ QString Machine::startCommand() const
  */
 void Machine::setStartCommand(const QString &startCommand)
 {
+    data->load();
     data->startCommand = startCommand;
 }
 
@@ -225,6 +526,7 @@ void Machine::setStartCommand(const QString &startCommand)
  */
 QString Machine::settingsCommand() const
 {
+    data->load();
     return data->settingsCommand;
 }
 
@@ -234,16 +536,54 @@ QString Machine::settingsCommand() const
  */
 void Machine::setSettingsCommand(const QString &settingsCommand)
 {
+    data->load();
     data->settingsCommand = settingsCommand;
 }
 
+/**
+ * @brief Extra variables getter
+ *
+ * Extra variables are properties in the machine configuration that are
+ * not known by the launcher. They are kept so that they are not lost
+ * when the machine is saved again.
+ *
+ * @return Extra variables by their names
+ */
+QVariantMap Machine::extraVariables() const
+{
+    data->load();
+    return data->extraVariables;
+}
+
+/**
+ * @brief Extra variable setter
+ *
+ * Extra variables are saved with the machine. They can be used for
+ * properties that only some parts of the launcher know about, such as
+ * the folder of the machine.
+ *
+ * @param[in] name    Name of the variable
+ * @param[in] value   New value, or invalid QVariant to remove the variable
+ */
+void Machine::setExtraVariable(const QString &name, const QVariant &value)
+{
+    data->load();
+    if (value.isValid()) {
+        data->extraVariables.insert(name, value);
+    } else {
+        data->extraVariables.remove(name);
+    }
+}
+
 /**
  * @brief Save machine data to the QVariantMap
  * @return QVariantMap with all machine properties, including extra properties found when the restore was called.
  */
 QVariantMap Machine::save() const
 {
+    data->load();
     auto map = data->extraVariables;
+    map["id"] = id().toString(QUuid::WithoutBraces);
     map["iconType"] = data->iconType;
     map["iconName"] = data->iconName;
     map["name"] = data->name;
@@ -259,12 +599,16 @@ QVariantMap Machine::save() const
  * 
  * Sets the machine's properties from the given *machine* map. Any extra properties are retained because they
  * may be from a newer version of the program or added by the user.
+ *
+ * If the map does not have a valid ID, the machine keeps its current ID.
  * 
  * @param[in] machine   Set properties from this map
  */
 void Machine::restore(const QVariantMap &machine)
 {
+    data->record = QByteArray();
     data->extraVariables = machine;
+    restoreId(*data, data->extraVariables.take("id").toString());
     setIcon(data->extraVariables.take("iconType").value<IconType>(),
             data->extraVariables.take("iconName").toString());
     data->name = data->extraVariables.take("name").toString();
@@ -274,6 +618,130 @@ void Machine::restore(const QVariantMap &machine)
     data->settingsCommand = data->extraVariables.take("settingsCommand").toString();
 }
 
+/**
+ * @brief Save machine data as a CBOR map
+ *
+ * The map has the same keys as the QVariantMap from @ref save(), and
+ * extra properties are written back as they were restored. The icon
+ * type is written as an integer.
+ *
+ * @param[in] writer   Write the map with this writer
+ */
+void Machine::save(QCborStreamWriter &writer) const
+{
+    data->load();
+    writer.startMap();
+    writer.append(QLatin1String("id"));
+    writer.append(id().toString(QUuid::WithoutBraces));
+    writer.append(QLatin1String("iconType"));
+    writer.append(static_cast<qint64>(data->iconType));
+    writer.append(QLatin1String("iconName"));
+    writer.append(data->iconName);
+    writer.append(QLatin1String("name"));
+    writer.append(data->name);
+    writer.append(QLatin1String("summary"));
+    writer.append(data->summary);
+    writer.append(QLatin1String("configFile"));
+    writer.append(data->configFile);
+    writer.append(QLatin1String("startCommand"));
+    writer.append(data->startCommand);
+    writer.append(QLatin1String("settingsCommand"));
+    writer.append(data->settingsCommand);
+    for (auto it = data->extraVariables.cbegin(); it != data->extraVariables.cend(); ++it) {
+        writer.append(it.key());
+        QCborValue::fromVariant(it.value()).toCbor(writer);
+    }
+    writer.endMap();
+}
+
+/**
+ * @brief Restore machine properties from a CBOR map
+ *
+ * Known properties are read straight from the stream into the machine
+ * without building an intermediate QVariantMap. Only the extra
+ * properties are converted into variants, so that they can be kept
+ * like with @ref restore(const QVariantMap &).
+ *
+ * @param[in] reader   Reader positioned at the start of the map
+ * @return `true` if the map was read, `false` if the stream is invalid
+ */
+bool Machine::restore(QCborStreamReader &reader)
+{
+    if (!readCbor(reader, *data, AllProperties)) {
+        return false;
+    }
+    data->record = QByteArray();
+    return true;
+}
+
+/**
+ * @brief Restore machine properties from a JSON object
+ *
+ * Known properties are read straight from the stream into the machine,
+ * like with @ref restore(QCborStreamReader &). Extra properties are
+ * converted into variants, so that they can be kept.
+ *
+ * @param[in] reader   Reader with the StartObject token as the current token
+ * @return `true` if the object was read, `false` if the JSON is invalid
+ */
+bool Machine::restore(JsonStreamReader &reader)
+{
+    if (!readJson(reader, *data, AllProperties)) {
+        return false;
+    }
+    data->record = QByteArray();
+    return true;
+}
+
+/**
+ * @brief Restore the list properties from a CBOR map and keep the rest for later
+ *
+ * Only the name, summary and icon key are read from the map. The map
+ * is copied as a raw record from the *source*, and the other
+ * properties are restored from the record the first time they are
+ * needed. This makes restoring a long machine list much faster, as
+ * most of the machines are never opened.
+ *
+ * @param[in] reader   Reader positioned at the start of the map
+ * @param[in] source   Bytes the *reader* reads from
+ * @return `true` if the map was read, `false` if the stream is invalid
+ */
+bool Machine::restoreLazy(QCborStreamReader &reader, const QByteArray &source)
+{
+    const auto begin = reader.currentOffset();
+    if (!readCbor(reader, *data, IndexProperties)) {
+        return false;
+    }
+    clearProperties(*data, DeferredProperties);
+    data->record = QByteArray(source.constData() + begin,
+                              static_cast<int>(reader.currentOffset() - begin));
+    data->recordIsCbor = true;
+    return true;
+}
+
+/**
+ * @brief Restore the list properties from a JSON object and keep the rest for later
+ *
+ * This works like @ref restoreLazy(QCborStreamReader &, const QByteArray &),
+ * but for JSON objects.
+ *
+ * @param[in] reader   Reader with the StartObject token as the current token
+ * @param[in] source   Bytes the *reader* reads from
+ * @return `true` if the object was read, `false` if the JSON is invalid
+ */
+bool Machine::restoreLazy(JsonStreamReader &reader, const QByteArray &source)
+{
+    const auto begin = reader.tokenOffset();
+    if (!readJson(reader, *data, IndexProperties)) {
+        return false;
+    }
+    clearProperties(*data, DeferredProperties);
+    data->record = QByteArray(source.constData() + begin,
+                              static_cast<int>(reader.offset() - begin));
+    data->recordIsCbor = false;
+    return true;
+}
+
 /**
  * @brief Assignment operator
  * @param[in] other   Use the same values as this object 
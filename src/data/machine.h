@@ -10,9 +10,13 @@
 #define MACHINE_H
 
 #include <QSharedDataPointer>
+#include <QUuid>
 #include <QVariantMap>
 
 class MachineData;
+class JsonStreamReader;
+class QCborStreamReader;
+class QCborStreamWriter;
 class QIcon;
 class QString;
 
@@ -22,6 +26,21 @@ class QString;
  * The Machine object collects information about how the emulated machine
  * is presented in the program and what is run when the user wants to start
  * the emulation or edit machine settings.
+ *
+ * A machine can also be restored lazily with @ref restoreLazy "restoreLazy()".
+ * Then only the properties shown in the machine list are restored
+ * immediately, and the rest are restored when they are first needed.
+ * Icons are not kept in the machine. All machines with the same icon
+ * share one QIcon from the IconCache.
+ *
+ * The properties shown in the machine list are returned as const
+ * references, so models can read them without copying strings. The
+ * references are valid until the machine is changed or destroyed.
+ *
+ * Each machine has a persistent @ref id "ID", which stays the same
+ * when the machine is changed, moved or saved. New machines get a
+ * random ID, and so do machines restored from configurations written
+ * before IDs were saved.
  */
 class Machine
 {
@@ -43,15 +62,19 @@ public:
     explicit Machine(const QVariantMap &machine);
     ~Machine();
 
+    [[nodiscard]] QUuid id() const;
+    void setId(const QUuid &id);
+    [[nodiscard]] bool idAssigned() const;
+
     [[nodiscard]] IconType iconType() const;
-    [[nodiscard]] QString iconName() const;
+    [[nodiscard]] const QString &iconName() const;
     [[nodiscard]] QIcon icon() const;
     void setIcon(IconType type, const QString &name = {});
 
-    [[nodiscard]] QString name() const;
+    [[nodiscard]] const QString &name() const;
     void setName(const QString &name);
 
-    [[nodiscard]] QString summary() const;
+    [[nodiscard]] const QString &summary() const;
     void setSummary(const QString &summary);
 
     [[nodiscard]] QString configFile() const;
@@ -63,8 +86,16 @@ public:
     [[nodiscard]] QString settingsCommand() const;
     void setSettingsCommand(const QString &settingsCommand);
 
+    [[nodiscard]] QVariantMap extraVariables() const;
+    void setExtraVariable(const QString &name, const QVariant &value);
+
     [[nodiscard]] QVariantMap save() const;
+    void save(QCborStreamWriter &writer) const;
     void restore(const QVariantMap &machine);
+    bool restore(QCborStreamReader &reader);
+    bool restore(JsonStreamReader &reader);
+    bool restoreLazy(QCborStreamReader &reader, const QByteArray &source);
+    bool restoreLazy(JsonStreamReader &reader, const QByteArray &source);
 
     Machine &operator=(const Machine &other);
     Machine &operator=(Machine &&other) noexcept;
@@ -0,0 +1,283 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinejournal.cpp
+ * @brief MachineJournal class implementation
+ */
+
+#include "machinejournal.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+
+/**
+ * @brief Version of the journal format written in the header
+ */
+constexpr auto JOURNAL_VERSION = 1;
+
+/**
+ * @brief Operation names used in the journal records
+ */
+const char *const OPERATION_NAMES[] = {"insert", "update", "remove", "move"};
+
+// Convert journal entry into a JSON record
+QJsonObject toRecord(const MachineJournal::Entry &entry)
+{
+    QJsonObject record;
+    record["op"] = OPERATION_NAMES[entry.operation];
+    record["row"] = entry.row;
+    switch (entry.operation) {
+    case MachineJournal::Insert:
+    case MachineJournal::Update: {
+        QJsonArray machines;
+        for (const auto &machine : entry.machines) {
+            machines.append(QJsonObject::fromVariantMap(machine.save()));
+        }
+        record["machines"] = machines;
+        break;
+    }
+    case MachineJournal::Remove:
+        record["count"] = entry.count;
+        break;
+    case MachineJournal::Move:
+        record["count"] = entry.count;
+        record["destination"] = entry.destination;
+        break;
+    }
+    return record;
+}
+
+// Apply one JSON record to the machine list, returns false for invalid records
+bool applyRecord(const QJsonObject &record, QList<Machine> &machines)
+{
+    const auto operation = record.value("op").toString();
+    const auto row = record.value("row").toInt(-1);
+    const auto size = static_cast<int>(machines.size());
+
+    if (operation == OPERATION_NAMES[MachineJournal::Insert]) {
+        if (row < 0 || row > size) {
+            return false;
+        }
+        auto position = row;
+        for (const auto &machine : record.value("machines").toArray()) {
+            machines.insert(position++, Machine(machine.toObject().toVariantMap()));
+        }
+        return true;
+    }
+
+    if (operation == OPERATION_NAMES[MachineJournal::Update]) {
+        const auto updated = record.value("machines").toArray();
+        if (row < 0 || row + updated.size() > size) {
+            return false;
+        }
+        auto position = row;
+        for (const auto &machine : updated) {
+            machines[position++] = Machine(machine.toObject().toVariantMap());
+        }
+        return true;
+    }
+
+    if (operation == OPERATION_NAMES[MachineJournal::Remove]) {
+        const auto count = record.value("count").toInt();
+        if (row < 0 || count <= 0 || row + count > size) {
+            return false;
+        }
+        for (auto i = 0; i < count; ++i) {
+            machines.removeAt(row);
+        }
+        return true;
+    }
+
+    if (operation == OPERATION_NAMES[MachineJournal::Move]) {
+        const auto count = record.value("count").toInt();
+        const auto destination = record.value("destination").toInt(-1);
+        if (row < 0 || count <= 0 || row + count > size || destination < 0 || destination > size
+            || (destination >= row && destination <= row + count)) {
+            return false;
+        }
+        const auto moved = machines.mid(row, count);
+        for (auto i = 0; i < count; ++i) {
+            machines.removeAt(row);
+        }
+        auto position = destination > row ? destination - count : destination;
+        for (const auto &machine : moved) {
+            machines.insert(position++, machine);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief Construct a journal for the given file
+ * @param[in] fileName   Path to the journal file
+ */
+MachineJournal::MachineJournal(const QString &fileName)
+    : mFileName(fileName)
+{}
+
+/**
+ * @brief Journal file name getter
+ * @return Path to the journal file
+ */
+QString MachineJournal::fileName() const
+{
+    return mFileName;
+}
+
+/**
+ * @brief Description of the last error
+ * @return Error message for the last failed operation
+ */
+QString MachineJournal::errorString() const
+{
+    return mErrorString;
+}
+
+/**
+ * @brief Current size of the journal file
+ * @return Journal size in bytes or zero if the journal does not exist
+ */
+qint64 MachineJournal::size() const
+{
+    return QFileInfo(mFileName).size();
+}
+
+/**
+ * @brief Append changes to the end of the journal
+ *
+ * All *entries* are converted into compact JSON records and written
+ * with a single write call. The journal must have been started with
+ * @ref reset before anything can be appended.
+ *
+ * @param[in] entries   Append these changes
+ * @return `true` if all entries were written, `false` otherwise
+ */
+bool MachineJournal::append(const QList<Entry> &entries)
+{
+    QFile file(mFileName);
+    if (!file.exists()) {
+        mErrorString = QStringLiteral("Journal has not been started");
+        return false;
+    }
+    if (!file.open(QFile::WriteOnly | QFile::Append)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+
+    QByteArray records;
+    for (const auto &entry : entries) {
+        records += QJsonDocument(toRecord(entry)).toJson(QJsonDocument::Compact);
+        records += '\n';
+    }
+    if (file.write(records) != records.size() || !file.flush()) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Replay the journal over the snapshot content
+ *
+ * The journal header must match the checksum of the *snapshot* bytes.
+ * Otherwise, the journal was started for some other snapshot, and
+ * nothing is applied.
+ *
+ * Records are applied in the order they were written. Replaying stops
+ * at the first record that cannot be read, which happens if the
+ * program stopped while appending. The records before it are kept in
+ * *machines*.
+ *
+ * @param[in] snapshot      Raw content of the snapshot file
+ * @param[in,out] machines  Machines restored from the snapshot
+ * @return `true` if the whole journal was applied, and it can be
+ *         appended to, `false` if the journal should be reset
+ */
+bool MachineJournal::replay(const QByteArray &snapshot, QList<Machine> &machines)
+{
+    QFile file(mFileName);
+    if (!file.exists()) {
+        mErrorString = QStringLiteral("Journal does not exist");
+        return false;
+    }
+    if (!file.open(QFile::ReadOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+
+    const auto header = QJsonDocument::fromJson(file.readLine()).object();
+    if (header.value("journal").toInt() != JOURNAL_VERSION
+        || header.value("snapshot").toString().toLatin1() != checksum(snapshot)) {
+        mErrorString = QStringLiteral("Journal does not belong to the snapshot");
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        const auto line = file.readLine();
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+        QJsonParseError error{};
+        const auto record = QJsonDocument::fromJson(line, &error);
+        if (error.error != QJsonParseError::NoError) {
+            mErrorString = QStringLiteral("Incomplete journal record: %1").arg(error.errorString());
+            return false;
+        }
+        if (!applyRecord(record.object(), machines)) {
+            mErrorString = QStringLiteral("Invalid journal record: %1")
+                               .arg(QString::fromUtf8(line.trimmed()));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Start a new empty journal for the *snapshot*
+ *
+ * The old journal is replaced atomically with a journal containing
+ * only the header for the given snapshot.
+ *
+ * @param[in] snapshot   Raw content of the snapshot that was just written
+ * @return `true` if the journal was reset, `false` otherwise
+ */
+bool MachineJournal::reset(const QByteArray &snapshot)
+{
+    QJsonObject header;
+    header["journal"] = JOURNAL_VERSION;
+    header["snapshot"] = QString::fromLatin1(checksum(snapshot));
+
+    QSaveFile file(mFileName);
+    if (!file.open(QFile::WriteOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    const auto content = QJsonDocument(header).toJson(QJsonDocument::Compact) + '\n';
+    if (file.write(content) != content.size() || !file.commit()) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checksum used to pair the journal with its snapshot
+ * @param[in] snapshot   Raw content of the snapshot file
+ * @return Hexadecimal SHA-1 checksum
+ */
+QByteArray MachineJournal::checksum(const QByteArray &snapshot)
+{
+    return QCryptographicHash::hash(snapshot, QCryptographicHash::Sha1).toHex();
+}
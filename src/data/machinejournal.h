@@ -0,0 +1,76 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinejournal.h
+ * @brief MachineJournal class definition
+ */
+
+#ifndef MACHINEJOURNAL_H
+#define MACHINEJOURNAL_H
+
+#include <QList>
+#include <QString>
+#include "machine.h"
+
+/**
+ * @brief Append-only change journal for the machine list
+ *
+ * The journal sits next to the machine list snapshot and records the
+ * changes made after the snapshot was written. Each change is written
+ * as one compact JSON object per line, so adding a change only costs
+ * the bytes of the changed records.
+ *
+ * The first line of the journal is a header with the checksum of the
+ * snapshot the journal was started from. When the snapshot is
+ * rewritten, the journal is reset with a new header. If the program
+ * stops between these two steps, the header no longer matches the
+ * snapshot, and the stale journal is ignored.
+ */
+class MachineJournal
+{
+public:
+    /**
+     * @brief Kind of change recorded in the journal
+     */
+    enum Operation {
+        Insert, /*!< @brief *machines* were inserted starting from *row* */
+        Update, /*!< @brief *machines* replaced the rows starting from *row* */
+        Remove, /*!< @brief *count* rows were removed starting from *row* */
+        Move    /*!< @brief *count* rows from *row* were moved before *destination* */
+    };
+
+    /**
+     * @brief Single change in the machine list
+     *
+     * Rows use the same meaning as the row signals of
+     * QAbstractItemModel, so that entries can be recorded straight
+     * from the model signals.
+     */
+    struct Entry
+    {
+        Operation operation{Update}; /*!< @brief What was done */
+        int row{0};                  /*!< @brief First row affected */
+        int count{0};                /*!< @brief Number of rows for Remove and Move */
+        int destination{0};          /*!< @brief Destination row for Move */
+        QList<Machine> machines;     /*!< @brief New content for Insert and Update */
+    };
+
+    explicit MachineJournal(const QString &fileName);
+
+    [[nodiscard]] QString fileName() const;
+    [[nodiscard]] QString errorString() const;
+    [[nodiscard]] qint64 size() const;
+
+    bool append(const QList<Entry> &entries);
+    bool replay(const QByteArray &snapshot, QList<Machine> &machines);
+    bool reset(const QByteArray &snapshot);
+
+    static QByteArray checksum(const QByteArray &snapshot);
+
+private:
+    QString mFileName;    /*!< @brief Path to the journal file */
+    QString mErrorString; /*!< @brief Description of the last error */
+};
+
+#endif // MACHINEJOURNAL_H
@@ -0,0 +1,405 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestore.cpp
+ * @brief MachineStore class implementation
+ */
+
+#include "machinestore.h"
+#include "jsonstreamreader.h"
+
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+/**
+ * @brief Journal size after which the store should be compacted
+ */
+constexpr qint64 COMPACTION_THRESHOLD = 512 * 1024;
+
+/**
+ * @brief Construct a store for the files in the *directory*
+ * @param[in] directory   Directory for the snapshot and journal files
+ * @param[in] format      Format for writing the snapshot
+ */
+MachineStore::MachineStore(const QString &directory, Format format)
+    : mDirectory(directory)
+    , mFormat(format)
+    , mJournal(directory + "/machines.journal")
+{}
+
+/**
+ * @brief Snapshot format getter
+ * @return Format used for writing the snapshot
+ */
+MachineStore::Format MachineStore::format() const
+{
+    return mFormat;
+}
+
+/**
+ * @brief Snapshot file name getter
+ * @return Path to the snapshot file for the store format
+ */
+QString MachineStore::snapshotFileName() const
+{
+    return snapshotFileName(mFormat);
+}
+
+/**
+ * @brief Journal file name getter
+ * @return Path to the `machines.journal` file
+ */
+QString MachineStore::journalFileName() const
+{
+    return mJournal.fileName();
+}
+
+/**
+ * @brief Description of the last error
+ * @return Error message for the last failed operation
+ */
+QString MachineStore::errorString() const
+{
+    return mErrorString;
+}
+
+/**
+ * @brief Check if the journal has grown past the compaction threshold
+ * @return `true` if the store should be compacted
+ */
+bool MachineStore::shouldCompact() const
+{
+    return mJournal.size() > COMPACTION_THRESHOLD;
+}
+
+/**
+ * @brief Check if machines are restored lazily
+ * @return `true` if lazy restore is used for the snapshot
+ */
+bool MachineStore::lazyRestore() const
+{
+    return mLazyRestore;
+}
+
+/**
+ * @brief Set if machines are restored lazily
+ *
+ * Lazy restore makes restoring faster for long machine lists. Machines
+ * changed in the journal are always restored completely.
+ *
+ * @param[in] lazy   Use lazy restore for the snapshot
+ */
+void MachineStore::setLazyRestore(bool lazy)
+{
+    mLazyRestore = lazy;
+}
+
+/**
+ * @brief Restore machines from the snapshot and the journal
+ *
+ * The snapshot is memory-mapped and read first. The journal is then
+ * replayed over the snapshot content. A missing snapshot is the same
+ * as an empty machine list.
+ *
+ * If the snapshot exists only in the other format, it is read from
+ * there. This happens when the store format has been changed.
+ *
+ * If the journal is missing, stale or partially unreadable, or the
+ * snapshot was not in the store format, the result is still usable,
+ * but *journalValid* is set to `false`. In that case, the store must
+ * be compacted before new changes can be appended.
+ *
+ * @param[out] machines       Restored machines
+ * @param[out] journalValid   Optional flag telling if the journal can be appended
+ * @return `true` if the snapshot was read, `false` otherwise
+ */
+bool MachineStore::restore(QList<Machine> &machines, bool *journalValid)
+{
+    if (journalValid != nullptr) {
+        *journalValid = false;
+    }
+    machines.clear();
+
+    auto format = mFormat;
+    const auto otherFormat = mFormat == JsonFormat ? CborFormat : JsonFormat;
+    if (!QFile::exists(snapshotFileName(format)) && QFile::exists(snapshotFileName(otherFormat))) {
+        format = otherFormat;
+    }
+
+    QFile file(snapshotFileName(format));
+    QByteArray snapshot;
+    if (file.exists()) {
+        if (!file.open(QFile::ReadOnly)) {
+            mErrorString = file.errorString();
+            return false;
+        }
+
+        // The mapping stays valid until the file is closed. Reading the
+        // file is the fallback for file systems that cannot be mapped.
+        const auto size = file.size();
+        const auto *mapped = size > 0 ? file.map(0, size) : nullptr;
+        if (mapped != nullptr) {
+            snapshot = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped),
+                                               static_cast<int>(size));
+        } else {
+            snapshot = file.readAll();
+        }
+
+        if (!readSnapshot(format, snapshot, machines)) {
+            return false;
+        }
+    }
+
+    auto replayed = mJournal.replay(snapshot, machines);
+    if (!replayed) {
+        qDebug() << "Machine journal not replayed:" << mJournal.errorString();
+    }
+    if (journalValid != nullptr) {
+        *journalValid = replayed && format == mFormat;
+    }
+    return true;
+}
+
+/**
+ * @brief Append changes to the journal
+ * @param[in] entries   Changes made after the last append
+ * @return `true` if changes were written, `false` otherwise
+ */
+bool MachineStore::append(const QList<MachineJournal::Entry> &entries)
+{
+    if (!mJournal.append(entries)) {
+        mErrorString = mJournal.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write a new snapshot and start the journal over
+ *
+ * The *machines* are saved in the store format and committed atomically
+ * to the snapshot file. The journal is then reset to match the new
+ * snapshot, and the snapshot in the other format is removed.
+ *
+ * @param[in] machines   Complete machine list
+ * @return `true` if compaction succeeded, `false` otherwise
+ */
+bool MachineStore::compact(const QList<Machine> &machines)
+{
+    const auto snapshot = mFormat == CborFormat ? toCbor(machines) : toJson(machines);
+
+    QDir().mkpath(mDirectory);
+    QSaveFile file(snapshotFileName());
+    if (!file.open(QFile::WriteOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    if (file.write(snapshot) != snapshot.size() || !file.commit()) {
+        mErrorString = file.errorString();
+        return false;
+    }
+
+    if (!mJournal.reset(snapshot)) {
+        mErrorString = mJournal.errorString();
+        return false;
+    }
+
+    QFile::remove(snapshotFileName(mFormat == JsonFormat ? CborFormat : JsonFormat));
+    return true;
+}
+
+/**
+ * @brief Move the store files aside
+ *
+ * The snapshot files in both formats and the journal are renamed with
+ * a `.bak` suffix and the current time, so earlier backups are kept.
+ * The store is empty afterwards. This is used when the files cannot be
+ * restored, so that they are not overwritten by the next snapshot.
+ *
+ * @return `true` if all existing files were moved, `false` otherwise
+ */
+bool MachineStore::backup()
+{
+    const auto suffix = QDateTime::currentDateTime().toString(".'bak'-yyyyMMdd-HHmmss");
+    for (const auto &fileName :
+         {snapshotFileName(JsonFormat), snapshotFileName(CborFormat), journalFileName()}) {
+        QFile file(fileName);
+        if (file.exists() && !file.rename(fileName + suffix)) {
+            mErrorString = file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Export machines into a JSON file
+ *
+ * The file has the same format as the `machines.json` snapshot.
+ *
+ * @param[in] fileName   Write machines to this file
+ * @param[in] machines   Machines to export
+ * @return `true` if the file was written, `false` otherwise
+ */
+bool MachineStore::exportJson(const QString &fileName, const QList<Machine> &machines)
+{
+    const auto json = toJson(machines);
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    if (file.write(json) != json.size() || !file.commit()) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Import machines from a JSON file
+ * @param[in] fileName   Read machines from this file
+ * @param[out] machines  Imported machines
+ * @return `true` if the file was read, `false` otherwise
+ */
+bool MachineStore::importJson(const QString &fileName, QList<Machine> &machines)
+{
+    machines.clear();
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    return readSnapshot(JsonFormat, file.readAll(), machines);
+}
+
+/**
+ * @brief Path to the snapshot file in the given *format*
+ * @param[in] format   Snapshot format
+ * @return Path to `machines.json` or `machines.cbor`
+ */
+QString MachineStore::snapshotFileName(Format format) const
+{
+    return mDirectory + (format == CborFormat ? "/machines.cbor" : "/machines.json");
+}
+
+/**
+ * @brief Read machines from the snapshot bytes
+ *
+ * Both formats are read with a stream reader, which fills the machines
+ * directly from the bytes. No document tree is built in between, so
+ * the memory needed grows only with the restored machines.
+ *
+ * With lazy restore, the raw record of each machine is copied from the
+ * *snapshot*, so the snapshot does not need to outlive the machines.
+ *
+ * @param[in] format     Format of the snapshot bytes
+ * @param[in] snapshot   Snapshot file content
+ * @param[out] machines  Machines read from the snapshot
+ * @return `true` if the snapshot was read, `false` otherwise
+ */
+bool MachineStore::readSnapshot(Format format, const QByteArray &snapshot, QList<Machine> &machines)
+{
+    if (format == JsonFormat) {
+        JsonStreamReader reader(snapshot);
+        if (reader.readNext() != JsonStreamReader::StartArray) {
+            mErrorString = QStringLiteral("JSON error: %1").arg(
+                reader.hasError() ? reader.errorString() : QStringLiteral("Machine list not found"));
+            return false;
+        }
+        while (reader.readNext() != JsonStreamReader::EndArray) {
+            if (reader.tokenType() == JsonStreamReader::StartObject) {
+                Machine machine;
+                const auto restored = mLazyRestore ? machine.restoreLazy(reader, snapshot)
+                                                   : machine.restore(reader);
+                if (restored) {
+                    machines.append(machine);
+                }
+            } else if (!reader.hasError()) {
+                qCritical() << "Invalid machine config:" << reader.readValue();
+            }
+            if (reader.hasError()) {
+                mErrorString = QStringLiteral("JSON error: %1").arg(reader.errorString());
+                return false;
+            }
+        }
+        if (reader.readNext() != JsonStreamReader::EndDocument) {
+            mErrorString = QStringLiteral("JSON error: %1").arg(reader.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    QCborStreamReader reader(reinterpret_cast<const quint8 *>(snapshot.constData()),
+                             snapshot.size());
+    if (reader.isTag() && quint64(reader.toTag()) == quint64(QCborKnownTags::Signature)) {
+        reader.next();
+    }
+    if (!reader.isArray() || !reader.enterContainer()) {
+        mErrorString = QStringLiteral("CBOR error: Machine list not found");
+        return false;
+    }
+    if (reader.isLengthKnown()) {
+        // Every machine takes at least one byte, so a corrupt length is not trusted further
+        const auto length = std::min<quint64>(reader.length(), quint64(snapshot.size()));
+        machines.reserve(static_cast<int>(length));
+    }
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        Machine machine;
+        const auto restored = mLazyRestore ? machine.restoreLazy(reader, snapshot)
+                                           : machine.restore(reader);
+        if (!restored) {
+            mErrorString = QStringLiteral("CBOR error: Invalid machine at %1").arg(machines.size());
+            return false;
+        }
+        machines.append(machine);
+    }
+    if (reader.lastError() != QCborError::NoError || !reader.leaveContainer()) {
+        mErrorString = QStringLiteral("CBOR error: %1").arg(reader.lastError().toString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Convert machines into a binary CBOR snapshot
+ * @param[in] machines   Machines to convert
+ * @return CBOR array of machine maps tagged with the CBOR signature
+ */
+QByteArray MachineStore::toCbor(const QList<Machine> &machines)
+{
+    QByteArray cbor;
+    QCborStreamWriter writer(&cbor);
+    writer.append(QCborKnownTags::Signature);
+    writer.startArray(machines.size());
+    for (const auto &machine : machines) {
+        machine.save(writer);
+    }
+    writer.endArray();
+    return cbor;
+}
+
+/**
+ * @brief Convert machines into an indented JSON snapshot
+ * @param[in] machines   Machines to convert
+ * @return JSON array of machine objects
+ */
+QByteArray MachineStore::toJson(const QList<Machine> &machines)
+{
+    QJsonArray array;
+    for (const auto &machine : machines) {
+        array.append(QJsonObject::fromVariantMap(machine.save()));
+    }
+    return QJsonDocument(array).toJson(QJsonDocument::Indented);
+}
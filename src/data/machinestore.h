@@ -0,0 +1,97 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestore.h
+ * @brief MachineStore class definition
+ */
+
+#ifndef MACHINESTORE_H
+#define MACHINESTORE_H
+
+#include <QList>
+#include <QString>
+#include "machine.h"
+#include "machinejournal.h"
+
+/**
+ * @brief Persistent storage for the machine list
+ *
+ * The store keeps the machine list in two files in the given directory:
+ *
+ * - The snapshot with the complete machine list. This is either
+ *   `machines.json` or the binary `machines.cbor`, depending on the
+ *   @ref Format "format" of the store.
+ * - `machines.journal` is the MachineJournal with changes made after
+ *   the snapshot was written.
+ *
+ * Small changes are appended to the journal. When the journal grows
+ * past @ref shouldCompact "the size threshold", the whole list is
+ * written as a new snapshot, and the journal is started over. This is
+ * called compaction.
+ *
+ * The snapshot file is memory-mapped for restoring, and machines are
+ * read from the mapped bytes. Only one snapshot format is kept at a
+ * time. If the snapshot exists only in the other format, it is
+ * restored from there, and compaction converts it into the format of
+ * the store.
+ *
+ * With @ref setLazyRestore "lazy restore", machines from the snapshot
+ * only get their list properties restored, and the rest is restored
+ * when it is first needed. See Machine::restoreLazy().
+ *
+ * If the files cannot be restored, they must not be overwritten with
+ * an incomplete list. @ref backup moves them aside, so that a new
+ * list can be started without losing the old files.
+ *
+ * JSON is also used for importing and exporting machines, regardless
+ * of the store format.
+ *
+ * Store objects only hold file names, so a copy of the store can be
+ * used for compaction in a background thread as long as nothing is
+ * appended at the same time.
+ */
+class MachineStore
+{
+public:
+    /**
+     * @brief Snapshot file formats
+     */
+    enum Format {
+        JsonFormat, /*!< @brief Indented JSON in `machines.json` */
+        CborFormat  /*!< @brief Binary CBOR in `machines.cbor` */
+    };
+
+    explicit MachineStore(const QString &directory, Format format = JsonFormat);
+
+    [[nodiscard]] Format format() const;
+    [[nodiscard]] QString snapshotFileName() const;
+    [[nodiscard]] QString journalFileName() const;
+    [[nodiscard]] QString errorString() const;
+    [[nodiscard]] bool shouldCompact() const;
+    [[nodiscard]] bool lazyRestore() const;
+    void setLazyRestore(bool lazy);
+
+    bool restore(QList<Machine> &machines, bool *journalValid = nullptr);
+    bool append(const QList<MachineJournal::Entry> &entries);
+    bool compact(const QList<Machine> &machines);
+    bool backup();
+
+    bool exportJson(const QString &fileName, const QList<Machine> &machines);
+    bool importJson(const QString &fileName, QList<Machine> &machines);
+
+private:
+    [[nodiscard]] QString snapshotFileName(Format format) const;
+    bool readSnapshot(Format format, const QByteArray &snapshot, QList<Machine> &machines);
+
+    static QByteArray toCbor(const QList<Machine> &machines);
+    static QByteArray toJson(const QList<Machine> &machines);
+
+    QString mDirectory;      /*!< @brief Directory where the store files are kept */
+    Format mFormat;          /*!< @brief Format for writing the snapshot */
+    bool mLazyRestore{};     /*!< @brief Restore machines from the snapshot lazily */
+    MachineJournal mJournal; /*!< @brief Journal for changes after the snapshot */
+    QString mErrorString;    /*!< @brief Description of the last error */
+};
+
+#endif // MACHINESTORE_H
@@ -0,0 +1,131 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestoreloader.cpp
+ * @brief MachineStoreLoader class implementation
+ */
+
+#include "machinestoreloader.h"
+
+#include <QThread>
+
+/**
+ * @brief Construct a loader for the *store*
+ *
+ * The loader does not start until @ref start is called.
+ *
+ * @param[in] store    Restore machines from this store
+ * @param[in] parent   Pointer to parent object
+ */
+MachineStoreLoader::MachineStoreLoader(const MachineStore &store, QObject *parent)
+    : QObject{parent}
+    , mStore{store}
+    , mThread{QThread::create([this]() { mRestored = mStore.restore(mMachines, &mJournalValid); })}
+{
+    mThread->setObjectName("MachineStoreLoader");
+    mThread->setParent(this);
+    connect(mThread, &QThread::finished, this, &MachineStoreLoader::onThreadFinished);
+}
+
+/**
+ * @brief Destroy the loader
+ *
+ * If the loader is still running, we wait for it to finish.
+ */
+MachineStoreLoader::~MachineStoreLoader()
+{
+    mThread->wait();
+}
+
+/**
+ * @brief Start reading the store in the loader thread
+ */
+void MachineStoreLoader::start()
+{
+    mThread->start();
+}
+
+/**
+ * @brief Block until the store has been read
+ *
+ * This makes the results available immediately. The @ref finished
+ * signal is emitted before this method returns, unless it was already
+ * emitted.
+ */
+void MachineStoreLoader::wait()
+{
+    mThread->wait();
+    onThreadFinished();
+}
+
+/**
+ * @brief Store getter
+ * @return The store where machines are restored from
+ */
+const MachineStore &MachineStoreLoader::store() const
+{
+    return mStore;
+}
+
+/**
+ * @brief Check if the results are available
+ * @return `true` after the @ref finished signal has been emitted
+ */
+bool MachineStoreLoader::isFinished() const
+{
+    return mFinished;
+}
+
+/**
+ * @brief Check if the store was restored
+ * @return `true` if the store was read without errors
+ * @see MachineStore::restore
+ */
+bool MachineStoreLoader::restored() const
+{
+    return mRestored;
+}
+
+/**
+ * @brief Check if the journal can be appended
+ * @return `false` if the store must be compacted before new changes are appended
+ * @see MachineStore::restore
+ */
+bool MachineStoreLoader::journalValid() const
+{
+    return mJournalValid;
+}
+
+/**
+ * @brief Restored machines getter
+ * @return Machines restored from the store
+ */
+QList<Machine> MachineStoreLoader::machines() const
+{
+    return mMachines;
+}
+
+/**
+ * @brief Description of the restore error
+ * @return Error message if the store was not restored
+ */
+QString MachineStoreLoader::errorString() const
+{
+    return mStore.errorString();
+}
+
+/**
+ * @brief The loader thread has finished
+ *
+ * This is run in the thread of the loader object, so the results can
+ * be handed over from here.
+ */
+void MachineStoreLoader::onThreadFinished()
+{
+    if (mFinished) {
+        return;
+    }
+    mFinished = true;
+    emit finished();
+}
@@ -0,0 +1,64 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestoreloader.h
+ * @brief MachineStoreLoader class definition
+ */
+
+#ifndef MACHINESTORELOADER_H
+#define MACHINESTORELOADER_H
+
+#include <QObject>
+#include "machinestore.h"
+
+class QThread;
+
+/**
+ * @brief Restores the machine store in a background thread
+ *
+ * The loader reads and parses the store while the program builds its
+ * user interface. It is started as early as possible, and the results
+ * are taken when the @ref finished signal is emitted.
+ *
+ * The results are written only by the loader thread before it
+ * finishes, and they must not be read before @ref isFinished returns
+ * `true`.
+ */
+class MachineStoreLoader : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineStoreLoader)
+
+public:
+    explicit MachineStoreLoader(const MachineStore &store, QObject *parent = nullptr);
+    ~MachineStoreLoader() override;
+
+    void start();
+    void wait();
+
+    [[nodiscard]] const MachineStore &store() const;
+    [[nodiscard]] bool isFinished() const;
+    [[nodiscard]] bool restored() const;
+    [[nodiscard]] bool journalValid() const;
+    [[nodiscard]] QList<Machine> machines() const;
+    [[nodiscard]] QString errorString() const;
+
+signals:
+    /**
+     * @brief The store has been read, and the results are available
+     */
+    void finished();
+
+private:
+    void onThreadFinished();
+
+    MachineStore mStore;       /*!< @brief Store used only in the loader thread */
+    QThread *mThread;          /*!< @brief Thread where the store is read */
+    bool mFinished{false};     /*!< @brief The results are available */
+    bool mRestored{false};     /*!< @brief The store was restored without errors */
+    bool mJournalValid{false}; /*!< @brief New changes can be appended to the journal */
+    QList<Machine> mMachines;  /*!< @brief Restored machines */
+};
+
+#endif // MACHINESTORELOADER_H
@@ -0,0 +1,168 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestorewriter.cpp
+ * @brief MachineStoreWriter class implementation
+ */
+
+#include "machinestorewriter.h"
+
+#include <QThread>
+#include <utility>
+
+/**
+ * @brief Construct a writer and start its thread
+ * @param[in] store    Write into this store
+ * @param[in] parent   Pointer to parent object
+ */
+MachineStoreWriter::MachineStoreWriter(const MachineStore &store, QObject *parent)
+    : QObject{parent}
+    , mStore{store}
+    , mThread{new QThread(this)}
+    , mContext{new QObject}
+{
+    mThread->setObjectName("MachineStoreWriter");
+    mContext->moveToThread(mThread);
+    mThread->start();
+}
+
+/**
+ * @brief Destroy the writer
+ *
+ * All queued work is written before the thread is stopped.
+ */
+MachineStoreWriter::~MachineStoreWriter()
+{
+    waitForIdle();
+    mThread->quit();
+    mThread->wait();
+    delete mContext;
+}
+
+/**
+ * @brief Check if the next save should be a snapshot
+ *
+ * This is `true` if the journal has grown past the compaction threshold,
+ * or if the previous write failed, and the journal cannot be used.
+ *
+ * @return `true` if a snapshot should be queued instead of changes
+ */
+bool MachineStoreWriter::compactionNeeded() const
+{
+    return mCompactionNeeded;
+}
+
+/**
+ * @brief Queue changes to be appended to the journal
+ * @param[in] entries   Changes recorded since the previous call
+ */
+void MachineStoreWriter::queueChanges(const QList<MachineJournal::Entry> &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&mMutex);
+    mEntries.append(entries);
+    schedule();
+}
+
+/**
+ * @brief Queue a snapshot of the whole machine list
+ *
+ * Any snapshot or changes still waiting in the queue are dropped, as
+ * the new snapshot already contains them.
+ *
+ * @param[in] machines   Complete machine list
+ */
+void MachineStoreWriter::queueSnapshot(const QList<Machine> &machines)
+{
+    QMutexLocker locker(&mMutex);
+    mHasSnapshot = true;
+    mSnapshot = machines;
+    mEntries.clear();
+    mCompactionNeeded = false;
+    schedule();
+}
+
+/**
+ * @brief Block until all queued work has been written
+ *
+ * This is used when the program is closing.
+ */
+void MachineStoreWriter::waitForIdle()
+{
+    QMutexLocker locker(&mMutex);
+    while (mScheduled) {
+        mIdle.wait(&mMutex);
+    }
+}
+
+/**
+ * @brief Write queued work
+ *
+ * @pre This method is run in the writer thread.
+ *
+ * The queue is taken in one piece under the lock, and the files are
+ * written without holding the lock, so that the user interface can
+ * queue more work meanwhile. The loop continues until the queue is
+ * empty.
+ */
+void MachineStoreWriter::process()
+{
+    while (true) {
+        QMutexLocker locker(&mMutex);
+        if (!mHasSnapshot && mEntries.isEmpty()) {
+            mScheduled = false;
+            mIdle.wakeAll();
+            return;
+        }
+        const auto hasSnapshot = std::exchange(mHasSnapshot, false);
+        const auto snapshot = std::exchange(mSnapshot, {});
+        const auto entries = std::exchange(mEntries, {});
+        locker.unlock();
+
+        if (hasSnapshot) {
+            if (!mStore.compact(snapshot)) {
+                mJournalBroken = true;
+                mCompactionNeeded = true;
+                emit saveFailed(mStore.errorString());
+                continue;
+            }
+            mJournalBroken = false;
+        }
+
+        if (!entries.isEmpty()) {
+            // Changes are already lost from a broken journal, and the
+            // next snapshot will contain them.
+            if (mJournalBroken) {
+                mCompactionNeeded = true;
+                continue;
+            }
+            if (!mStore.append(entries)) {
+                mJournalBroken = true;
+                mCompactionNeeded = true;
+                emit saveFailed(mStore.errorString());
+                continue;
+            }
+        }
+
+        if (mStore.shouldCompact()) {
+            mCompactionNeeded = true;
+        }
+        emit saved();
+    }
+}
+
+/**
+ * @brief Wake up the writer thread
+ * @pre mMutex must be locked by the caller.
+ */
+void MachineStoreWriter::schedule()
+{
+    if (mScheduled) {
+        return;
+    }
+    mScheduled = true;
+    QMetaObject::invokeMethod(mContext, [this]() { process(); }, Qt::QueuedConnection);
+}
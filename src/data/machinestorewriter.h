@@ -0,0 +1,101 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinestorewriter.h
+ * @brief MachineStoreWriter class definition
+ */
+
+#ifndef MACHINESTOREWRITER_H
+#define MACHINESTOREWRITER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+#include <atomic>
+#include "machinestore.h"
+
+class QThread;
+
+/**
+ * @brief Writes the machine store in a background thread
+ *
+ * The writer keeps all file operations of the MachineStore out of the
+ * user interface thread. The user interface queues either recorded
+ * changes or a snapshot of the whole machine list, and the writer
+ * thread saves them in the order they were queued.
+ *
+ * Queued work is merged while it waits for the writer thread:
+ *
+ * - A new snapshot supersedes a snapshot that has not been written yet.
+ * - A new snapshot also drops changes queued before it, because the
+ *   snapshot already contains them.
+ * - Changes queued after a snapshot are appended once it is written.
+ *
+ * The snapshot is a list of implicitly shared Machine objects, which
+ * is cheap to take from the model.
+ *
+ * The @ref saved signal is emitted after queued work has been written,
+ * and the @ref saveFailed signal is emitted if writing fails. After a
+ * failure, @ref compactionNeeded returns `true` until a snapshot has
+ * been written successfully.
+ */
+class MachineStoreWriter : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineStoreWriter)
+
+public:
+    explicit MachineStoreWriter(const MachineStore &store, QObject *parent = nullptr);
+    ~MachineStoreWriter() override;
+
+    [[nodiscard]] bool compactionNeeded() const;
+
+    void queueChanges(const QList<MachineJournal::Entry> &entries);
+    void queueSnapshot(const QList<Machine> &machines);
+    void waitForIdle();
+
+signals:
+    /**
+     * @brief Queued work was written to the store
+     */
+    void saved();
+
+    /**
+     * @brief Writing to the store failed
+     * @param[out] error   Description of the error
+     */
+    void saveFailed(const QString &error);
+
+private:
+    void process();
+    void schedule();
+
+    MachineStore mStore; /*!< @brief Store used only in the writer thread */
+    QThread *mThread;    /*!< @brief Thread where the store is written */
+    QObject *mContext;   /*!< @brief Object living in the writer thread for invoking work */
+
+    QMutex mMutex;                         /*!< @brief Protects the queued work */
+    QWaitCondition mIdle;                  /*!< @brief Signaled when all queued work is done */
+    bool mScheduled{false};                /*!< @brief Writer thread has work to do */
+    bool mHasSnapshot{false};              /*!< @brief mSnapshot is waiting to be written */
+    QList<Machine> mSnapshot;              /*!< @brief Snapshot waiting to be written */
+    QList<MachineJournal::Entry> mEntries; /*!< @brief Changes waiting to be appended */
+
+    /**
+     * @brief The next save should write a snapshot
+     *
+     * Set by the writer thread and read by the user interface thread.
+     */
+    std::atomic<bool> mCompactionNeeded{false};
+
+    /**
+     * @brief The journal cannot be appended
+     *
+     * Set when writing fails, and cleared when a snapshot is written.
+     * This is only used in the writer thread.
+     */
+    bool mJournalBroken{false};
+};
+
+#endif // MACHINESTOREWRITER_H
@@ -76,6 +76,25 @@ QString Settings::settingsCommand() const
     return mSettings->value("86box/settingsCommand", DEFAULT_SETTINGS_COMMAND).toString();
 }
 
+/**
+ * @brief Restores the format of the machine store
+ * @return Format for the machine list snapshot, JSON by default
+ */
+MachineStore::Format Settings::machineStoreFormat() const
+{
+    const auto format = mSettings->value("machines/storeFormat").toString();
+    return format == "cbor" ? MachineStore::CborFormat : MachineStore::JsonFormat;
+}
+
+/**
+ * @brief Restores if machines are restored lazily
+ * @return `true` if lazy machine restore is used, which is the default
+ */
+bool Settings::lazyMachineRestore() const
+{
+    return mSettings->value("machines/lazyRestore", true).toBool();
+}
+
 /**
  * @brief Configuration files directory
  * @return Returns path based on the operating system where the program's
@@ -146,3 +165,28 @@ void Settings::setSettingsCommand(const QString &value)
         mSettings->sync();
     }
 }
+
+/**
+ * @brief Write the format of the machine store to the settings
+ * @param[in] value   New format for the machine list snapshot
+ */
+void Settings::setMachineStoreFormat(MachineStore::Format value)
+{
+    if (machineStoreFormat() != value) {
+        mSettings->setValue("machines/storeFormat",
+                            value == MachineStore::CborFormat ? "cbor" : "json");
+        mSettings->sync();
+    }
+}
+
+/**
+ * @brief Write if machines are restored lazily to the settings
+ * @param[in] value   Use lazy machine restore
+ */
+void Settings::setLazyMachineRestore(bool value)
+{
+    if (lazyMachineRestore() != value) {
+        mSettings->setValue("machines/lazyRestore", value);
+        mSettings->sync();
+    }
+}
@@ -10,6 +10,7 @@
 #define SETTINGS_H
 
 #include <QObject>
+#include "machinestore.h"
 
 class QSettings;
 
@@ -35,6 +36,9 @@ public:
     [[nodiscard]] QString startCommand() const;
     [[nodiscard]] QString settingsCommand() const;
 
+    [[nodiscard]] MachineStore::Format machineStoreFormat() const;
+    [[nodiscard]] bool lazyMachineRestore() const;
+
     static QString configHome();
 
 public slots:
@@ -46,6 +50,9 @@ public slots:
     void setSettingsCommand(const QString &);
     void setStartCommand(const QString &);
 
+    void setMachineStoreFormat(MachineStore::Format);
+    void setLazyMachineRestore(bool);
+
 private:
     QSettings *mSettings{}; /*!< @brief Settings are handled by this object */
 };
@@ -0,0 +1,514 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  sqlmachinestore.cpp
+ * @brief SqlMachineStore class implementation
+ */
+
+#include "sqlmachinestore.h"
+
+#include <QAtomicInt>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+
+namespace {
+
+/**
+ * @brief Counter for unique connection names
+ */
+QAtomicInt connectionCounter;
+
+/**
+ * @brief Statements creating the tables, indexes and triggers for machines
+ */
+const char *const SCHEMA[] = {
+    "CREATE TABLE IF NOT EXISTS machines ("
+    "id INTEGER PRIMARY KEY, position INTEGER NOT NULL, "
+    "name TEXT NOT NULL, summary TEXT NOT NULL, record BLOB NOT NULL)",
+    "CREATE INDEX IF NOT EXISTS machines_position ON machines (position)",
+};
+
+/**
+ * @brief Statements creating the full-text index and the triggers keeping it up to date
+ */
+const char *const FTS_SCHEMA[] = {
+    "CREATE VIRTUAL TABLE IF NOT EXISTS machines_fts "
+    "USING fts5(name, summary, content='machines', content_rowid='id')",
+    "CREATE TRIGGER IF NOT EXISTS machines_fts_insert AFTER INSERT ON machines BEGIN "
+    "INSERT INTO machines_fts (rowid, name, summary) VALUES (new.id, new.name, new.summary); "
+    "END",
+    "CREATE TRIGGER IF NOT EXISTS machines_fts_delete AFTER DELETE ON machines BEGIN "
+    "INSERT INTO machines_fts (machines_fts, rowid, name, summary) "
+    "VALUES ('delete', old.id, old.name, old.summary); "
+    "END",
+    "CREATE TRIGGER IF NOT EXISTS machines_fts_update AFTER UPDATE ON machines BEGIN "
+    "INSERT INTO machines_fts (machines_fts, rowid, name, summary) "
+    "VALUES ('delete', old.id, old.name, old.summary); "
+    "INSERT INTO machines_fts (rowid, name, summary) VALUES (new.id, new.name, new.summary); "
+    "END",
+};
+
+/**
+ * @brief Escape LIKE wildcards in the *text*
+ * @param[in] text   Text to escape
+ * @return Text where `%`, `_` and `\` are escaped with `\`
+ */
+QString escapeLike(QString text)
+{
+    text.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    text.replace(QLatin1Char('%'), QLatin1String("\\%"));
+    text.replace(QLatin1Char('_'), QLatin1String("\\_"));
+    return text;
+}
+
+/**
+ * @brief Split the search text into words
+ * @param[in] search   Search text from the user
+ * @return Words separated by whitespace
+ */
+QStringList searchWords(const QString &search)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return search.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+#else
+    return search.split(QLatin1Char(' '), QString::SkipEmptyParts);
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief Construct a store for the database *fileName*
+ *
+ * The database is not opened until @ref open is called.
+ *
+ * @param[in] fileName   Path to the SQLite database file
+ */
+SqlMachineStore::SqlMachineStore(const QString &fileName)
+    : mFileName(fileName)
+    , mConnectionName(QStringLiteral("SqlMachineStore-%1").arg(connectionCounter.fetchAndAddRelaxed(1)))
+{}
+
+/**
+ * @brief Close the database connection
+ */
+SqlMachineStore::~SqlMachineStore()
+{
+    close();
+}
+
+/**
+ * @brief Database file name getter
+ * @return Path to the SQLite database file
+ */
+QString SqlMachineStore::fileName() const
+{
+    return mFileName;
+}
+
+/**
+ * @brief Description of the last error
+ * @return Error message for the last failed operation
+ */
+QString SqlMachineStore::errorString() const
+{
+    return mErrorString;
+}
+
+/**
+ * @brief Check if the database is open
+ * @return `true` if the store can be used
+ */
+bool SqlMachineStore::isOpen() const
+{
+    return mDatabase.isOpen();
+}
+
+/**
+ * @brief Check if searching uses the full-text index
+ * @return `true` if FTS5 is available, `false` if searching scans the table
+ */
+bool SqlMachineStore::hasFullTextSearch() const
+{
+    return mHasFts;
+}
+
+/**
+ * @brief Open the database and create the tables if needed
+ * @return `true` if the database is ready, `false` otherwise
+ */
+bool SqlMachineStore::open()
+{
+    if (isOpen()) {
+        return true;
+    }
+    mDatabase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), mConnectionName);
+    mDatabase.setDatabaseName(mFileName);
+    if (!mDatabase.open()) {
+        raiseError(mDatabase.lastError().text());
+        close();
+        return false;
+    }
+    if (!createSchema()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the database connection
+ */
+void SqlMachineStore::close()
+{
+    if (!mDatabase.isValid()) {
+        return;
+    }
+    mDatabase.close();
+    mDatabase = QSqlDatabase();
+    QSqlDatabase::removeDatabase(mConnectionName);
+    mHasFts = false;
+}
+
+/**
+ * @brief Read a page of machines in the list order
+ *
+ * Pages are read by position rather than by offset, so reading a page
+ * takes the same time regardless of how far in the list it is.
+ *
+ * @param[in] search          Only read machines whose name or summary has all words of the search,
+ *                            or all machines if empty
+ * @param[in] afterPosition   Read machines after this position, or -1 from the start
+ * @param[in] limit           Maximum number of machines to read
+ * @param[out] entries        Machines read from the database
+ * @return `true` if the page was read, `false` otherwise
+ */
+bool SqlMachineStore::fetch(const QString &search,
+                            qint64 afterPosition,
+                            int limit,
+                            QList<Entry> &entries)
+{
+    entries.clear();
+    QSqlQuery query(mDatabase);
+    const auto words = searchWords(search);
+    if (words.isEmpty()) {
+        query.prepare("SELECT id, position, record FROM machines "
+                      "WHERE position > ? ORDER BY position LIMIT ?");
+    } else if (mHasFts) {
+        query.prepare("SELECT machines.id, machines.position, machines.record FROM machines "
+                      "JOIN machines_fts ON machines_fts.rowid = machines.id "
+                      "WHERE machines_fts MATCH ? AND machines.position > ? "
+                      "ORDER BY machines.position LIMIT ?");
+        query.addBindValue(ftsQuery(search));
+    } else {
+        // Word prefixes like with FTS5, where a word starts the text or follows a space
+        QStringList conditions;
+        for (int i = 0; i < words.size(); ++i) {
+            conditions.append("(name LIKE ? ESCAPE '\\' OR name LIKE ? ESCAPE '\\' "
+                              "OR summary LIKE ? ESCAPE '\\' OR summary LIKE ? ESCAPE '\\')");
+        }
+        query.prepare(QStringLiteral("SELECT id, position, record FROM machines "
+                                     "WHERE %1 AND position > ? ORDER BY position LIMIT ?")
+                          .arg(conditions.join(QLatin1String(" AND "))));
+        for (const auto &word : words) {
+            const QString atStart = escapeLike(word) + QLatin1Char('%');
+            const QString afterSpace = QLatin1String("% ") + atStart;
+            query.addBindValue(atStart);
+            query.addBindValue(afterSpace);
+            query.addBindValue(atStart);
+            query.addBindValue(afterSpace);
+        }
+    }
+    query.addBindValue(afterPosition);
+    query.addBindValue(limit);
+    query.setForwardOnly(true);
+    if (!query.exec()) {
+        return raiseError(query.lastError().text());
+    }
+
+    while (query.next()) {
+        Entry entry;
+        entry.id = query.value(0).toLongLong();
+        entry.position = query.value(1).toLongLong();
+        if (!fromRecord(query.value(2).toByteArray(), entry.machine)) {
+            qCritical() << "Invalid machine record in database:" << entry.id;
+        }
+        entries.append(entry);
+    }
+    return true;
+}
+
+/**
+ * @brief Read one machine
+ * @param[in] id        Row id of the machine
+ * @param[out] machine  Machine restored from the record
+ * @return `true` if the machine was read, `false` otherwise
+ */
+bool SqlMachineStore::machine(qint64 id, Machine &machine)
+{
+    QSqlQuery query(mDatabase);
+    query.prepare("SELECT record FROM machines WHERE id = ?");
+    query.addBindValue(id);
+    if (!query.exec()) {
+        return raiseError(query.lastError().text());
+    }
+    if (!query.next()) {
+        return raiseError(QStringLiteral("Machine %1 not found").arg(id));
+    }
+    if (!fromRecord(query.value(0).toByteArray(), machine)) {
+        return raiseError(QStringLiteral("Invalid machine record %1").arg(id));
+    }
+    return true;
+}
+
+/**
+ * @brief Read all machines in the list order
+ *
+ * This is meant for exporting the machines, and it reads the whole
+ * list into memory.
+ *
+ * @param[out] machines   All machines in the database
+ * @return `true` if machines were read, `false` otherwise
+ */
+bool SqlMachineStore::machines(QList<Machine> &machines)
+{
+    machines.clear();
+    QSqlQuery query(mDatabase);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT record FROM machines ORDER BY position")) {
+        return raiseError(query.lastError().text());
+    }
+    while (query.next()) {
+        Machine machine;
+        if (fromRecord(query.value(0).toByteArray(), machine)) {
+            machines.append(machine);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Add machines to the end of the list
+ * @param[in] machines   Machines to add
+ * @param[out] ids       Optional row ids of the added machines
+ * @return `true` if machines were added, `false` otherwise
+ */
+bool SqlMachineStore::append(const QList<Machine> &machines, QList<qint64> *ids)
+{
+    if (!mDatabase.transaction()) {
+        return raiseError(mDatabase.lastError().text());
+    }
+    if (!insert(machines, ids) || !mDatabase.commit()) {
+        mDatabase.rollback();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Replace one machine
+ * @param[in] id        Row id of the machine
+ * @param[in] machine   New content for the machine
+ * @return `true` if the machine was replaced, `false` otherwise
+ */
+bool SqlMachineStore::update(qint64 id, const Machine &machine)
+{
+    QSqlQuery query(mDatabase);
+    query.prepare("UPDATE machines SET name = ?, summary = ?, record = ? WHERE id = ?");
+    query.addBindValue(machine.name());
+    query.addBindValue(machine.summary());
+    query.addBindValue(toRecord(machine));
+    query.addBindValue(id);
+    if (!query.exec()) {
+        return raiseError(query.lastError().text());
+    }
+    return true;
+}
+
+/**
+ * @brief Remove machines
+ * @param[in] ids   Row ids of the machines to remove
+ * @return `true` if machines were removed, `false` otherwise
+ */
+bool SqlMachineStore::remove(const QList<qint64> &ids)
+{
+    if (!mDatabase.transaction()) {
+        return raiseError(mDatabase.lastError().text());
+    }
+    QSqlQuery query(mDatabase);
+    query.prepare("DELETE FROM machines WHERE id = ?");
+    for (const auto id : ids) {
+        query.addBindValue(id);
+        if (!query.exec()) {
+            raiseError(query.lastError().text());
+            mDatabase.rollback();
+            return false;
+        }
+    }
+    if (!mDatabase.commit()) {
+        return raiseError(mDatabase.lastError().text());
+    }
+    return true;
+}
+
+/**
+ * @brief Replace all machines
+ *
+ * This is used for importing a machine list, such as the content of
+ * `machines.json`. Everything is replaced in one transaction.
+ *
+ * @param[in] machines   New machine list
+ * @return `true` if machines were replaced, `false` otherwise
+ */
+bool SqlMachineStore::replaceAll(const QList<Machine> &machines)
+{
+    if (!mDatabase.transaction()) {
+        return raiseError(mDatabase.lastError().text());
+    }
+    QSqlQuery query(mDatabase);
+    if (!query.exec("DELETE FROM machines")) {
+        raiseError(query.lastError().text());
+        mDatabase.rollback();
+        return false;
+    }
+    if (!insert(machines, nullptr) || !mDatabase.commit()) {
+        mDatabase.rollback();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Create the tables and the full-text index
+ *
+ * Failing to create the full-text index is not an error. Searching
+ * then works without the index.
+ *
+ * The index is filled by triggers when machines change. When the index
+ * is created for a database that already has machines, it is rebuilt
+ * from the machine table once.
+ *
+ * @return `true` if the machine table is ready, `false` otherwise
+ */
+bool SqlMachineStore::createSchema()
+{
+    QSqlQuery query(mDatabase);
+    for (const auto *statement : SCHEMA) {
+        if (!query.exec(statement)) {
+            return raiseError(query.lastError().text());
+        }
+    }
+
+    // A new index must be filled with the machines already in the table
+    const auto ftsExists = query.exec("SELECT 1 FROM sqlite_master "
+                                      "WHERE type = 'table' AND name = 'machines_fts'")
+                           && query.next();
+
+    mHasFts = true;
+    for (const auto *statement : FTS_SCHEMA) {
+        if (!query.exec(statement)) {
+            qDebug() << "Full-text search not available:" << query.lastError().text();
+            mHasFts = false;
+            break;
+        }
+    }
+    if (mHasFts && !ftsExists
+        && !query.exec("INSERT INTO machines_fts (machines_fts) VALUES ('rebuild')")) {
+        qDebug() << "Full-text index not rebuilt:" << query.lastError().text();
+        mHasFts = false;
+    }
+    return true;
+}
+
+/**
+ * @brief Insert machines after the last position
+ *
+ * The caller takes care of the transaction.
+ *
+ * @param[in] machines   Machines to insert
+ * @param[out] ids       Optional row ids of the inserted machines
+ * @return `true` if machines were inserted, `false` otherwise
+ */
+bool SqlMachineStore::insert(const QList<Machine> &machines, QList<qint64> *ids)
+{
+    QSqlQuery query(mDatabase);
+    if (!query.exec("SELECT COALESCE(MAX(position), -1) FROM machines") || !query.next()) {
+        return raiseError(query.lastError().text());
+    }
+    auto position = query.value(0).toLongLong();
+
+    query.prepare("INSERT INTO machines (position, name, summary, record) VALUES (?, ?, ?, ?)");
+    for (const auto &machine : machines) {
+        query.addBindValue(++position);
+        query.addBindValue(machine.name());
+        query.addBindValue(machine.summary());
+        query.addBindValue(toRecord(machine));
+        if (!query.exec()) {
+            return raiseError(query.lastError().text());
+        }
+        if (ids != nullptr) {
+            ids->append(query.lastInsertId().toLongLong());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Set the error string
+ * @param[in] error   Description of the error
+ * @return Always `false`, so that this can be returned from a failing function
+ */
+bool SqlMachineStore::raiseError(const QString &error)
+{
+    mErrorString = QStringLiteral("Database error: %1").arg(error);
+    return false;
+}
+
+/**
+ * @brief Convert the search text into an FTS5 query
+ *
+ * Each word is quoted, so that the user cannot write FTS5 syntax by
+ * accident, and matches as a prefix. All words must match.
+ *
+ * @param[in] search   Search text from the user
+ * @return FTS5 query string
+ */
+QString SqlMachineStore::ftsQuery(const QString &search)
+{
+    QStringList terms;
+    for (auto word : searchWords(search)) {
+        word.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        terms.append(QStringLiteral("\"%1\"*").arg(word));
+    }
+    return terms.join(QLatin1Char(' '));
+}
+
+/**
+ * @brief Convert a machine into a database record
+ * @param[in] machine   Machine to convert
+ * @return CBOR map written with Machine::save()
+ */
+QByteArray SqlMachineStore::toRecord(const Machine &machine)
+{
+    QByteArray record;
+    QCborStreamWriter writer(&record);
+    machine.save(writer);
+    return record;
+}
+
+/**
+ * @brief Restore a machine from a database record
+ * @param[in] record    CBOR map written with @ref toRecord
+ * @param[out] machine  Machine with the list properties restored
+ * @return `true` if the record was valid, `false` otherwise
+ */
+bool SqlMachineStore::fromRecord(const QByteArray &record, Machine &machine)
+{
+    QCborStreamReader reader(record);
+    return machine.restoreLazy(reader, record);
+}
@@ -0,0 +1,90 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  sqlmachinestore.h
+ * @brief SqlMachineStore class definition
+ */
+
+#ifndef SQLMACHINESTORE_H
+#define SQLMACHINESTORE_H
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include "machine.h"
+
+/**
+ * @brief Machine list kept in an SQLite database
+ *
+ * This is an alternative to MachineStore for very large machine
+ * lists. Machines are not read into memory as a whole. Instead, they
+ * are read in pages ordered by their position in the list, and only
+ * the pages that are needed are read.
+ *
+ * Each machine is kept as a CBOR record in the same format as in the
+ * `machines.cbor` snapshot, so extra variables are kept. Machines are
+ * read from the records with Machine::restoreLazy(), so reading a page
+ * only restores the properties shown in the machine list.
+ *
+ * Names and summaries are indexed with an FTS5 full-text index, and a
+ * search matches words starting with each search word. If the SQLite
+ * library was built without FTS5, searching falls back to LIKE
+ * patterns without an index. They also match word starts, but only
+ * after spaces, while FTS5 also splits words at punctuation.
+ *
+ * The database connection can only be used in the thread where the
+ * store was opened.
+ */
+class SqlMachineStore
+{
+    Q_DISABLE_COPY_MOVE(SqlMachineStore)
+
+public:
+    /**
+     * @brief Machine read from the database
+     */
+    struct Entry
+    {
+        qint64 id{};       /*!< @brief Row id of the machine, stays the same while the machine exists */
+        qint64 position{}; /*!< @brief Position of the machine in the list order */
+        Machine machine;   /*!< @brief Machine restored from the record */
+    };
+
+    explicit SqlMachineStore(const QString &fileName);
+    ~SqlMachineStore();
+
+    [[nodiscard]] QString fileName() const;
+    [[nodiscard]] QString errorString() const;
+    [[nodiscard]] bool isOpen() const;
+    [[nodiscard]] bool hasFullTextSearch() const;
+
+    bool open();
+    void close();
+
+    bool fetch(const QString &search, qint64 afterPosition, int limit, QList<Entry> &entries);
+    bool machine(qint64 id, Machine &machine);
+    bool machines(QList<Machine> &machines);
+
+    bool append(const QList<Machine> &machines, QList<qint64> *ids = nullptr);
+    bool update(qint64 id, const Machine &machine);
+    bool remove(const QList<qint64> &ids);
+    bool replaceAll(const QList<Machine> &machines);
+
+private:
+    bool createSchema();
+    bool insert(const QList<Machine> &machines, QList<qint64> *ids);
+    bool raiseError(const QString &error);
+
+    static QString ftsQuery(const QString &search);
+    static QByteArray toRecord(const Machine &machine);
+    static bool fromRecord(const QByteArray &record, Machine &machine);
+
+    QString mFileName;       /*!< @brief Path to the database file */
+    QString mConnectionName; /*!< @brief Unique name for the database connection */
+    QSqlDatabase mDatabase;  /*!< @brief Database connection while the store is open */
+    bool mHasFts{};          /*!< @brief The full-text index is available */
+    QString mErrorString;    /*!< @brief Description of the last error */
+};
+
+#endif // SQLMACHINESTORE_H
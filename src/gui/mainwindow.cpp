@@ -9,23 +9,34 @@
 #include "mainwindow.h"
 #include "machinedialog.h"
 #include "preferencesdialog.h"
+#include "quicklaunchdialog.h"
 
+#include "data/machinestoreloader.h"
+#include "data/machinestorewriter.h"
 #include "data/settings.h"
+#include "mvc/machinecommands.h"
 #include "mvc/machinedelegate.h"
+#include "mvc/machinefiltermodel.h"
 #include "mvc/machinelistmodel.h"
-#include "utils/formatter.h"
+#include "mvc/machinelistview.h"
+#include "utils/formattercache.h"
 
 #include <QDir>
 #include <QFile>
+#include <QFileDialog>
 #include <QHBoxLayout>
-#include <QJsonDocument>
+#include <QLabel>
+#include <QLineEdit>
 #include <QListView>
 #include <QMenu>
 #include <QMessageBox>
 #include <QProcess>
+#include <QShortcut>
+#include <QStackedWidget>
 #include <QTimer>
 #include <QToolBar>
 #include <QToolButton>
+#include <QUndoStack>
 #include <QVBoxLayout>
 
 /**
@@ -33,18 +44,55 @@
  */
 const QSize TOOL_BAR_ICON_SIZE = {48, 48};
 
+/**
+ * @brief Variable names available in the start and settings commands
+ *
+ * The commands are bound to these variables, and variablesForMachine()
+ * gives the values in the same order.
+ */
+const QStringList COMMAND_VARIABLES = {"86box", "config", "name"};
+
+/**
+ * @brief Number of machines from which the list uses uniform row layout
+ *
+ * Below half of this, the normal layout is used again.
+ */
+const int UNIFORM_LAYOUT_THRESHOLD = 1000;
+
+/**
+ * @brief Number of items laid out at a time in uniform row layout
+ */
+const int LAYOUT_BATCH_SIZE = 500;
+
 /**
  * @brief Construct the main window widget
+ *
+ * The *loader* should already be running, so that machines are read
+ * while the window is set up. The list view shows a loading message
+ * until the loader has finished. The loader is borrowed, and it must
+ * outlive the main window.
+ *
+ * @param[in] loader   Loader restoring machines from the store
  * @param[in] parent   Pointer to the parent widget
  * @note In our case there is no parent widget, so main window is
  *       constructed using nullptr for parent.
  */
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(MachineStoreLoader *loader, QWidget *parent)
     : QWidget{parent}
     , mSaveTimer{new QTimer(this)}
+    , mStore{Settings::configHome()}
+    , mLoader{loader}
 {
     setupUi();
-    restoreMachines();
+    setupStore();
+
+    // Record changes for the journal
+    connect(mVmModel, &MachineListModel::dataChanged, this, &MainWindow::onMachinesChanged);
+    connect(mVmModel, &MachineListModel::rowsInserted, this, &MainWindow::onMachinesInserted);
+    connect(mVmModel, &MachineListModel::rowsMoved, this, &MainWindow::onMachinesMoved);
+    connect(mVmModel, &MachineListModel::rowsRemoved, this, &MainWindow::onMachinesRemoved);
+    connect(mVmModel, &MachineListModel::modelReset, this, &MainWindow::onMachinesReset);
+    connect(mVmModel, &MachineListModel::layoutChanged, this, &MainWindow::onMachinesReordered);
 
     // We use a timer so that we can save model content when all changes to the model have been made
     const auto saveAfterNoChangesForMsec = 200;
@@ -52,18 +100,43 @@ MainWindow::MainWindow(QWidget *parent)
     mSaveTimer->setInterval(saveAfterNoChangesForMsec);
     connect(mVmModel, &MachineListModel::modelChanged, mSaveTimer, qOverload<>(&QTimer::start));
     connect(mSaveTimer, &QTimer::timeout, this, &MainWindow::saveMachines);
+
+    // Quick launch candidates follow the model
+    connect(mVmModel,
+            &MachineListModel::modelChanged,
+            this,
+            &MainWindow::updateQuickLaunchCandidates);
+
+    // Loaded machines are handed to the model when the loader finishes
+    connect(mLoader, &MachineStoreLoader::finished, this, &MainWindow::onMachinesLoaded);
+    if (mLoader->isFinished()) {
+        onMachinesLoaded();
+    }
 }
 
 /**
  * @brief This event is triggered when the user closes the main window
  * 
  * We use this event to save the main window geometry into settings.
+ * Changes still waiting for the save timer are queued, and we wait
+ * for the store writer to write everything. If machines are still
+ * loading, we wait for the loader first.
  * 
  * @param[in] event   Event information object
  */
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     mSettings->setMainWindowGeometry(saveGeometry());
+
+    // Machines added while loading must not be lost
+    if (mLoading) {
+        mLoader->wait();
+    }
+
+    mSaveTimer->stop();
+    saveMachines();
+    mStoreWriter->waitForIdle();
+
     QWidget::closeEvent(event);
 }
 
@@ -84,16 +157,73 @@ void MainWindow::onAddClicked()
 
     if (dialog.exec() == MachineDialog::Accepted) {
         newMachine = dialog.machine();
-        mVmModel->addMachine(newMachine);
+        const auto row = mVmModel->rowCount({});
+        mUndoStack->push(new InsertMachinesCommand(mVmModel, {row}, {newMachine}));
 
         // Automatically open settings dialog if config file does not exist
         if (!QFile::exists(newMachine.configFile())) {
-            mVmView->setCurrentIndex(mVmModel->index(mVmModel->rowCount({}) - 1));
+            mSearchEdit->clear();
+            mVmView->setCurrentIndex(
+                mFilterModel->mapFromSource(mVmModel->index(row)));
             onSettingsClicked();
         }
     }
 }
 
+/**
+ * @brief The user selected export from the add button menu
+ *
+ * We ask the user for a file name, and all machines are written there
+ * as JSON. The file has the same format as `machines.json`.
+ */
+void MainWindow::onExportClicked()
+{
+    const auto fileName = QFileDialog::getSaveFileName(this,
+                                                       tr("Export Machines"),
+                                                       "machines.json",
+                                                       tr("JSON files (*.json);;All files (*)"));
+    if (fileName.isNull()) {
+        return;
+    }
+    auto store = mStore;
+    if (!store.exportJson(fileName, mVmModel->machines())) {
+        QMessageBox::critical(this, tr("Could not export machines"), store.errorString());
+    }
+}
+
+/**
+ * @brief The user selected import from the add button menu
+ *
+ * We ask the user for a JSON file in the same format as
+ * `machines.json`. Machines from the file are added to the end of the
+ * list.
+ */
+void MainWindow::onImportClicked()
+{
+    const auto fileName = QFileDialog::getOpenFileName(this,
+                                                       tr("Import Machines"),
+                                                       {},
+                                                       tr("JSON files (*.json);;All files (*)"));
+    if (fileName.isNull()) {
+        return;
+    }
+    auto store = mStore;
+    QList<Machine> machines;
+    if (!store.importJson(fileName, machines)) {
+        QMessageBox::critical(this, tr("Could not import machines"), store.errorString());
+        return;
+    }
+    if (machines.isEmpty()) {
+        return;
+    }
+    QList<int> rows;
+    rows.reserve(machines.size());
+    for (int row = mVmModel->rowCount({}); rows.size() < machines.size(); ++row) {
+        rows.append(row);
+    }
+    mUndoStack->push(new InsertMachinesCommand(mVmModel, rows, machines));
+}
+
 /**
  * @brief The user triggered the context menu for the list view
  * 
@@ -124,10 +254,11 @@ void MainWindow::onEditClicked()
 {
     MachineDialog dialog(this);
     dialog.setWindowTitle(tr("Edit Machine"));
-    dialog.setMachine(mVmModel->machineForIndex(mVmView->currentIndex()));
+    const auto index = currentMachineIndex();
+    dialog.setMachine(mVmModel->machineForIndex(index));
 
     if (dialog.exec() == MachineDialog::Accepted) {
-        mVmModel->setMachineForIndex(mVmView->currentIndex(), dialog.machine());
+        mUndoStack->push(new ReplaceMachinesCommand(mVmModel, {index.row()}, {dialog.machine()}));
     }
 }
 
@@ -164,13 +295,190 @@ void MainWindow::onMachineDoubleClicked(const QModelIndex &index)
 void MainWindow::onMachineSelectionChanged(const QItemSelection &selected,
                                            const QItemSelection & /*deselected*/)
 {
-    const auto gotSelection = !selected.isEmpty();
+    // With extended selection, other items may still be selected
+    const auto gotSelection = !selected.isEmpty() || mVmView->selectionModel()->hasSelection();
     mStartAction->setEnabled(gotSelection);
     mEditAction->setEnabled(gotSelection);
     mSettingsAction->setEnabled(gotSelection);
     mRemoveAction->setEnabled(gotSelection);
 }
 
+/**
+ * @brief Machines were modified in the model
+ *
+ * The new content of the rows is recorded for the journal.
+ *
+ * @param[in] topLeft       First modified machine
+ * @param[in] bottomRight   Last modified machine
+ */
+void MainWindow::onMachinesChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    MachineJournal::Entry entry;
+    entry.operation = MachineJournal::Update;
+    entry.row = topLeft.row();
+    entry.machines = mVmModel->machines().mid(topLeft.row(), bottomRight.row() - topLeft.row() + 1);
+    mJournalEntries.append(entry);
+}
+
+/**
+ * @brief Machines were inserted into the model
+ *
+ * The inserted machines are recorded for the journal.
+ *
+ * @param[in] first   Row of the first inserted machine
+ * @param[in] last    Row of the last inserted machine
+ */
+void MainWindow::onMachinesInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+    MachineJournal::Entry entry;
+    entry.operation = MachineJournal::Insert;
+    entry.row = first;
+    entry.machines = mVmModel->machines().mid(first, last - first + 1);
+    mJournalEntries.append(entry);
+    updateLayoutMode(mVmModel->rowCount({}));
+}
+
+/**
+ * @brief The loader has restored machines from the store
+ *
+ * The loaded machines are handed to the model in one reset. Machines
+ * the user added while loading are kept after the loaded machines, and
+ * they are appended to the journal as new machines.
+ *
+ * The reset itself is not a change in the store. A snapshot is saved
+ * only if the journal could not be used, if the store format was
+ * changed while loading, or if machines got new IDs while loading.
+ *
+ * If the store could not be restored, saving is blocked until the user
+ * decides what to do with the store files. See onRestoreFailed().
+ */
+void MainWindow::onMachinesLoaded()
+{
+    if (!mLoading) {
+        return;
+    }
+
+    auto machines = mLoader->machines();
+    const auto loadedCount = static_cast<int>(machines.size());
+    const auto added = mVmModel->machines();
+    machines.append(added);
+    updateLayoutMode(static_cast<int>(machines.size()));
+    mVmModel->setMachines(machines);
+    mUndoStack->clear();
+    mVmStack->setCurrentWidget(mVmView);
+    mLoading = false;
+
+    // Changes recorded while loading do not apply to the store
+    mJournalEntries.clear();
+    mSaveTimer->stop();
+
+    if (!mLoader->restored()) {
+        onRestoreFailed(mLoader->errorString());
+        return;
+    }
+
+    // Machines stored without an ID, or with a duplicate ID, got a new one
+    // in the model. It must be saved, or the ID changes on every restore.
+    auto idsAssigned = false;
+    for (int row = 0; row < loadedCount && !idsAssigned; ++row) {
+        idsAssigned = mVmModel->machineAt(row).idAssigned();
+    }
+
+    mCompactionRequested = !mLoader->journalValid()
+                           || mLoader->store().format() != mStore.format() || idsAssigned;
+    if (!added.isEmpty()) {
+        MachineJournal::Entry entry;
+        entry.operation = MachineJournal::Insert;
+        entry.row = loadedCount;
+        entry.machines = added;
+        mJournalEntries.append(entry);
+    }
+    if (mCompactionRequested || !mJournalEntries.isEmpty()) {
+        saveMachines();
+    }
+}
+
+/**
+ * @brief Machines were moved in the model
+ * @param[in] sourceStart      Row of the first moved machine
+ * @param[in] sourceEnd        Row of the last moved machine
+ * @param[in] destinationRow   Machines were moved before this row
+ */
+void MainWindow::onMachinesMoved(const QModelIndex & /*sourceParent*/,
+                                 int sourceStart,
+                                 int sourceEnd,
+                                 const QModelIndex & /*destinationParent*/,
+                                 int destinationRow)
+{
+    MachineJournal::Entry entry;
+    entry.operation = MachineJournal::Move;
+    entry.row = sourceStart;
+    entry.count = sourceEnd - sourceStart + 1;
+    entry.destination = destinationRow;
+    mJournalEntries.append(entry);
+}
+
+/**
+ * @brief Machines were removed from the model
+ * @param[in] first   Row of the first removed machine
+ * @param[in] last    Row of the last removed machine
+ */
+void MainWindow::onMachinesRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+    MachineJournal::Entry entry;
+    entry.operation = MachineJournal::Remove;
+    entry.row = first;
+    entry.count = last - first + 1;
+    mJournalEntries.append(entry);
+    updateLayoutMode(mVmModel->rowCount({}));
+}
+
+/**
+ * @brief Machines were reordered in the model
+ *
+ * Machines moved from several places at once are not recorded as row
+ * moves, so the whole list is written on the next save.
+ */
+void MainWindow::onMachinesReordered()
+{
+    mJournalEntries.clear();
+    mCompactionRequested = true;
+}
+
+/**
+ * @brief The whole model was reset
+ *
+ * Recorded changes no longer apply, and the whole list is written on
+ * the next save.
+ */
+void MainWindow::onMachinesReset()
+{
+    mJournalEntries.clear();
+    mCompactionRequested = true;
+}
+
+/**
+ * @brief The store writer has saved queued changes
+ */
+void MainWindow::onMachinesSaved()
+{
+    qDebug() << "Machines saved";
+}
+
+/**
+ * @brief The store writer could not save machines
+ *
+ * The user is informed about the error. The writer requests a snapshot
+ * for the next save, so the whole list is written again on the next
+ * change or when the window is closed.
+ *
+ * @param[in] error   Description of the error
+ */
+void MainWindow::onMachinesSaveFailed(const QString &error)
+{
+    QMessageBox::critical(this, tr("Could not save machines"), error);
+}
+
 /**
  * @brief The user pressed the preferences button.
  *
@@ -180,7 +488,42 @@ void MainWindow::onMachineSelectionChanged(const QItemSelection &selected,
 void MainWindow::onPreferencesClicked()
 {
     PreferencesDialog dialog(mSettings, this);
-    dialog.exec();
+    if (dialog.exec() == PreferencesDialog::Accepted
+        && mSettings->machineStoreFormat() != mStore.format()) {
+        // Converting the store into the new format by saving a snapshot.
+        // While loading, this is done when the loader has finished.
+        setupStore();
+        if (!mLoading && !mSaveBlocked) {
+            mJournalEntries.clear();
+            mStoreWriter->queueSnapshot(mVmModel->machines());
+        }
+    }
+}
+
+/**
+ * @brief The user asked for the quick launch palette
+ *
+ * We show QuickLaunchDialog with the candidates prepared by
+ * @ref updateQuickLaunchCandidates. If the user accepts the
+ * dialog, the chosen machine is made current in the list view and
+ * started with @ref onStartClicked. The search is cleared if it hides
+ * the machine.
+ */
+void MainWindow::onQuickLaunchRequested()
+{
+    QuickLaunchDialog dialog(mQuickLaunchMatcher, this);
+    if (dialog.exec() != QDialog::Accepted || dialog.selectedRow() < 0) {
+        return;
+    }
+
+    const auto sourceIndex = mVmModel->index(dialog.selectedRow());
+    if (!mFilterModel->mapFromSource(sourceIndex).isValid()) {
+        mSearchEdit->clear();
+    }
+    const auto index = mFilterModel->mapFromSource(sourceIndex);
+    mVmView->setCurrentIndex(index);
+    mVmView->scrollTo(index);
+    onStartClicked();
 }
 
 /**
@@ -188,7 +531,7 @@ void MainWindow::onPreferencesClicked()
  *
  * We create a question message box with information about what we are
  * about to remove. If the user selects yes from the question message
- * box, the corresponding machine item from the model is removed.
+ * box, the selected machine items are removed from the model at once.
  */
 void MainWindow::onRemoveClicked()
 {
@@ -199,15 +542,68 @@ void MainWindow::onRemoveClicked()
            "files will not be deleted, but you may want to delete them yourself.\n\nContinue?"),
         QMessageBox::Yes | QMessageBox::No,
         this);
-    const auto machine = mVmModel->machineForIndex(mVmView->currentIndex());
-    messageBox.setDetailedText(
-        tr("Virtual machine: %1\nSummary: %2\nConfig file: %3")
-            .arg(machine.name(), machine.summary(), QDir::toNativeSeparators(machine.configFile())));
+    QModelIndexList indexes;
+    for (const auto &index : mVmView->selectionModel()->selectedIndexes()) {
+        indexes.append(mFilterModel->mapToSource(index));
+    }
+    if (indexes.isEmpty()) {
+        indexes.append(currentMachineIndex());
+    }
+    QStringList details;
+    for (const auto &index : indexes) {
+        const auto machine = mVmModel->machineForIndex(index);
+        details.append(tr("Virtual machine: %1\nSummary: %2\nConfig file: %3")
+                           .arg(machine.name(),
+                                machine.summary(),
+                                QDir::toNativeSeparators(machine.configFile())));
+    }
+    messageBox.setDetailedText(details.join("\n\n"));
     if (messageBox.exec() == QMessageBox::Yes) {
-        mVmModel->remove(mVmView->currentIndex());
+        QList<int> rows;
+        rows.reserve(indexes.size());
+        for (const auto &index : indexes) {
+            rows.append(index.row());
+        }
+        mUndoStack->push(new RemoveMachinesCommand(mVmModel, rows));
     }
 }
 
+/**
+ * @brief The machine store could not be restored
+ *
+ * The model does not have the stored machines, so saving it would
+ * overwrite them. Saving is blocked, and the user is asked if the store
+ * files should be moved aside. If the user agrees and the files are
+ * moved, the machines in the model are saved as a new list. Otherwise,
+ * nothing is saved in this session, and the files are left as they are.
+ *
+ * @param[in] error   Description of the error
+ */
+void MainWindow::onRestoreFailed(const QString &error)
+{
+    mSaveBlocked = true;
+    QMessageBox messageBox(
+        QMessageBox::Critical,
+        tr("Could not restore machines"),
+        tr("The machine list could not be read. Changes will not be saved, so that the "
+           "stored machines are not overwritten.\n\nDo you want to move the machine list "
+           "files aside as a backup and start a new list?"),
+        QMessageBox::Yes | QMessageBox::No,
+        this);
+    messageBox.setDetailedText(error);
+    if (messageBox.exec() != QMessageBox::Yes) {
+        return;
+    }
+
+    if (!mStore.backup()) {
+        QMessageBox::critical(this, tr("Could not back up machines"), mStore.errorString());
+        return;
+    }
+    mSaveBlocked = false;
+    mCompactionRequested = true;
+    saveMachines();
+}
+
 /**
  * @brief The user pressed the settings button.
  *
@@ -219,7 +615,7 @@ void MainWindow::onRemoveClicked()
  */
 void MainWindow::onSettingsClicked()
 {
-    const auto machine = mVmModel->machineForIndex(mVmView->currentIndex());
+    const auto machine = mVmModel->machineForIndex(currentMachineIndex());
     auto command = machine.settingsCommand();
     if (command.isEmpty()) {
         command = mSettings->settingsCommand();
@@ -238,7 +634,7 @@ void MainWindow::onSettingsClicked()
  */
 void MainWindow::onStartClicked()
 {
-    const auto machine = mVmModel->machineForIndex(mVmView->currentIndex());
+    const auto machine = mVmModel->machineForIndex(currentMachineIndex());
     auto command = machine.startCommand();
     if (command.isEmpty()) {
         command = mSettings->startCommand();
@@ -247,28 +643,42 @@ void MainWindow::onStartClicked()
 }
 
 /**
- * @brief Save all machines to the `machines.json` file
+ * @brief Save machine changes to the store
  * 
  * @pre This method is run on the mSaveTimer timeout signal.
  * 
- * The method requests a QVariantList of all machine items from the
- * model using its @ref MachineListModel::save() "save()" method.
- * The QVariantList is then turned into an indented JSON and written
- * to the `machines.json` file in the config directory.
+ * Normally, only the changes recorded since the last save are queued
+ * for the store writer, which appends them to the store journal. A
+ * snapshot of the whole list is queued instead when the journal has
+ * grown too large, or when the journal cannot be used.
+ *
+ * Taking the snapshot is cheap because Machine objects are implicitly
+ * shared. All serializing and writing happens in the writer thread.
+ *
+ * Nothing is saved while machines are loading, as the model does not
+ * have the stored machines yet, or when the store could not be restored.
  */
 void MainWindow::saveMachines()
 {
-    QFile file(Settings::configHome() + "/machines.json");
-    if (!file.open(QFile::WriteOnly)) {
-        QMessageBox::critical(this, tr("Could not save machines"), file.errorString());
+    if (mLoading) {
         return;
     }
-    const auto json = QJsonDocument::fromVariant(mVmModel->save()).toJson(QJsonDocument::Indented);
-    if (file.write(json) != json.size()) {
-        QMessageBox::critical(this, tr("Could not save machines"), file.errorString());
+
+    // The store has machines that are not in the model
+    if (mSaveBlocked) {
+        mJournalEntries.clear();
         return;
     }
-    qDebug() << "Machines saved";
+
+    if (mCompactionRequested || mStoreWriter->compactionNeeded()) {
+        mCompactionRequested = false;
+        mJournalEntries.clear();
+        mStoreWriter->queueSnapshot(mVmModel->machines());
+        return;
+    }
+
+    mStoreWriter->queueChanges(mJournalEntries);
+    mJournalEntries.clear();
 }
 
 /**
@@ -308,47 +718,15 @@ QToolButton *MainWindow::createToolButton(QAction *action, QWidget *parent)
     return button;
 }
 
-/**
- * @brief Restore machines from the `machines.json` file.
- *
- * @pre This method is run when the main window is constructed.
- * 
- * This function tries to read the `machines.json` from the config
- * directory. Content is then parsed as JSON. If there are no errors,
- * the loaded content is passed as QVariantList to the model using its
- * @ref MachineListModel::restore "restore()" method.
- */
-void MainWindow::restoreMachines()
-{
-    QFile file(Settings::configHome() + "/machines.json");
-    if (!file.exists()) {
-        return;
-    }
-
-    if (!file.open(QFile::ReadOnly)) {
-        QMessageBox::critical(this, tr("Could not restore machines"), file.errorString());
-        return;
-    }
-
-    QJsonParseError error{};
-    const auto jsonDocument = QJsonDocument::fromJson(file.readAll(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        QMessageBox::critical(this,
-                              tr("Could not restore machines"),
-                              tr("JSON error: %1").arg(error.errorString()));
-        return;
-    }
-
-    mVmModel->restore(jsonDocument.toVariant().toList());
-}
-
 /**
  * @brief Running commands
  *
- * This method takes the *command* and uses the @ref Formatter::format()
- * function to fill its variable fields using information from the
- * *machine* item. The operating system is then requested to run
- * the completed command.
+ * This method takes the compiled *command* from the FormatterCache,
+ * bound to @ref COMMAND_VARIABLES, and fills its variable fields using
+ * information from the *machine* item. The command templates are
+ * parsed and split into arguments only on their first use, and the
+ * values are put into the arguments as they are. The operating system
+ * is then requested to run the program with the arguments.
  *
  * If something goes wrong, the user will receive an error message box.
  * 
@@ -360,15 +738,15 @@ void MainWindow::restoreMachines()
 void MainWindow::runCommand(const QString &command, const Machine &machine)
 {
     bool ok = false;
-    const auto formattedCommand = Formatter::format(command, variablesForMachine(machine), &ok);
-    if (!ok || formattedCommand.isEmpty()) {
+    const auto formatter = FormatterCache::instance().formatter(command, COMMAND_VARIABLES, &ok);
+    auto arguments = formatter.formatArguments(variablesForMachine(machine));
+    if (!ok || arguments.isEmpty()) {
         QMessageBox::critical(
             this,
             tr("Error with settings command"),
             tr("Could not format the settings command. Please check your settings."));
         return;
     }
-    auto arguments = QProcess::splitCommand(formattedCommand);
     auto program = arguments.takeFirst();
 
     QProcess process(this);
@@ -399,11 +777,22 @@ void MainWindow::setupUi()
 
     // Setup actions
     mAddAction = new QAction(QIcon::fromTheme("86box-new"), tr("Add"), this);
+    mImportAction = new QAction(QIcon::fromTheme("document-open"), tr("Import Machines..."), this);
+    mExportAction = new QAction(QIcon::fromTheme("document-save"), tr("Export Machines..."), this);
     mEditAction = new QAction(QIcon::fromTheme("document-edit"), tr("Edit Machine"), this);
     mRemoveAction = new QAction(QIcon::fromTheme("86box-remove"), tr("Remove"), this);
     mSettingsAction = new QAction(QIcon::fromTheme("86box-settings"), tr("Settings"), this);
     mStartAction = new QAction(QIcon::fromTheme("86box-start"), tr("Start"), this);
     mPreferencesAction = new QAction(QIcon::fromTheme("86box-preferences"), tr("Preferences"), this);
+    mUndoStack = new QUndoStack(this);
+    mUndoAction = mUndoStack->createUndoAction(this);
+    mUndoAction->setIcon(QIcon::fromTheme("edit-undo"));
+    mUndoAction->setShortcut(QKeySequence::Undo);
+    mRedoAction = mUndoStack->createRedoAction(this);
+    mRedoAction->setIcon(QIcon::fromTheme("edit-redo"));
+    mRedoAction->setShortcut(QKeySequence::Redo);
+    addAction(mUndoAction);
+    addAction(mRedoAction);
     mEditAction->setEnabled(false);
     mRemoveAction->setEnabled(false);
     mSettingsAction->setEnabled(false);
@@ -418,6 +807,13 @@ void MainWindow::setupUi()
     mPreferencesButton = createToolButton(mPreferencesAction, this);
     mSeparatorLine->setFrameStyle(QFrame::VLine | QFrame::Sunken);
 
+    // Add menu for add button
+    mAddMenu = new QMenu(mAddButton);
+    mAddMenu->addAction(mImportAction);
+    mAddMenu->addAction(mExportAction);
+    mAddButton->setPopupMode(QToolButton::MenuButtonPopup);
+    mAddButton->setMenu(mAddMenu);
+
     // Add menu for settings button
     mSettingsMenu = new QMenu(mSettingsButton);
     mSettingsMenu->addAction(mEditAction);
@@ -436,11 +832,16 @@ void MainWindow::setupUi()
 
     // List view and model for virtual machines
     mVmModel = new MachineListModel(this);
-    mVmView = new QListView;
+    mFilterModel = new MachineFilterModel(this);
+    mVmModel->setUndoStack(mUndoStack);
+    mFilterModel->setSourceModel(mVmModel);
+    mVmView = new MachineListView;
     mVmView->setIconSize(machineIconSize);
-    mVmView->setModel(mVmModel);
+    mVmView->setModel(mFilterModel);
     mVmView->setDragDropMode(QListView::InternalMove);
-    mVmView->setItemDelegateForColumn(0, new MachineDelegate(mVmView));
+    mVmView->setSelectionMode(QListView::ExtendedSelection);
+    mVmDelegate = new MachineDelegate(mVmView);
+    mVmView->setItemDelegateForColumn(0, mVmDelegate);
 
     // Add context menu for list view
     mContextMenu = new QMenu(mVmView);
@@ -449,21 +850,46 @@ void MainWindow::setupUi()
     mContextMenu->addAction(mEditAction);
     mContextMenu->addSeparator();
     mContextMenu->addAction(mRemoveAction);
+    mContextMenu->addSeparator();
+    mContextMenu->addAction(mUndoAction);
+    mContextMenu->addAction(mRedoAction);
     mVmView->setContextMenuPolicy(Qt::CustomContextMenu);
 
+    // Loading message is shown instead of the list view until machines are loaded
+    mLoadingLabel = new QLabel(tr("Loading machines..."));
+    mLoadingLabel->setAlignment(Qt::AlignCenter);
+    mLoadingLabel->setEnabled(false);
+    mVmStack = new QStackedWidget;
+    mVmStack->addWidget(mLoadingLabel);
+    mVmStack->addWidget(mVmView);
+    mVmStack->setCurrentWidget(mLoadingLabel);
+
+    // Search box for filtering the list view
+    mSearchEdit = new QLineEdit;
+    mSearchEdit->setPlaceholderText(tr("Search machines"));
+    mSearchEdit->setClearButtonEnabled(true);
+
     // Main layout
     mMainLayout = new QVBoxLayout;
     mMainLayout->addLayout(mToolBarLayout);
-    mMainLayout->addWidget(mVmView);
+    mMainLayout->addWidget(mSearchEdit);
+    mMainLayout->addWidget(mVmStack);
     setLayout(mMainLayout);
 
     // Connecting actions
     connect(mAddAction, &QAction::triggered, this, &MainWindow::onAddClicked);
     connect(mEditAction, &QAction::triggered, this, &MainWindow::onEditClicked);
+    connect(mExportAction, &QAction::triggered, this, &MainWindow::onExportClicked);
+    connect(mImportAction, &QAction::triggered, this, &MainWindow::onImportClicked);
     connect(mPreferencesAction, &QAction::triggered, this, &MainWindow::onPreferencesClicked);
     connect(mRemoveAction, &QAction::triggered, this, &MainWindow::onRemoveClicked);
     connect(mSettingsAction, &QAction::triggered, this, &MainWindow::onSettingsClicked);
     connect(mStartAction, &QAction::triggered, this, &MainWindow::onStartClicked);
+    connect(mSearchEdit, &QLineEdit::textChanged, mFilterModel, &MachineFilterModel::setSearchText);
+    connect(new QShortcut(QKeySequence(tr("Ctrl+K")), this),
+            &QShortcut::activated,
+            this,
+            &MainWindow::onQuickLaunchRequested);
     connect(mVmView, &QListView::doubleClicked, this, &MainWindow::onMachineDoubleClicked);
     connect(mVmView,
             &QListView::customContextMenuRequested,
@@ -476,22 +902,98 @@ void MainWindow::setupUi()
 }
 
 /**
- * @brief Create an information map for the given machine
+ * @brief Creates the machine store and its writer
  *
- * This method creates an information map that can be used with
- * the @ref Formatter tool.
- * 
- * Map contains the following items:
+ * The store format and lazy restore are taken from the settings. If a
+ * writer already exists, it finishes writing everything queued before
+ * it is replaced.
+ *
+ * @pre mSettings must be initialized.
+ */
+void MainWindow::setupStore()
+{
+    delete mStoreWriter;
+    mStore = MachineStore(Settings::configHome(), mSettings->machineStoreFormat());
+    mStore.setLazyRestore(mSettings->lazyMachineRestore());
+    mStoreWriter = new MachineStoreWriter(mStore, this);
+    connect(mStoreWriter, &MachineStoreWriter::saved, this, &MainWindow::onMachinesSaved);
+    connect(mStoreWriter, &MachineStoreWriter::saveFailed, this, &MainWindow::onMachinesSaveFailed);
+}
+
+/**
+ * @brief Current machine in the model
+ *
+ * The list view shows machines through mFilterModel, so the current
+ * index of the view is mapped to mVmModel.
+ *
+ * @return Index of the current machine in mVmModel
+ */
+QModelIndex MainWindow::currentMachineIndex() const
+{
+    return mFilterModel->mapToSource(mVmView->currentIndex());
+}
+
+/**
+ * @brief Switch the list layout for the number of machines
+ *
+ * Long machine lists use uniform row heights, and the view lays out
+ * items in batches. This way, the view does not measure every machine
+ * when the list is reset or resized. The mode is switched back when
+ * the list gets shorter than half of the threshold.
+ *
+ * @param[in] machineCount   Number of machines in the list
+ */
+void MainWindow::updateLayoutMode(int machineCount)
+{
+    auto uniform = mVmDelegate->uniformRowHeights();
+    if (machineCount >= UNIFORM_LAYOUT_THRESHOLD) {
+        uniform = true;
+    } else if (machineCount < UNIFORM_LAYOUT_THRESHOLD / 2) {
+        uniform = false;
+    }
+    if (uniform == mVmDelegate->uniformRowHeights()) {
+        return;
+    }
+
+    mVmDelegate->setUniformRowHeights(uniform);
+    mVmView->setUniformItemSizes(uniform);
+    mVmView->setLayoutMode(uniform ? QListView::Batched : QListView::SinglePass);
+    mVmView->setBatchSize(LAYOUT_BATCH_SIZE);
+    mVmView->doItemsLayout();
+}
+
+/**
+ * @brief Make the quick launch candidates from the machines
+ *
+ * This is called when the machine model has changed, so that the
+ * candidates are ready when the quick launch palette is opened. The
+ * candidates are in the model row order.
+ */
+void MainWindow::updateQuickLaunchCandidates()
+{
+    QStringList candidates;
+    candidates.reserve(mVmModel->rowCount());
+    for (int row = 0; row < mVmModel->rowCount(); ++row) {
+        const auto &machine = mVmModel->machineAt(row);
+        candidates.append(machine.name() + QLatin1Char(' ') + machine.summary());
+    }
+    mQuickLaunchMatcher.setCandidates(candidates);
+}
+
+/**
+ * @brief Create variable values for the given machine
+ *
+ * This method creates the values for a @ref Formatter bound to
+ * @ref COMMAND_VARIABLES, in the same order:
  * - `86box`: with path to the 86Box emulator binary from the settings.
  * - `config`: with path to the configuration file of the *machine* item.
+ * - `name`: with the name of the *machine* item.
  * 
- * @param[in] machine   Make information map for this machine item
- * @return Map with machine information
+ * @param[in] machine   Make variable values for this machine item
+ * @return Values with machine information
  */
-QHash<QString, QString> MainWindow::variablesForMachine(const Machine &machine) const
+QStringList MainWindow::variablesForMachine(const Machine &machine) const
 {
-    // Adding double quotes to ensure paths with spaces work correctly.
-    const auto emulator = QLatin1Char('"') + mSettings->emulatorBinary() + QLatin1Char('"');
-    const auto config = QLatin1Char('"') + machine.configFile() + QLatin1Char('"');
-    return {{"86box", emulator}, {"config", config}};
+    // Values go into the arguments as they are, so paths are not quoted
+    return {mSettings->emulatorBinary(), machine.configFile(), machine.name()};
 }
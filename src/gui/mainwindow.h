@@ -10,16 +10,26 @@
 #define MAINWINDOW_H
 
 #include <QWidget>
+#include "data/machinestore.h"
+#include "utils/fuzzymatcher.h"
 
 class Machine;
+class MachineDelegate;
+class MachineFilterModel;
+class MachineStoreLoader;
+class MachineStoreWriter;
 class MachineListModel;
+class MachineListView;
 class QAction;
 class QFrame;
 class QHBoxLayout;
 class QItemSelection;
-class QListView;
+class QLabel;
+class QLineEdit;
 class QMenu;
+class QStackedWidget;
 class QToolButton;
+class QUndoStack;
 class QVBoxLayout;
 class Settings;
 
@@ -43,7 +53,7 @@ class MainWindow : public QWidget
 {
     Q_OBJECT
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(MachineStoreLoader *loader, QWidget *parent = nullptr);
 
     // QWidget interface
 protected:
@@ -53,10 +63,27 @@ private slots:
     void onAddClicked();
     void onContextMenuRequest(const QPoint &pos);
     void onEditClicked();
+    void onExportClicked();
+    void onImportClicked();
     void onMachineDoubleClicked(const QModelIndex &index);
     void onMachineSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
+    void onMachinesChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onMachinesInserted(const QModelIndex &parent, int first, int last);
+    void onMachinesLoaded();
+    void onMachinesMoved(const QModelIndex &sourceParent,
+                         int sourceStart,
+                         int sourceEnd,
+                         const QModelIndex &destinationParent,
+                         int destinationRow);
+    void onMachinesRemoved(const QModelIndex &parent, int first, int last);
+    void onMachinesReordered();
+    void onMachinesReset();
+    void onMachinesSaved();
+    void onMachinesSaveFailed(const QString &error);
     void onPreferencesClicked();
+    void onQuickLaunchRequested();
     void onRemoveClicked();
+    void onRestoreFailed(const QString &error);
     void onSettingsClicked();
     void onStartClicked();
     void saveMachines();
@@ -64,10 +91,14 @@ private slots:
 private:
     static QToolButton *createToolButton(QAction *action, QWidget *parent = nullptr);
 
-    void restoreMachines();
+    [[nodiscard]] QModelIndex currentMachineIndex() const;
+
     void runCommand(const QString &command, const Machine &machine);
+    void setupStore();
     void setupUi();
-    [[nodiscard]] QHash<QString, QString> variablesForMachine(const Machine &machine) const;
+    void updateLayoutMode(int machineCount);
+    void updateQuickLaunchCandidates();
+    [[nodiscard]] QStringList variablesForMachine(const Machine &machine) const;
 
     /**
      * @brief Settings manager
@@ -84,6 +115,7 @@ private:
      *
      * Contains:
      * - Tool buttons layout
+     * - Search box for filtering machines
      * - List view for emulated machines
      */
     QVBoxLayout *mMainLayout{};
@@ -105,10 +137,14 @@ private:
     // Actions for buttons and menus
     QAction *mAddAction{};         /*!< @brief Add or import machine configuration */
     QAction *mEditAction{};        /*!< @brief Edit action to open the MachineDialog */
+    QAction *mExportAction{};      /*!< @brief Export machines into a JSON file */
+    QAction *mImportAction{};      /*!< @brief Import machines from a JSON file */
     QAction *mPreferencesAction{}; /*!< @brief Preferences for the 86BoxLauncher */
+    QAction *mRedoAction{};        /*!< @brief Redo the last undone machine list change */
     QAction *mRemoveAction{};      /*!< @brief Remove selected machine item */
     QAction *mSettingsAction{};    /*!< @brief Launch settings dialog for selected machine */
     QAction *mStartAction{};       /*!< @brief Launch the 86Box emulator with selected machine */
+    QAction *mUndoAction{};        /*!< @brief Undo the last machine list change */
 
     // Tool bar widgets
     QToolButton *mAddButton{};      /*!< @brief Button for adding or importing emulation setups */
@@ -118,6 +154,14 @@ private:
     QToolButton *mRemoveButton{};   /*!< @brief Button for removing emulation setup */
     QToolButton *mPreferencesButton{}; /*!< @brief Button for opening the preferences dialog */
 
+    /**
+     * @brief Alternative menu for the add button
+     *
+     * This menu contains actions for importing and exporting machines
+     * as JSON.
+     */
+    QMenu *mAddMenu{};
+
     /**
      * @brief Alternative menu for the settings button
      *
@@ -133,16 +177,61 @@ private:
      */
     QMenu *mContextMenu{};
 
+    /**
+     * @brief Search box for filtering machines in mVmView
+     */
+    QLineEdit *mSearchEdit{};
+
     /**
      * @brief List view for virtual machines
      */
-    QListView *mVmView{};
+    MachineListView *mVmView{};
+
+    /**
+     * @brief Delegate for painting machines in mVmView
+     */
+    MachineDelegate *mVmDelegate{};
+
+    /**
+     * @brief Label shown instead of the list view while loading
+     */
+    QLabel *mLoadingLabel{};
+
+    /**
+     * @brief Stack for switching between mLoadingLabel and mVmView
+     */
+    QStackedWidget *mVmStack{};
 
     /**
      * @brief Model for virtual machines
      */
     MachineListModel *mVmModel{};
 
+    /**
+     * @brief Proxy model between mVmModel and mVmView for searching
+     *
+     * Indexes of the list view must be mapped to mVmModel with this
+     * model before they are used with mVmModel.
+     */
+    MachineFilterModel *mFilterModel{};
+
+    /**
+     * @brief Undo history for changes in mVmModel
+     *
+     * Adding, importing, editing, removing and moving machines are
+     * pushed here as commands. The history is cleared when the loaded
+     * machines replace the model content.
+     */
+    QUndoStack *mUndoStack{};
+
+    /**
+     * @brief Names and summaries of machines for the quick launch palette
+     *
+     * The candidates are made again when mVmModel changes, so opening
+     * QuickLaunchDialog does not need to go through all machines.
+     */
+    FuzzyMatcher mQuickLaunchMatcher;
+
     /**
      * @brief Timer for saving changes on the model
      * 
@@ -153,6 +242,64 @@ private:
      * expires without more restarts, which means all edits are done.
      */
     QTimer *mSaveTimer;
+
+    /**
+     * @brief Persistent storage for the machine list
+     *
+     * This store has the same files as the store of mLoader. It is
+     * used for importing and exporting machines, and all writing is
+     * done by mStoreWriter. The store is replaced if the user changes
+     * the store format.
+     */
+    MachineStore mStore;
+
+    /**
+     * @brief Background loader for the machine store
+     *
+     * The loader is borrowed from the caller, and it reads the store
+     * while the window is being set up. See onMachinesLoaded().
+     */
+    MachineStoreLoader *mLoader;
+
+    /**
+     * @brief Machines are still being loaded
+     *
+     * Machines added while loading are kept in the model, and they are
+     * merged with the loaded machines. Nothing is saved before loading
+     * has finished.
+     */
+    bool mLoading{true};
+
+    /**
+     * @brief Background writer for the machine store
+     *
+     * Changes are queued to the writer when mSaveTimer expires. The
+     * whole list is queued only when the store needs compaction.
+     */
+    MachineStoreWriter *mStoreWriter{};
+
+    /**
+     * @brief Changes waiting to be appended to the journal
+     *
+     * Model signals are recorded here as they happen and written to the
+     * journal by saveMachines().
+     */
+    QList<MachineJournal::Entry> mJournalEntries;
+
+    /**
+     * @brief The whole list must be written on the next save
+     *
+     * Set when the model is reset or when the journal cannot be used.
+     */
+    bool mCompactionRequested{false};
+
+    /**
+     * @brief Nothing may be written to the store
+     *
+     * Set when the store could not be restored, so that the unreadable
+     * files are not overwritten. See onRestoreFailed().
+     */
+    bool mSaveBlocked{false};
 };
 
 #endif // MAINWINDOW_H
@@ -32,6 +32,8 @@ PreferencesDialog::PreferencesDialog(Settings *settings, QWidget *parent)
     , mSettings(settings)
 {
     mUi->setupUi(this);
+    mUi->storeFormatComboBox->addItem(tr("JSON"), MachineStore::JsonFormat);
+    mUi->storeFormatComboBox->addItem(tr("Binary (CBOR)"), MachineStore::CborFormat);
 
     utilities::setDialogBoxIcons(mUi->buttonBox);
 
@@ -61,6 +63,8 @@ void PreferencesDialog::onAccepted()
     mSettings->setEmulatorBinary(QDir::fromNativeSeparators(mUi->emulatorLineEdit->text()));
     mSettings->setStartCommand(mUi->startCommandLineEdit->text());
     mSettings->setSettingsCommand(mUi->settingsCommandLineEdit->text());
+    mSettings->setMachineStoreFormat(
+        static_cast<MachineStore::Format>(mUi->storeFormatComboBox->currentData().toInt()));
     accept();
 }
 
@@ -114,4 +118,6 @@ void PreferencesDialog::loadSettings()
     mUi->emulatorLineEdit->setText(QDir::toNativeSeparators(mSettings->emulatorBinary()));
     mUi->startCommandLineEdit->setText(mSettings->startCommand());
     mUi->settingsCommandLineEdit->setText(mSettings->settingsCommand());
+    mUi->storeFormatComboBox->setCurrentIndex(
+        mUi->storeFormatComboBox->findData(mSettings->machineStoreFormat()));
 }
@@ -0,0 +1,101 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  quicklaunchdialog.cpp
+ * @brief QuickLaunchDialog class implementation
+ */
+
+#include "quicklaunchdialog.h"
+
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+/**
+ * @brief Maximum number of machines listed in the palette
+ */
+const int MAX_RESULTS = 50;
+
+/**
+ * @brief Constructs a quick launch dialog
+ *
+ * The candidate indexes of the *matcher* are used as the rows of the
+ * machines, so that the selected row can be used with the machine
+ * model. The matcher is copied, which only shares its candidates.
+ *
+ * @param[in] matcher   Matcher with the names and summaries of machines
+ * @param[in] parent    Pointer to parent widget
+ */
+QuickLaunchDialog::QuickLaunchDialog(const FuzzyMatcher &matcher, QWidget *parent)
+    : QDialog(parent)
+    , mMatcher(matcher)
+    , mSearchEdit(new QLineEdit(this))
+    , mResults(new QListWidget(this))
+{
+    setWindowTitle(tr("Quick Launch"));
+    mSearchEdit->setPlaceholderText(tr("Type to search, Enter to start"));
+    mResults->setUniformItemSizes(true);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(mSearchEdit);
+    layout->addWidget(mResults);
+
+    connect(mSearchEdit, &QLineEdit::textChanged, this, &QuickLaunchDialog::onSearchTextChanged);
+    connect(mSearchEdit, &QLineEdit::returnPressed, this, &QuickLaunchDialog::accept);
+    connect(mResults, &QListWidget::itemActivated, this, &QuickLaunchDialog::accept);
+
+    onSearchTextChanged({});
+    mSearchEdit->setFocus();
+}
+
+QuickLaunchDialog::~QuickLaunchDialog() = default;
+
+/**
+ * @brief Selected machine
+ * @return Row of the selected machine, or -1 if there are no matches
+ */
+int QuickLaunchDialog::selectedRow() const
+{
+    const auto *item = mResults->currentItem();
+    return item != nullptr ? item->data(Qt::UserRole).toInt() : -1;
+}
+
+/**
+ * @brief Move in the result list with the arrow keys
+ *
+ * The search box keeps the focus, so the up and down keys are passed
+ * to the result list from here.
+ *
+ * @param[in] event   Key event
+ */
+void QuickLaunchDialog::keyPressEvent(QKeyEvent *event)
+{
+    const auto key = event->key();
+    if (key == Qt::Key_Up || key == Qt::Key_Down || key == Qt::Key_PageUp
+        || key == Qt::Key_PageDown) {
+        QCoreApplication::sendEvent(mResults, event);
+        return;
+    }
+    QDialog::keyPressEvent(event);
+}
+
+/**
+ * @brief Rank machines for the new search text
+ *
+ * The best match is made current, so that Enter starts it.
+ *
+ * @param[in] text   Search text
+ */
+void QuickLaunchDialog::onSearchTextChanged(const QString &text)
+{
+    mResults->clear();
+    for (const auto &match : mMatcher.match(text, MAX_RESULTS)) {
+        auto *item = new QListWidgetItem(mResults);
+        item->setText(mMatcher.candidate(match.index));
+        item->setData(Qt::UserRole, match.index);
+    }
+    mResults->setCurrentRow(0);
+}
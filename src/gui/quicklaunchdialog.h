@@ -0,0 +1,52 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  quicklaunchdialog.h
+ * @brief QuickLaunchDialog class definition
+ */
+
+#ifndef QUICKLAUNCHDIALOG_H
+#define QUICKLAUNCHDIALOG_H
+
+#include <QDialog>
+#include "utils/fuzzymatcher.h"
+
+class QLineEdit;
+class QListWidget;
+
+/**
+ * @brief Keyboard-driven palette for starting machines
+ *
+ * The dialog has a search box and a list of machines ranked by how
+ * well their names and summaries fuzzy-match the search text. The
+ * candidates are prepared by the owner of the matcher, so opening the
+ * dialog does not go through all machines again. The list
+ * is updated on every keystroke. The arrow keys move in the list, and
+ * Enter accepts the dialog with the selected machine, or the best match
+ * if nothing else is selected.
+ */
+class QuickLaunchDialog : public QDialog
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(QuickLaunchDialog)
+
+public:
+    explicit QuickLaunchDialog(const FuzzyMatcher &matcher, QWidget *parent = nullptr);
+    ~QuickLaunchDialog() override;
+
+    [[nodiscard]] int selectedRow() const;
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+private slots:
+    void onSearchTextChanged(const QString &text);
+
+private:
+    FuzzyMatcher mMatcher;     /*!< @brief Matcher with the names and summaries of machines */
+    QLineEdit *mSearchEdit{};  /*!< @brief Search box */
+    QListWidget *mResults{};   /*!< @brief Ranked machines, row in the model as user data */
+};
+
+#endif // QUICKLAUNCHDIALOG_H
@@ -6,6 +6,8 @@
  * @brief The entry point for the program
  */
 
+#include "data/machinestoreloader.h"
+#include "data/settings.h"
 #include "gui/mainwindow.h"
 
 #include <QApplication>
@@ -29,9 +31,17 @@ int main(int argc, char *argv[])
 #endif
     QApplication const app(argc, argv);
 
+    // Machines are restored in the background while the icon theme and
+    // the main window are set up.
+    const Settings settings;
+    MachineStore store(Settings::configHome(), settings.machineStoreFormat());
+    store.setLazyRestore(settings.lazyMachineRestore());
+    MachineStoreLoader loader(store);
+    loader.start();
+
     setIconTheme();
 
-    MainWindow mainWindow;
+    MainWindow mainWindow(&loader);
     mainWindow.show();
 
     return QApplication::exec();
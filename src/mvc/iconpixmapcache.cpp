@@ -0,0 +1,221 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  iconpixmapcache.cpp
+ * @brief IconPixmapCache class implementation
+ */
+
+#include "iconpixmapcache.h"
+
+#include <QIcon>
+#include <QImageReader>
+
+namespace {
+
+/**
+ * @brief Default size of the cache in kilobytes
+ *
+ * A 64x64 pixmap takes 16 kB, so this holds hundreds of distinct
+ * icons even at high device pixel ratios.
+ */
+constexpr int DEFAULT_MAX_COST = 8 * 1024;
+
+/**
+ * @brief Maximum number of threads for reading icon files
+ */
+constexpr int MAX_THREADS = 2;
+
+} // namespace
+
+/**
+ * @brief Construct an empty cache
+ * @param[in] parent   Pointer to parent object
+ */
+IconPixmapCache::IconPixmapCache(QObject *parent)
+    : QObject{parent}
+    , mPixmaps(DEFAULT_MAX_COST)
+{
+    mPool.setMaxThreadCount(MAX_THREADS);
+}
+
+/**
+ * @brief Destroy the cache
+ *
+ * Images still being read are waited for. Their results are dropped.
+ */
+IconPixmapCache::~IconPixmapCache()
+{
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+/**
+ * @brief Get the rasterized *icon*
+ *
+ * @pre This method must be called in the user interface thread.
+ *
+ * @param[in] icon               Icon to rasterize
+ * @param[in] type               Icon type of the machine
+ * @param[in] name               Icon name of the machine, the file name for file icons
+ * @param[in] size               Icon size in device independent pixels
+ * @param[in] devicePixelRatio   Device pixel ratio of the paint device
+ * @return Pixmap for the icon, or a null pixmap if it is still being rasterized
+ */
+QPixmap IconPixmapCache::pixmap(const QIcon &icon,
+                                Machine::IconType type,
+                                const QString &name,
+                                const QSize &size,
+                                qreal devicePixelRatio)
+{
+    if (icon.isNull() || size.isEmpty()) {
+        return {};
+    }
+
+    const Key key{icon.cacheKey(), size, devicePixelRatio};
+    if (const auto *cached = mPixmaps.object(key)) {
+        return *cached;
+    }
+
+    if (type == Machine::IconFromFile) {
+        if (!mPending.contains(key)) {
+            mPending.insert(key);
+            mPool.start([this, key, icon, name, size, devicePixelRatio]() {
+                const auto image = readImage(name, size, devicePixelRatio);
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, key, icon, size, devicePixelRatio, image]() {
+                        onImageReady(key, icon, size, devicePixelRatio, image);
+                    },
+                    Qt::QueuedConnection);
+            });
+        }
+        return {};
+    }
+
+    auto pixmap = render(icon, size, devicePixelRatio);
+    insert(key, pixmap);
+    return pixmap;
+}
+
+/**
+ * @brief Cache size getter
+ * @return Maximum size of the cache in kilobytes
+ */
+int IconPixmapCache::maxCost() const
+{
+    return static_cast<int>(mPixmaps.maxCost());
+}
+
+/**
+ * @brief Set the maximum size of the cache
+ * @param[in] kilobytes   Maximum pixmap memory in kilobytes
+ */
+void IconPixmapCache::setMaxCost(int kilobytes)
+{
+    mPixmaps.setMaxCost(kilobytes);
+}
+
+/**
+ * @brief Size of the cached pixmaps
+ *
+ * Each pixmap costs its pixel data in kilobytes, at least one.
+ *
+ * @return Cost of all cached pixmaps in kilobytes
+ */
+int IconPixmapCache::totalCost() const
+{
+    return static_cast<int>(mPixmaps.totalCost());
+}
+
+/**
+ * @brief Remove all pixmaps from the cache
+ */
+void IconPixmapCache::clear()
+{
+    mPixmaps.clear();
+}
+
+/**
+ * @brief An image was read in the thread pool
+ *
+ * If the image could not be read, for example because the image format
+ * cannot be scaled while reading, the icon is rendered here instead.
+ *
+ * @param[in] key                Cache key for the pixmap
+ * @param[in] icon               Icon the image was read for
+ * @param[in] size               Icon size in device independent pixels
+ * @param[in] devicePixelRatio   Device pixel ratio of the paint device
+ * @param[in] image              Image read from the icon file, or null image on error
+ */
+void IconPixmapCache::onImageReady(const Key &key,
+                                   const QIcon &icon,
+                                   const QSize &size,
+                                   qreal devicePixelRatio,
+                                   const QImage &image)
+{
+    mPending.remove(key);
+    insert(key, image.isNull() ? render(icon, size, devicePixelRatio) : QPixmap::fromImage(image));
+    emit pixmapReady();
+}
+
+/**
+ * @brief Insert the *pixmap* into the cache
+ * @param[in] key      Cache key for the pixmap
+ * @param[in] pixmap   Rasterized icon
+ */
+void IconPixmapCache::insert(const Key &key, const QPixmap &pixmap)
+{
+    const auto bytes = static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    mPixmaps.insert(key, new QPixmap(pixmap), static_cast<int>(qMax<qint64>(1, bytes / 1024)));
+}
+
+/**
+ * @brief Render the *icon* with its icon engine
+ * @param[in] icon               Icon to render
+ * @param[in] size               Icon size in device independent pixels
+ * @param[in] devicePixelRatio   Device pixel ratio of the paint device
+ * @return Pixmap with the device pixel ratio set
+ */
+QPixmap IconPixmapCache::render(const QIcon &icon, const QSize &size, qreal devicePixelRatio)
+{
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+    auto pixmap = icon.pixmap(size * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    return pixmap;
+#else
+    return icon.pixmap(size, devicePixelRatio);
+#endif
+}
+
+/**
+ * @brief Read an icon file at the final pixel size
+ *
+ * @note This is run in the thread pool, so only QImage is used.
+ *
+ * The image is scaled while reading when the format supports it, which
+ * is the case for SVG. The aspect ratio is kept.
+ *
+ * @param[in] fileName           Icon file
+ * @param[in] size               Icon size in device independent pixels
+ * @param[in] devicePixelRatio   Device pixel ratio of the paint device
+ * @return Image with the device pixel ratio set, or null image on error
+ */
+QImage IconPixmapCache::readImage(const QString &fileName, const QSize &size, qreal devicePixelRatio)
+{
+    QImageReader reader(fileName);
+    auto imageSize = reader.size();
+    const auto targetSize = size * devicePixelRatio;
+    if (imageSize.isValid()) {
+        imageSize.scale(targetSize, Qt::KeepAspectRatio);
+    } else {
+        imageSize = targetSize;
+    }
+    reader.setScaledSize(imageSize);
+
+    auto image = reader.read();
+    if (!image.isNull()) {
+        image.setDevicePixelRatio(devicePixelRatio);
+    }
+    return image;
+}
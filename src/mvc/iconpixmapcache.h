@@ -0,0 +1,110 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  iconpixmapcache.h
+ * @brief IconPixmapCache class definition
+ */
+
+#ifndef ICONPIXMAPCACHE_H
+#define ICONPIXMAPCACHE_H
+
+#include <QCache>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include "data/machine.h"
+
+/**
+ * @brief Bounded cache of rasterized machine icons
+ *
+ * Painting a QIcon renders it again for every repaint, which is slow
+ * for SVG icons when a long list is scrolled. This cache keeps icons
+ * rasterized at the size and device pixel ratio in use.
+ *
+ * - Icons from files are read with QImageReader in a worker thread
+ *   pool, directly at the final pixel size. Until the image is ready,
+ *   @ref pixmap returns a null pixmap, and the caller should paint a
+ *   placeholder. The @ref pixmapReady signal tells when to repaint.
+ * - Theme icons come from QIcon engines, which must be used in the
+ *   user interface thread. They are rendered once per key and then
+ *   served from the cache.
+ *
+ * The key includes the QIcon cache key, so when the IconCache loads a
+ * modified icon file again, a new pixmap is rasterized for it.
+ *
+ * The cache is bounded by the pixmap memory in kilobytes, and the
+ * least recently used pixmaps are dropped first.
+ */
+class IconPixmapCache : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(IconPixmapCache)
+
+public:
+    explicit IconPixmapCache(QObject *parent = nullptr);
+    ~IconPixmapCache() override;
+
+    QPixmap pixmap(const QIcon &icon,
+                   Machine::IconType type,
+                   const QString &name,
+                   const QSize &size,
+                   qreal devicePixelRatio);
+
+    [[nodiscard]] int maxCost() const;
+    void setMaxCost(int kilobytes);
+    [[nodiscard]] int totalCost() const;
+    void clear();
+
+signals:
+    /**
+     * @brief An icon was rasterized in the background
+     *
+     * Views using the cache should repaint to show the new pixmap.
+     */
+    void pixmapReady();
+
+private:
+    /**
+     * @brief Key for rasterized icons
+     */
+    struct Key
+    {
+        qint64 iconKey{};          /*!< @brief QIcon cache key */
+        QSize size;                /*!< @brief Icon size in device independent pixels */
+        qreal devicePixelRatio{};  /*!< @brief Device pixel ratio of the paint device */
+
+        friend bool operator==(const Key &a, const Key &b)
+        {
+            return a.iconKey == b.iconKey && a.size == b.size
+                   && a.devicePixelRatio == b.devicePixelRatio;
+        }
+
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+        friend uint qHash(const Key &key, uint seed = 0)
+#else
+        friend size_t qHash(const Key &key, size_t seed = 0)
+#endif
+        {
+            return qHash(key.iconKey, seed) ^ qHash(key.devicePixelRatio)
+                   ^ (uint(key.size.width()) << 16U) ^ uint(key.size.height());
+        }
+    };
+
+    void onImageReady(const Key &key,
+                      const QIcon &icon,
+                      const QSize &size,
+                      qreal devicePixelRatio,
+                      const QImage &image);
+    void insert(const Key &key, const QPixmap &pixmap);
+
+    static QPixmap render(const QIcon &icon, const QSize &size, qreal devicePixelRatio);
+    static QImage readImage(const QString &fileName, const QSize &size, qreal devicePixelRatio);
+
+    QCache<Key, QPixmap> mPixmaps; /*!< @brief Rasterized icons, cost in kilobytes */
+    QSet<Key> mPending;            /*!< @brief Keys being rasterized in the thread pool */
+    QThreadPool mPool;             /*!< @brief Worker threads for reading icon files */
+};
+
+#endif // ICONPIXMAPCACHE_H
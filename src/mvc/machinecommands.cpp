@@ -0,0 +1,276 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinecommands.cpp
+ * @brief Undo commands for MachineListModel
+ */
+
+#include "machinecommands.h"
+#include "machinelistmodel.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Sort the *rows* and drop duplicates and rows outside of the model
+ * @param[in] rows       Rows in any order
+ * @param[in] rowCount   Number of rows in the model
+ * @return Valid rows in ascending order
+ */
+QList<int> sortedRows(QList<int> rows, int rowCount)
+{
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    rows.erase(std::remove_if(rows.begin(),
+                              rows.end(),
+                              [rowCount](int row) { return row < 0 || row >= rowCount; }),
+               rows.end());
+    return rows;
+}
+
+/**
+ * @brief Indexes of the *rows* in the *model*
+ * @param[in] model   Model of the rows
+ * @param[in] rows    Rows to convert
+ * @return Index for each row
+ */
+QModelIndexList indexesForRows(const MachineListModel *model, const QList<int> &rows)
+{
+    QModelIndexList indexes;
+    indexes.reserve(rows.size());
+    for (const auto row : rows) {
+        indexes.append(model->index(row));
+    }
+    return indexes;
+}
+
+/**
+ * @brief Machines at the *rows* of the *model*
+ * @param[in] model   Model of the rows
+ * @param[in] rows    Valid rows
+ * @return Shared copy of the machine at each row
+ */
+QList<Machine> machinesAtRows(const MachineListModel *model, const QList<int> &rows)
+{
+    QList<Machine> machines;
+    machines.reserve(rows.size());
+    for (const auto row : rows) {
+        machines.append(model->machineAt(row));
+    }
+    return machines;
+}
+
+} // namespace
+
+// InsertMachinesCommand
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Construct a command inserting *machines* at the *rows*
+ * @param[in] model      Model to change
+ * @param[in] rows       Rows for the machines after the insertion, in ascending order
+ * @param[in] machines   Machines to insert
+ * @param[in] parent     Parent command
+ */
+InsertMachinesCommand::InsertMachinesCommand(MachineListModel *model,
+                                             const QList<int> &rows,
+                                             const QList<Machine> &machines,
+                                             QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mModel(model)
+    , mRows(rows)
+    , mMachines(machines)
+{
+    setText(QCoreApplication::translate("MachineCommands",
+                                        "Add %n machine(s)",
+                                        nullptr,
+                                        static_cast<int>(machines.size())));
+}
+
+/**
+ * @brief Remove the inserted machines
+ */
+void InsertMachinesCommand::undo()
+{
+    mModel->removeMachines(indexesForRows(mModel, mRows));
+}
+
+/**
+ * @brief Insert the machines
+ */
+void InsertMachinesCommand::redo()
+{
+    if (mRows.isEmpty()) {
+        setObsolete(true);
+        return;
+    }
+    mModel->insertMachines(mRows, mMachines);
+}
+
+// RemoveMachinesCommand
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Construct a command removing machines at the *rows*
+ * @param[in] model    Model to change
+ * @param[in] rows     Rows of the machines to remove, in any order
+ * @param[in] parent   Parent command
+ */
+RemoveMachinesCommand::RemoveMachinesCommand(MachineListModel *model,
+                                             const QList<int> &rows,
+                                             QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mModel(model)
+    , mRows(sortedRows(rows, model->rowCount({})))
+    , mMachines(machinesAtRows(model, mRows))
+{
+    setText(QCoreApplication::translate("MachineCommands",
+                                        "Remove %n machine(s)",
+                                        nullptr,
+                                        static_cast<int>(mRows.size())));
+}
+
+/**
+ * @brief Put the removed machines back to their rows
+ */
+void RemoveMachinesCommand::undo()
+{
+    mModel->insertMachines(mRows, mMachines);
+}
+
+/**
+ * @brief Remove the machines
+ */
+void RemoveMachinesCommand::redo()
+{
+    if (mRows.isEmpty()) {
+        setObsolete(true);
+        return;
+    }
+    mModel->removeMachines(indexesForRows(mModel, mRows));
+}
+
+// ReplaceMachinesCommand
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Construct a command replacing machines at the *rows*
+ * @param[in] model      Model to change
+ * @param[in] rows       Valid rows of the machines to replace
+ * @param[in] machines   New machine for each row
+ * @param[in] parent     Parent command
+ */
+ReplaceMachinesCommand::ReplaceMachinesCommand(MachineListModel *model,
+                                               const QList<int> &rows,
+                                               const QList<Machine> &machines,
+                                               QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mModel(model)
+    , mRows(rows)
+    , mOldMachines(machinesAtRows(model, rows))
+    , mNewMachines(machines)
+{
+    setText(QCoreApplication::translate("MachineCommands",
+                                        "Edit %n machine(s)",
+                                        nullptr,
+                                        static_cast<int>(rows.size())));
+}
+
+/**
+ * @brief Put the old machines back
+ */
+void ReplaceMachinesCommand::undo()
+{
+    replace(mOldMachines);
+}
+
+/**
+ * @brief Replace the machines with the new ones
+ */
+void ReplaceMachinesCommand::redo()
+{
+    replace(mNewMachines);
+}
+
+/**
+ * @brief Replace the machines at the rows of the command
+ * @param[in] machines   Machine for each row
+ */
+void ReplaceMachinesCommand::replace(const QList<Machine> &machines)
+{
+    mModel->replaceMachines(indexesForRows(mModel, mRows), machines);
+}
+
+// MoveMachinesCommand
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Construct a command moving machines before the *destination* row
+ * @param[in] model         Model to change
+ * @param[in] rows          Rows of the machines to move, in any order
+ * @param[in] destination   Move machines before this row, or to the end if it is the row count
+ * @param[in] parent        Parent command
+ */
+MoveMachinesCommand::MoveMachinesCommand(MachineListModel *model,
+                                         const QList<int> &rows,
+                                         int destination,
+                                         QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mModel(model)
+    , mRows(sortedRows(rows, model->rowCount({})))
+    , mDestination(destination)
+{
+    const auto rowCount = model->rowCount({});
+    if (mDestination < 0 || mDestination > rowCount) {
+        mDestination = rowCount;
+    }
+    setText(QCoreApplication::translate("MachineCommands",
+                                        "Move %n machine(s)",
+                                        nullptr,
+                                        static_cast<int>(mRows.size())));
+}
+
+/**
+ * @brief Move the machines back to their rows
+ *
+ * After the move, the machines are together, starting from the
+ * destination row less the moved rows before it.
+ */
+void MoveMachinesCommand::undo()
+{
+    const auto count = static_cast<int>(mRows.size());
+    const auto movedBefore = static_cast<int>(
+        std::count_if(mRows.cbegin(), mRows.cend(), [this](int row) { return row < mDestination; }));
+    const auto start = mDestination - movedBefore;
+
+    const auto first = mRows.first();
+    if (mRows.last() - first + 1 == count) {
+        mModel->moveRows({}, start, count, {}, first < start ? first : first + count);
+        return;
+    }
+
+    const auto rowCount = mModel->rowCount({});
+    const auto order = MachineListModel::moveOrder(mRows, mDestination, rowCount);
+    QList<int> inverse(order);
+    for (int newRow = 0; newRow < rowCount; ++newRow) {
+        inverse[order.at(newRow)] = newRow;
+    }
+    mModel->reorderMachines(inverse);
+}
+
+/**
+ * @brief Move the machines
+ *
+ * A move that does not change the order makes the command obsolete,
+ * so it is not kept in the history.
+ */
+void MoveMachinesCommand::redo()
+{
+    if (!mModel->moveMachines(mRows, mDestination)) {
+        setObsolete(true);
+    }
+}
@@ -0,0 +1,117 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinecommands.h
+ * @brief Undo commands for MachineListModel
+ */
+
+#ifndef MACHINECOMMANDS_H
+#define MACHINECOMMANDS_H
+
+#include <QList>
+#include <QUndoCommand>
+#include "data/machine.h"
+
+class MachineListModel;
+
+/**
+ * @brief Undoable insertion of machines
+ *
+ * Commands only keep the rows and the machines they change. Machines
+ * are implicitly shared, so a command holds references to the same
+ * machine data as the model, and the history does not copy the list.
+ *
+ * All commands change the model through its batch functions, so that
+ * undoing or redoing a command lays out the view once.
+ */
+class InsertMachinesCommand : public QUndoCommand
+{
+public:
+    InsertMachinesCommand(MachineListModel *model,
+                          const QList<int> &rows,
+                          const QList<Machine> &machines,
+                          QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    MachineListModel *mModel; /*!< @brief Changed model */
+    QList<int> mRows;         /*!< @brief Rows of the inserted machines, in ascending order */
+    QList<Machine> mMachines; /*!< @brief Inserted machines */
+};
+
+/**
+ * @brief Undoable removal of machines
+ *
+ * The removed machines are kept in the command, so that they can be
+ * put back to their rows.
+ */
+class RemoveMachinesCommand : public QUndoCommand
+{
+public:
+    RemoveMachinesCommand(MachineListModel *model,
+                          const QList<int> &rows,
+                          QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    MachineListModel *mModel; /*!< @brief Changed model */
+    QList<int> mRows;         /*!< @brief Rows of the removed machines, in ascending order */
+    QList<Machine> mMachines; /*!< @brief Removed machines */
+};
+
+/**
+ * @brief Undoable replacement of machines
+ *
+ * This is used for editing machines. Both the old and the new machines
+ * are kept in the command.
+ */
+class ReplaceMachinesCommand : public QUndoCommand
+{
+public:
+    ReplaceMachinesCommand(MachineListModel *model,
+                           const QList<int> &rows,
+                           const QList<Machine> &machines,
+                           QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    void replace(const QList<Machine> &machines);
+
+    MachineListModel *mModel;    /*!< @brief Changed model */
+    QList<int> mRows;            /*!< @brief Rows of the replaced machines */
+    QList<Machine> mOldMachines; /*!< @brief Machines before the replacement */
+    QList<Machine> mNewMachines; /*!< @brief Machines after the replacement */
+};
+
+/**
+ * @brief Undoable move of machines
+ *
+ * Only the moved rows and the destination are kept. The move is undone
+ * with one row move if the rows were contiguous, or otherwise with one
+ * reordering of the list.
+ */
+class MoveMachinesCommand : public QUndoCommand
+{
+public:
+    MoveMachinesCommand(MachineListModel *model,
+                        const QList<int> &rows,
+                        int destination,
+                        QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    MachineListModel *mModel; /*!< @brief Changed model */
+    QList<int> mRows;         /*!< @brief Rows of the moved machines, in ascending order */
+    int mDestination;         /*!< @brief Machines were moved before this row */
+};
+
+#endif // MACHINECOMMANDS_H
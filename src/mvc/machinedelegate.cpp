@@ -7,26 +7,84 @@
  */
 
 #include "machinedelegate.h"
+#include "data/iconcache.h"
+#include "iconpixmapcache.h"
 #include "machinelistmodel.h"
 
+#include <QAbstractItemView>
 #include <QApplication>
 #include <QPainter>
 
+#include <array>
+
+namespace {
+
+/**
+ * @brief Maximum number of cached text sizes and elided texts
+ */
+constexpr int TEXT_CACHE_SIZE = 4096;
+
+} // namespace
+
 /**
  * @brief Construct machine delegate
  * @param[in] parent   Pointer to the parent object
  */
 MachineDelegate::MachineDelegate(QObject *parent)
     : QStyledItemDelegate{parent}
-{}
+    , mPixmapCache(new IconPixmapCache(this))
+    , mTextSizes(TEXT_CACHE_SIZE)
+    , mElided(TEXT_CACHE_SIZE)
+{
+    connect(mPixmapCache, &IconPixmapCache::pixmapReady, this, &MachineDelegate::onPixmapReady);
+}
 
 MachineDelegate::~MachineDelegate() = default;
 
+/**
+ * @brief Uniform row heights getter
+ * @return `true` if all items have the same size hint
+ */
+bool MachineDelegate::uniformRowHeights() const
+{
+    return mUniformRowHeights;
+}
+
+/**
+ * @brief Set if all items have the same size hint
+ *
+ * When enabled, the size hint is calculated from the font metrics and
+ * the decoration size only. This should be used together with
+ * QListView::setUniformItemSizes() for long machine lists, so that the
+ * layout of the view does not depend on the number of items.
+ *
+ * @param[in] uniform   Use the same size hint for all items
+ */
+void MachineDelegate::setUniformRowHeights(bool uniform)
+{
+    mUniformRowHeights = uniform;
+}
+
+/**
+ * @brief Number of cached label sizes and elided labels
+ *
+ * This is mainly for testing that the caches are cleared when the
+ * font, palette or style changes.
+ *
+ * @return Number of texts in the caches
+ */
+int MachineDelegate::cachedTextCount() const
+{
+    return static_cast<int>(mTextSizes.size() + mElided.size());
+}
+
 /**
  * @brief Painting Machine item
  * 
- * This function starts by initializing the style options and checking
- * whether the desktop theme is light or dark.
+ * This function starts by reading the item data with @ref itemData and
+ * checking whether the desktop theme is light or dark. The style
+ * options are used as given by the view, so the model is accessed only
+ * once per paint.
  *
  * Next, the function calculates the positions of the items to be drawn
  * using the @ref calculateLayout function.
@@ -45,7 +103,10 @@ MachineDelegate::~MachineDelegate() = default;
  * whether the mouse is over the item. The outline for the rectangle is
  * drawn if the mouse pointer is over the item.
  * 
- * The machine icon is drawn in the middle of the reserved area.
+ * The machine icon is drawn in the middle of the reserved area. The
+ * icon is rasterized for the decoration size and the device pixel
+ * ratio of the painter. While an icon file is still being rasterized
+ * in the background, a rounded placeholder is drawn instead.
  *
  * The name is drawn using a 1 pt larger version of the style font in
  * the space reserved.
@@ -55,7 +116,8 @@ MachineDelegate::~MachineDelegate() = default;
  * from the style.
  * 
  * If the name or summary does not fit in the reserved area, they are
- * cut to fit, and `...` is added to the end of the text.
+ * cut to fit, and `...` is added to the end of the text. Elided texts
+ * are cached by width, so repainting does not measure them again.
  * 
  * @param[in] painter   Pointer to painter object used for drawing
  * @param[in] option    Style options for the item
@@ -65,73 +127,81 @@ void MachineDelegate::paint(QPainter *painter,
                             const QStyleOptionViewItem &option,
                             const QModelIndex &index) const
 {
-    // Init style option
-    auto styleOption = option;
-    initStyleOption(&styleOption, index);
-    const bool darkTheme = styleOption.palette.color(QPalette::Window).value()
-                           < styleOption.palette.color(QPalette::WindowText).value();
+    // Check the theme. The style option is not initialized from the model,
+    // since all item data is read by itemData().
+    const bool darkTheme = option.palette.color(QPalette::Window).value()
+                           < option.palette.color(QPalette::WindowText).value();
 
     // Calculate layout
+    const auto item = itemData(index);
     QRect iconArea;
     QRect nameArea;
     QRect summaryArea;
-    calculateLayout(styleOption, index, &iconArea, &nameArea, &summaryArea);
+    calculateLayout(option, item, &iconArea, &nameArea, &summaryArea);
 
     // Save painter state
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing);
 
     // Avoid painting outside of the dedicated area
-    painter->setClipRect(styleOption.rect);
+    painter->setClipRect(option.rect);
 
     // Draw background?
-    const auto selected = styleOption.state.testFlag(QStyle::State_Selected);
-    const auto mouseOver = styleOption.state.testFlag(QStyle::State_MouseOver);
+    const auto selected = option.state.testFlag(QStyle::State_Selected);
+    const auto mouseOver = option.state.testFlag(QStyle::State_MouseOver);
     if (selected || mouseOver) {
-        auto backgroundColor = styleOption.palette.color(QPalette::Highlight);
+        auto backgroundColor = option.palette.color(QPalette::Highlight);
         backgroundColor = darkTheme ? backgroundColor.darker() : backgroundColor.lighter();
         if (!selected) {
             backgroundColor = darkTheme ? backgroundColor.darker() : backgroundColor.lighter();
         }
         painter->setBrush(backgroundColor);
         if (mouseOver) {
-            painter->setPen(styleOption.palette.color(QPalette::Highlight));
+            painter->setPen(option.palette.color(QPalette::Highlight));
         } else {
             painter->setPen(Qt::NoPen);
         }
-        painter->drawRoundedRect(styleOption.rect.adjusted(1, 1, -1, -1), 3, 3);
+        painter->drawRoundedRect(option.rect.adjusted(1, 1, -1, -1), 3, 3);
     }
 
     // Draw decoration icon center of icon area
-    if (!styleOption.icon.isNull()) {
+    const auto icon = IconCache::instance().icon(item.iconType, item.iconName);
+    if (!icon.isNull()) {
         QRect drawArea = iconArea;
-        drawArea.setSize(styleOption.decorationSize);
+        drawArea.setSize(option.decorationSize);
         drawArea.moveLeft(drawArea.left() + (iconArea.width() - drawArea.width()) / 2);
         drawArea.moveTop(drawArea.top() + (iconArea.height() - drawArea.height()) / 2);
-        styleOption.icon.paint(painter, drawArea);
+        const auto pixmap = mPixmapCache->pixmap(icon,
+                                                 item.iconType,
+                                                 item.iconName,
+                                                 drawArea.size(),
+                                                 painter->device()->devicePixelRatioF());
+        if (!pixmap.isNull()) {
+            // Keep aspect ratio of the pixmap and center it
+            auto pixmapArea = QRect(QPoint(), pixmap.size() / pixmap.devicePixelRatio());
+            pixmapArea.moveCenter(drawArea.center());
+            painter->drawPixmap(pixmapArea, pixmap);
+        } else {
+            auto placeholderColor = option.palette.color(QPalette::Mid);
+            placeholderColor.setAlpha(64);
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(placeholderColor);
+            painter->drawRoundedRect(drawArea.adjusted(2, 2, -2, -2), 4, 4);
+        }
     }
 
     // Draw name label
-    auto nameFont = styleOption.font;
-    nameFont.setPointSize(nameFont.pointSize() + 1);
-    auto nameFontMetrics = QFontMetrics(nameFont);
-    auto elidedText = nameFontMetrics.elidedText(index.data(Qt::DisplayRole).toString(),
-                                                 Qt::ElideRight,
-                                                 nameArea.width());
-    painter->setFont(nameFont);
-    painter->setPen(styleOption.palette.color(QPalette::WindowText));
-    painter->drawText(nameArea, Qt::TextSingleLine, elidedText);
+    const auto &cached = metrics(option);
+    auto text = elidedText(NameLabel, item.name, nameArea.width());
+    painter->setFont(cached.nameFont);
+    painter->setPen(option.palette.color(QPalette::WindowText));
+    painter->drawText(nameArea, Qt::TextSingleLine, text);
 
     // Draw summary label
-    auto summaryFont = styleOption.font;
-    summaryFont.setPointSize(summaryFont.pointSize() - 1);
-    auto summaryFontMetrics = QFontMetrics(summaryFont);
-    elidedText = summaryFontMetrics.elidedText(index.data(MachineListModel::SummaryRole).toString(),
-                                               Qt::ElideRight,
-                                               summaryArea.width());
-    painter->setFont(summaryFont);
-    painter->setPen(styleOption.palette.placeholderText().color());
-    painter->drawText(summaryArea, Qt::TextSingleLine, elidedText);
+    text = elidedText(SummaryLabel, item.summary, summaryArea.width());
+    painter->setFont(cached.summaryFont);
+    painter->setPen(option.palette.placeholderText().color());
+    painter->drawText(summaryArea, Qt::TextSingleLine, text);
 
     // Restore painter to previous state
     painter->restore();
@@ -140,8 +210,9 @@ void MachineDelegate::paint(QPainter *painter,
 /**
  * @brief Calculates the appropriate size to fit all the data
  * 
- * This function initializes the style options and passes it and *index*
- * for the @ref calculateLayout to the math.
+ * This function passes the style options and the item data for the
+ * @ref calculateLayout to the math. With uniform row heights, the item
+ * data is not read at all.
  * 
  * @param[in] option    Style options for the item
  * @param[in] index     Index for reading Machine item data
@@ -149,9 +220,38 @@ void MachineDelegate::paint(QPainter *painter,
  */
 QSize MachineDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
-    auto styleOption = option;
-    initStyleOption(&styleOption, index);
-    return calculateLayout(styleOption, index);
+    return calculateLayout(option, mUniformRowHeights ? ItemData() : itemData(index));
+}
+
+/**
+ * @brief Read the data for painting an item
+ *
+ * On Qt 6, the roles are read with one QModelIndex::multiData() call,
+ * so the model looks up the item only once.
+ *
+ * @param[in] index   Index for reading Machine item data
+ * @return Name, summary and icon key of the item
+ */
+MachineDelegate::ItemData MachineDelegate::itemData(const QModelIndex &index)
+{
+    ItemData item;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    std::array<QModelRoleData, 4> roles = {QModelRoleData(Qt::DisplayRole),
+                                           QModelRoleData(MachineListModel::SummaryRole),
+                                           QModelRoleData(MachineListModel::IconTypeRole),
+                                           QModelRoleData(MachineListModel::IconNameRole)};
+    index.multiData(roles);
+    item.name = roles[0].data().toString();
+    item.summary = roles[1].data().toString();
+    item.iconType = roles[2].data().value<Machine::IconType>();
+    item.iconName = roles[3].data().toString();
+#else
+    item.name = index.data(Qt::DisplayRole).toString();
+    item.summary = index.data(MachineListModel::SummaryRole).toString();
+    item.iconType = index.data(MachineListModel::IconTypeRole).value<Machine::IconType>();
+    item.iconName = index.data(MachineListModel::IconNameRole).toString();
+#endif
+    return item;
 }
 
 /**
@@ -169,6 +269,105 @@ QStyle *MachineDelegate::getStyle() const
     return widget != nullptr ? widget->style() : QApplication::style();
 }
 
+/**
+ * @brief Get values derived from the style options
+ *
+ * The fonts, font metrics and style metrics are calculated again only
+ * when the font, palette or style differs from the previous call. In
+ * that case, the cached text sizes and elided texts are also cleared.
+ *
+ * @param[in] option   Style options for the item
+ * @return Cached values for the style options
+ */
+const MachineDelegate::Metrics &MachineDelegate::metrics(const QStyleOptionViewItem &option) const
+{
+    const auto *style = getStyle();
+    if (mMetrics.style == style && mMetrics.paletteKey == option.palette.cacheKey()
+        && mMetrics.font == option.font) {
+        return mMetrics;
+    }
+
+    mTextSizes.clear();
+    mElided.clear();
+
+    mMetrics.font = option.font;
+    mMetrics.paletteKey = option.palette.cacheKey();
+    mMetrics.style = style;
+
+    mMetrics.nameFont = option.font;
+    mMetrics.nameFont.setPointSize(mMetrics.nameFont.pointSize() + 1);
+    mMetrics.nameFontMetrics = QFontMetrics(mMetrics.nameFont);
+
+    mMetrics.summaryFont = option.font;
+    mMetrics.summaryFont.setPointSize(mMetrics.summaryFont.pointSize() - 1);
+    mMetrics.summaryFontMetrics = QFontMetrics(mMetrics.summaryFont);
+
+    mMetrics.leftMargin = style->pixelMetric(QStyle::PM_LayoutLeftMargin, &option);
+    mMetrics.topMargin = style->pixelMetric(QStyle::PM_LayoutTopMargin, &option);
+    mMetrics.rightMargin = style->pixelMetric(QStyle::PM_LayoutRightMargin, &option);
+    mMetrics.bottomMargin = style->pixelMetric(QStyle::PM_LayoutBottomMargin, &option);
+    mMetrics.horizontalSpacing = style->pixelMetric(QStyle::PM_LayoutHorizontalSpacing, &option);
+    return mMetrics;
+}
+
+/**
+ * @brief Measure the size of a label
+ *
+ * @pre @ref metrics must have been called for the current style options.
+ *
+ * @param[in] label   Label the text is drawn in
+ * @param[in] text    Label text
+ * @return Size of the text on a single line
+ */
+QSize MachineDelegate::textSize(Label label, const QString &text) const
+{
+    const TextKey key{label, 0, text};
+    if (const auto *size = mTextSizes.object(key)) {
+        return *size;
+    }
+
+    const auto &fontMetrics = label == NameLabel ? mMetrics.nameFontMetrics
+                                                 : mMetrics.summaryFontMetrics;
+    const auto size = fontMetrics.size(Qt::TextSingleLine, text);
+    mTextSizes.insert(key, new QSize(size));
+    return size;
+}
+
+/**
+ * @brief Elide a label to fit the *width*
+ *
+ * @pre @ref metrics must have been called for the current style options.
+ *
+ * @param[in] label   Label the text is drawn in
+ * @param[in] text    Label text
+ * @param[in] width   Available width in pixels
+ * @return Text elided from the right, if it does not fit
+ */
+QString MachineDelegate::elidedText(Label label, const QString &text, int width) const
+{
+    const TextKey key{label, width, text};
+    if (const auto *elided = mElided.object(key)) {
+        return *elided;
+    }
+
+    const auto &fontMetrics = label == NameLabel ? mMetrics.nameFontMetrics
+                                                 : mMetrics.summaryFontMetrics;
+    auto elided = fontMetrics.elidedText(text, Qt::ElideRight, width);
+    mElided.insert(key, new QString(elided));
+    return elided;
+}
+
+/**
+ * @brief Repaint the view after an icon was rasterized
+ */
+void MachineDelegate::onPixmapReady()
+{
+    auto *view = qobject_cast<QAbstractItemView *>(parent());
+    if (view != nullptr) {
+        view->viewport()->update();
+    }
+}
+
 /**
  * @brief Calculate optimal size and item positions
  * 
@@ -180,6 +379,10 @@ QStyle *MachineDelegate::getStyle() const
  * item. Using this information, the optimal size can be calculated to
  * fit all the information.
  * 
+ * With uniform row heights, the labels are not measured. The label
+ * heights come from the font metrics, and the width only covers the
+ * margins and the icon.
+ *
  * Pointers to rectangle objects are optional. If they are given, then
  * the positions and sizes of the items are calculated for them. These
  * calculations take into account the total available drawing area.
@@ -187,38 +390,37 @@ QStyle *MachineDelegate::getStyle() const
  * <img src="MachineDelegate-Layout.svg" alt="Machine item layout">
  * 
  * @param[in] option        Style options for the item
- * @param[in] index         Index for reading Machine item data
+ * @param[in] item          Item data from @ref itemData
  * @param[out] iconArea     Calculate the icon area into this rectangle (optional)
  * @param[out] nameArea     Calculate the name label area into this rectangle (optional)
  * @param[out] summaryArea  Calculate the summary label area into this rectangle (optional)
  * @return Optimal size for the item
  */
 QSize MachineDelegate::calculateLayout(const QStyleOptionViewItem &option,
-                                       const QModelIndex &index,
+                                       const ItemData &item,
                                        QRect *iconArea,
                                        QRect *nameArea,
                                        QRect *summaryArea) const
 {
     // Collect metrics
-    const auto *style = getStyle();
-    const auto leftMargin = style->pixelMetric(QStyle::PM_LayoutLeftMargin, &option);
-    const auto topMargin = style->pixelMetric(QStyle::PM_LayoutTopMargin, &option);
-    const auto rightMargin = style->pixelMetric(QStyle::PM_LayoutRightMargin, &option);
-    const auto bottomMargin = style->pixelMetric(QStyle::PM_LayoutBottomMargin, &option);
-    const auto horizontalSpacing = style->pixelMetric(QStyle::PM_LayoutHorizontalSpacing, &option);
-
-    // Size for the name label
-    auto nameFont = option.font;
-    nameFont.setPointSize(nameFont.pointSize() + 1);
-    auto nameFontMetrics = QFontMetrics(nameFont);
-    auto nameSize = nameFontMetrics.size(Qt::TextSingleLine, index.data(Qt::DisplayRole).toString());
-
-    // Size for the summary label
-    auto summaryFont = option.font;
-    summaryFont.setPointSize(summaryFont.pointSize() - 1);
-    auto summaryFontMetrics = QFontMetrics(summaryFont);
-    auto summarySize = summaryFontMetrics.size(Qt::TextSingleLine,
-                                               index.data(MachineListModel::SummaryRole).toString());
+    const auto &cached = metrics(option);
+    const auto leftMargin = cached.leftMargin;
+    const auto topMargin = cached.topMargin;
+    const auto rightMargin = cached.rightMargin;
+    const auto bottomMargin = cached.bottomMargin;
+    const auto horizontalSpacing = cached.horizontalSpacing;
+
+    // Size for the name and summary labels. With uniform row heights,
+    // the labels get their width from the item rectangle when painting.
+    QSize nameSize;
+    QSize summarySize;
+    if (mUniformRowHeights) {
+        nameSize.setHeight(cached.nameFontMetrics.height());
+        summarySize.setHeight(cached.summaryFontMetrics.height());
+    } else {
+        nameSize = textSize(NameLabel, item.name);
+        summarySize = textSize(SummaryLabel, item.summary);
+    }
 
     // Size for dectoration (also content height)
     const auto decorationSize = std::max(option.decorationSize.height(),
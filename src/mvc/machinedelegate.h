@@ -9,7 +9,13 @@
 #ifndef MACHINEDELEGATE_H
 #define MACHINEDELEGATE_H
 
+#include <QCache>
+#include <QFont>
+#include <QFontMetrics>
 #include <QStyledItemDelegate>
+#include "data/machine.h"
+
+class IconPixmapCache;
 
 /**
  * @brief Custom painting for Machine items
@@ -17,6 +23,24 @@
  * This delegate is installed in the main window's list view to display
  * machine items with icons, names, and summaries.
  * 
+ * Fonts, font metrics and style metrics derived from the style options
+ * are cached, as are text sizes and elided texts. The caches are
+ * cleared when the font, palette or style of the items changes.
+ *
+ * With @ref setUniformRowHeights "uniform row heights", all items get
+ * the same size hint from the font metrics alone, so the view does not
+ * need to measure the labels of every item. Labels are then only
+ * measured when they are elided for painting.
+ *
+ * The item data is read once per paint. On Qt 6, all roles are read
+ * with one QModelIndex::multiData() call. The style options from the
+ * view are used as they are, without initStyleOption(), which would
+ * read the display and decoration roles again. The icon is taken from
+ * the IconCache by the icon type and name in the item data.
+ *
+ * Machine icons are rasterized through an IconPixmapCache, and a
+ * placeholder is painted until the pixmap of an icon file is ready.
+ *
  * This delegate uses the following layout:\n
  * <img src="MachineDelegate-Layout.svg" alt="Machine item layout">
  */
@@ -29,6 +53,11 @@ public:
     explicit MachineDelegate(QObject *parent = nullptr);
     ~MachineDelegate() override;
 
+    [[nodiscard]] bool uniformRowHeights() const;
+    void setUniformRowHeights(bool uniform);
+
+    [[nodiscard]] int cachedTextCount() const;
+
     // QAbstractItemDelegate interface
 public:
     void paint(QPainter *painter,
@@ -38,12 +67,88 @@ public:
                                  const QModelIndex &index) const override;
 
 private:
+    /**
+     * @brief Values derived from the style options
+     */
+    struct Metrics
+    {
+        QFont font;                                /*!< @brief Item font the values are derived from */
+        qint64 paletteKey{-1};                     /*!< @brief Cache key of the item palette */
+        const QStyle *style{};                     /*!< @brief Style the margins are read from */
+        QFont nameFont;                            /*!< @brief Font for the name label */
+        QFont summaryFont;                         /*!< @brief Font for the summary label */
+        QFontMetrics nameFontMetrics{QFont()};     /*!< @brief Metrics for the name font */
+        QFontMetrics summaryFontMetrics{QFont()};  /*!< @brief Metrics for the summary font */
+        int leftMargin{};                          /*!< @brief Style left margin */
+        int topMargin{};                           /*!< @brief Style top margin */
+        int rightMargin{};                         /*!< @brief Style right margin */
+        int bottomMargin{};                        /*!< @brief Style bottom margin */
+        int horizontalSpacing{};                   /*!< @brief Style horizontal spacing */
+    };
+
+    /**
+     * @brief Item data used for the layout and painting
+     */
+    struct ItemData
+    {
+        QString name;                                /*!< @brief Machine name */
+        QString summary;                             /*!< @brief Machine summary */
+        Machine::IconType iconType{Machine::NoIcon}; /*!< @brief Icon type of the machine */
+        QString iconName;                            /*!< @brief Icon name of the machine */
+    };
+
+    /**
+     * @brief Labels drawn for the item
+     */
+    enum Label {
+        NameLabel,   /*!< @brief Machine name */
+        SummaryLabel /*!< @brief Machine summary */
+    };
+
+    /**
+     * @brief Key for the cached label sizes and elided labels
+     *
+     * The text is shared with the item data, so making a key does not
+     * copy the text.
+     */
+    struct TextKey
+    {
+        Label label{}; /*!< @brief Label the text is drawn in */
+        int width{};   /*!< @brief Available width, zero for label sizes */
+        QString text;  /*!< @brief Label text */
+
+        friend bool operator==(const TextKey &a, const TextKey &b)
+        {
+            return a.label == b.label && a.width == b.width && a.text == b.text;
+        }
+
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+        friend uint qHash(const TextKey &key, uint seed = 0)
+#else
+        friend size_t qHash(const TextKey &key, size_t seed = 0)
+#endif
+        {
+            return qHash(key.text, seed) ^ (uint(key.width) << 1U) ^ uint(key.label);
+        }
+    };
+
     [[nodiscard]] QStyle *getStyle() const;
+    const Metrics &metrics(const QStyleOptionViewItem &option) const;
+    QSize textSize(Label label, const QString &text) const;
+    QString elidedText(Label label, const QString &text, int width) const;
+    static ItemData itemData(const QModelIndex &index);
     QSize calculateLayout(const QStyleOptionViewItem &option,
-                          const QModelIndex &index,
+                          const ItemData &item,
                           QRect *iconArea = nullptr,
                           QRect *nameArea = nullptr,
                           QRect *summaryArea = nullptr) const;
+    void onPixmapReady();
+
+    IconPixmapCache *mPixmapCache;             /*!< @brief Rasterized machine icons */
+    mutable Metrics mMetrics;                  /*!< @brief Cached values derived from the style options */
+    mutable QCache<TextKey, QSize> mTextSizes; /*!< @brief Measured label sizes by label and text */
+    mutable QCache<TextKey, QString> mElided;  /*!< @brief Elided labels by label, width and text */
+    bool mUniformRowHeights{};                 /*!< @brief Size hints do not depend on item texts */
 };
 
 #endif // MACHINEDELEGATE_H
@@ -0,0 +1,164 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinefiltermodel.cpp
+ * @brief MachineFilterModel class implementation
+ */
+
+#include "machinefiltermodel.h"
+#include "machinelistmodel.h"
+
+/**
+ * @brief Construct a filter model without a source model
+ * @param[in] parent   Pointer to parent object
+ */
+MachineFilterModel::MachineFilterModel(QObject *parent)
+    : QSortFilterProxyModel{parent}
+{}
+
+MachineFilterModel::~MachineFilterModel() = default;
+
+/**
+ * @brief Search text getter
+ * @return Current search text
+ */
+QString MachineFilterModel::searchText() const
+{
+    return mIndex.query();
+}
+
+/**
+ * @brief Show only machines matching the *text*
+ *
+ * Machines match when their name, summary, configuration file or extra
+ * variables contain all words of the *text*. Case and accents are
+ * ignored. An empty text shows all machines.
+ *
+ * @param[in] text   Text to search for
+ */
+void MachineFilterModel::setSearchText(const QString &text)
+{
+    if (text == mIndex.query()) {
+        return;
+    }
+    mIndex.setQuery(text);
+    invalidateFilter();
+}
+
+/**
+ * @brief Set the source model
+ *
+ * Only a MachineListModel is indexed. With other models, all rows are
+ * accepted.
+ *
+ * @param[in] sourceModel   Model to filter
+ */
+void MachineFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (mMachineModel != nullptr) {
+        disconnect(mMachineModel, nullptr, this, nullptr);
+    }
+
+    mMachineModel = qobject_cast<MachineListModel *>(sourceModel);
+    if (mMachineModel != nullptr) {
+        mIndex.reset(mMachineModel->machines());
+        connect(mMachineModel,
+                &MachineListModel::dataChanged,
+                this,
+                &MachineFilterModel::onSourceDataChanged);
+        connect(mMachineModel,
+                &MachineListModel::rowsInserted,
+                this,
+                &MachineFilterModel::onSourceRowsInserted);
+        connect(mMachineModel,
+                &MachineListModel::rowsMoved,
+                this,
+                &MachineFilterModel::onSourceRowsMoved);
+        connect(mMachineModel,
+                &MachineListModel::rowsRemoved,
+                this,
+                &MachineFilterModel::onSourceRowsRemoved);
+        connect(mMachineModel,
+                &MachineListModel::layoutChanged,
+                this,
+                &MachineFilterModel::onSourceReset);
+        connect(mMachineModel,
+                &MachineListModel::modelReset,
+                this,
+                &MachineFilterModel::onSourceReset);
+    } else {
+        mIndex.reset({});
+    }
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+/**
+ * @brief Check if the source row matches the search text
+ * @param[in] sourceRow      Row in the source model
+ * @param[in] sourceParent   Parent index in the source model (not used)
+ * @return `true` if the row is shown
+ */
+bool MachineFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex & /*sourceParent*/) const
+{
+    return mMachineModel == nullptr || mIndex.matches(sourceRow);
+}
+
+/**
+ * @brief Index the modified source rows again
+ * @param[in] topLeft       First modified machine
+ * @param[in] bottomRight   Last modified machine
+ */
+void MachineFilterModel::onSourceDataChanged(const QModelIndex &topLeft,
+                                             const QModelIndex &bottomRight)
+{
+    const auto count = bottomRight.row() - topLeft.row() + 1;
+    mIndex.update(topLeft.row(), mMachineModel->machines().mid(topLeft.row(), count));
+}
+
+/**
+ * @brief Index the inserted source rows
+ * @param[in] first   Row of the first inserted machine
+ * @param[in] last    Row of the last inserted machine
+ */
+void MachineFilterModel::onSourceRowsInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+    mIndex.insert(first, mMachineModel->machines().mid(first, last - first + 1));
+}
+
+/**
+ * @brief Move index entries of the moved source rows
+ * @param[in] sourceStart      First moved row
+ * @param[in] sourceEnd        Last moved row
+ * @param[in] destinationRow   Rows were moved before this row
+ */
+void MachineFilterModel::onSourceRowsMoved(const QModelIndex & /*sourceParent*/,
+                                           int sourceStart,
+                                           int sourceEnd,
+                                           const QModelIndex & /*destinationParent*/,
+                                           int destinationRow)
+{
+    mIndex.move(sourceStart, sourceEnd - sourceStart + 1, destinationRow);
+}
+
+/**
+ * @brief Remove index entries of the removed source rows
+ * @param[in] first   First removed row
+ * @param[in] last    Last removed row
+ */
+void MachineFilterModel::onSourceRowsRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+    mIndex.remove(first, last - first + 1);
+}
+
+/**
+ * @brief Index all source rows again
+ *
+ * This is used when the source model is reset, or its rows are
+ * reordered all at once.
+ */
+void MachineFilterModel::onSourceReset()
+{
+    mIndex.reset(mMachineModel->machines());
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinefiltermodel.h
+ * @brief MachineFilterModel class definition
+ */
+
+#ifndef MACHINEFILTERMODEL_H
+#define MACHINEFILTERMODEL_H
+
+#include <QSortFilterProxyModel>
+#include "machinesearchindex.h"
+
+class MachineListModel;
+
+/**
+ * @brief Proxy model for searching machines
+ *
+ * The proxy shows the machines of a MachineListModel that match the
+ * @ref setSearchText "search text". Matching is done with a
+ * MachineSearchIndex, which is kept up to date from the row signals of
+ * the source model, so that only changed rows are indexed again.
+ *
+ * The index is connected to the source model before the proxy itself,
+ * so the index is always updated before the proxy filters new or
+ * changed rows.
+ */
+class MachineFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineFilterModel)
+
+public:
+    explicit MachineFilterModel(QObject *parent = nullptr);
+    ~MachineFilterModel() override;
+
+    [[nodiscard]] QString searchText() const;
+    void setSearchText(const QString &text);
+
+    // QAbstractProxyModel interface
+public:
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    // QSortFilterProxyModel interface
+protected:
+    [[nodiscard]] bool filterAcceptsRow(int sourceRow,
+                                        const QModelIndex &sourceParent) const override;
+
+private:
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsMoved(const QModelIndex &sourceParent,
+                           int sourceStart,
+                           int sourceEnd,
+                           const QModelIndex &destinationParent,
+                           int destinationRow);
+    void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceReset();
+
+    MachineListModel *mMachineModel{}; /*!< @brief Source model */
+    MachineSearchIndex mIndex;          /*!< @brief Search index for the source rows */
+};
+
+#endif // MACHINEFILTERMODEL_H
@@ -7,14 +7,48 @@
  */
 
 #include "machinelistmodel.h"
+#include "machinecommands.h"
+#include "machinemimedata.h"
 
 #include <QDebug>
 #include <QIcon>
 #include <QJsonDocument>
-#include <QMimeData>
+#include <QSet>
+#include <QUndoStack>
+
+#include <algorithm>
+#include <utility>
 
 namespace {
-const auto jsonMimeType = "application/json";
+const auto jsonMimeType = MachineMimeData::JSON_MIME_TYPE;
+
+/**
+ * @brief Merge rows of the *indexes* into contiguous ranges
+ * @param[in] indexes   Indexes to merge
+ * @param[in] rowCount  Number of rows in the model, rows outside of it are skipped
+ * @return Ranges as first and last row, in ascending order
+ */
+QList<QPair<int, int>> rowRanges(const QModelIndexList &indexes, int rowCount)
+{
+    QList<int> rows;
+    rows.reserve(indexes.size());
+    for (const auto &index : indexes) {
+        if (index.isValid() && index.row() < rowCount) {
+            rows.append(index.row());
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+
+    QList<QPair<int, int>> ranges;
+    for (const auto row : rows) {
+        if (!ranges.isEmpty() && row <= ranges.last().second + 1) {
+            ranges.last().second = std::max(ranges.last().second, row);
+        } else {
+            ranges.append({row, row});
+        }
+    }
+    return ranges;
+}
 } // namespace
 
 /**
@@ -24,15 +58,34 @@ const auto jsonMimeType = "application/json";
 MachineListModel::MachineListModel(QObject *parent)
     : QAbstractListModel{parent}
 {
-    connect(this, &MachineListModel::modelReset, this, &MachineListModel::modelChanged);
-    connect(this, &MachineListModel::dataChanged, this, &MachineListModel::modelChanged);
-    connect(this, &MachineListModel::rowsInserted, this, &MachineListModel::modelChanged);
-    connect(this, &MachineListModel::rowsMoved, this, &MachineListModel::modelChanged);
-    connect(this, &MachineListModel::rowsRemoved, this, &MachineListModel::modelChanged);
+    qRegisterMetaType<MachineListModel::ChangeSet>();
+
+    // Removed and moved machines are recorded while they are still at their rows
+    connect(this, &MachineListModel::modelReset, this, &MachineListModel::onModelReset);
+    connect(this, &MachineListModel::dataChanged, this, &MachineListModel::onDataChanged);
+    connect(this, &MachineListModel::rowsInserted, this, &MachineListModel::onRowsInserted);
+    connect(this,
+            &MachineListModel::rowsAboutToBeMoved,
+            this,
+            &MachineListModel::onRowsAboutToBeMoved);
+    connect(this, &MachineListModel::layoutChanged, this, &MachineListModel::onLayoutChanged);
+    connect(this,
+            &MachineListModel::rowsAboutToBeRemoved,
+            this,
+            &MachineListModel::onRowsAboutToBeRemoved);
 }
 
 MachineListModel::~MachineListModel() = default;
 
+/**
+ * @brief Check if the change set has no changes
+ * @return `true` if no kind of change was recorded
+ */
+bool MachineListModel::ChangeSet::isEmpty() const
+{
+    return !kinds;
+}
+
 /**
  * @brief Add a new *machine* to the model.
  *
@@ -45,10 +98,78 @@ void MachineListModel::addMachine(const Machine &machine)
 {
     auto row = static_cast<int>(mMachines.size());
     beginInsertRows({}, row, row);
-    mMachines.append(machine);
+    mMachines.append(withUniqueIds({machine}));
+    indexRows(row);
     endInsertRows();
 }
 
+/**
+ * @brief Add new *machines* to the end of the model
+ *
+ * All machines are inserted with one rows inserted signal.
+ *
+ * @param[in] machines   Add these machines to the model
+ */
+void MachineListModel::addMachines(const QList<Machine> &machines)
+{
+    if (machines.isEmpty()) {
+        return;
+    }
+    auto row = static_cast<int>(mMachines.size());
+    beginInsertRows({}, row, row + static_cast<int>(machines.size()) - 1);
+    mMachines.append(withUniqueIds(machines));
+    indexRows(row);
+    endInsertRows();
+}
+
+/**
+ * @brief Insert *machines* at the *rows*
+ *
+ * Each machine gets the row at the same position in *rows*, counted
+ * after the insertion. This is how machines removed from scattered
+ * rows are put back. Contiguous rows are inserted with one rows
+ * inserted signal, and the @ref modelChanged signal is sent once.
+ * The rows in the ID index are updated once after all ranges have
+ * been inserted, from the first inserted row onwards.
+ *
+ * Only an error message is printed to the console if the rows are not
+ * in ascending order, or if the lists do not have the same size.
+ *
+ * @param[in] rows       Rows for the machines after the insertion, in ascending order
+ * @param[in] machines   Machines to insert
+ */
+void MachineListModel::insertMachines(const QList<int> &rows, const QList<Machine> &machines)
+{
+    if (rows.size() != machines.size()) {
+        qCritical() << "Got" << machines.size() << "machines for" << rows.size() << "rows";
+        return;
+    }
+    for (int i = 0; i < rows.size(); ++i) {
+        if (rows.at(i) < 0 || rows.at(i) > mMachines.size() + i
+            || (i > 0 && rows.at(i) <= rows.at(i - 1))) {
+            qCritical() << "Invalid rows for inserting machines:" << rows;
+            return;
+        }
+    }
+
+    const auto inserted = withUniqueIds(machines);
+    for (int first = 0; first < rows.size();) {
+        auto last = first;
+        while (last + 1 < rows.size() && rows.at(last + 1) == rows.at(last) + 1) {
+            ++last;
+        }
+        beginInsertRows({}, rows.at(first), rows.at(last));
+        for (int i = first; i <= last; ++i) {
+            mMachines.insert(rows.at(i), inserted.at(i));
+        }
+        endInsertRows();
+        first = last + 1;
+    }
+    if (!rows.isEmpty()) {
+        indexRows(rows.first());
+    }
+}
+
 /**
  * @brief Get Machine item from the *index*
  * @param[in] index   Get Machine from this index
@@ -60,6 +181,35 @@ Machine MachineListModel::machineForIndex(const QModelIndex &index) const
     return mMachines.value(index.row());
 }
 
+/**
+ * @brief Reference to the machine at the *row*
+ *
+ * Unlike @ref machineForIndex, this does not copy the machine. The
+ * reference is valid until the model is changed.
+ *
+ * @param[in] row   Row of the machine, must be a valid row
+ * @return Reference to the machine
+ */
+const Machine &MachineListModel::machineAt(int row) const
+{
+    return mMachines.at(row);
+}
+
+/**
+ * @brief Find the index of the machine with the *id*
+ *
+ * The row is looked up from a hash, so this does not depend on the
+ * number of machines.
+ *
+ * @param[in] id   ID of the machine
+ * @return Index of the machine, or invalid index if there is no such machine
+ */
+QModelIndex MachineListModel::indexForId(const QUuid &id) const
+{
+    const auto it = mRows.constFind(id);
+    return it != mRows.cend() ? index(it.value()) : QModelIndex();
+}
+
 /**
  * @brief Replace the Machine item at the given *index*.
  *
@@ -76,8 +226,10 @@ void MachineListModel::setMachineForIndex(const QModelIndex &index, const Machin
         qCritical() << "Invalid index:" << index;
         return;
     }
-    mMachines[index.row()] = machine;
-    emit dataChanged(index, index, {Qt::DecorationRole, Qt::DisplayRole, SummaryRole});
+    replaceAt(index.row(), machine);
+    emit dataChanged(index,
+                     index,
+                     {Qt::DecorationRole, Qt::DisplayRole, SummaryRole, IconTypeRole, IconNameRole});
 }
 
 /**
@@ -95,10 +247,304 @@ void MachineListModel::remove(const QModelIndex &index)
         return;
     }
     beginRemoveRows({}, index.row(), index.row());
+    unindexRows(index.row(), index.row());
     mMachines.removeAt(index.row());
+    indexRows(index.row());
     endRemoveRows();
 }
 
+/**
+ * @brief Remove machines at the *indexes*
+ *
+ * The rows are merged into contiguous ranges, and each range is removed
+ * with one rows removed signal, starting from the last range. The
+ * @ref modelChanged signal is sent once for the whole removal. The rows
+ * in the ID index are updated once after all ranges have been removed,
+ * from the first removed row onwards.
+ *
+ * @param[in] indexes   Remove machines from these indexes, in any order
+ */
+void MachineListModel::removeMachines(const QModelIndexList &indexes)
+{
+    const auto ranges = rowRanges(indexes, static_cast<int>(mMachines.size()));
+    for (auto it = ranges.crbegin(); it != ranges.crend(); ++it) {
+        beginRemoveRows({}, it->first, it->second);
+        unindexRows(it->first, it->second);
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+        auto first = mMachines.begin() + it->first;
+#else
+        auto first = mMachines.constBegin() + it->first;
+#endif
+        mMachines.erase(first, first + (it->second - it->first + 1));
+        endRemoveRows();
+    }
+    if (!ranges.isEmpty()) {
+        indexRows(ranges.first().first);
+    }
+}
+
+/**
+ * @brief Replace machines at the *indexes*
+ *
+ * Each index gets the machine at the same position in *machines*. The
+ * rows are merged into contiguous ranges, and one data changed signal
+ * is sent for each range. The @ref modelChanged signal is sent once
+ * for the whole replacement.
+ *
+ * Only an error message is printed to the console if the lists do not
+ * have the same size.
+ *
+ * @param[in] indexes    Replace machines at these indexes
+ * @param[in] machines   New machines for the *indexes*
+ */
+void MachineListModel::replaceMachines(const QModelIndexList &indexes,
+                                       const QList<Machine> &machines)
+{
+    if (indexes.size() != machines.size()) {
+        qCritical() << "Got" << machines.size() << "machines for" << indexes.size() << "indexes";
+        return;
+    }
+
+    QModelIndexList replaced;
+    for (int i = 0; i < indexes.size(); ++i) {
+        const auto &index = indexes.at(i);
+        if (!index.isValid() || index.row() >= mMachines.size()) {
+            qCritical() << "Invalid index:" << index;
+            continue;
+        }
+        replaceAt(index.row(), machines.at(i));
+        replaced.append(index);
+    }
+
+    for (const auto &range : rowRanges(replaced, static_cast<int>(mMachines.size()))) {
+        emit dataChanged(this->index(range.first),
+                         this->index(range.second),
+                         {Qt::DecorationRole, Qt::DisplayRole, SummaryRole, IconTypeRole, IconNameRole});
+    }
+}
+
+/**
+ * @brief All machine items in the model
+ *
+ * Machine items are implicitly shared, so the returned list is a cheap
+ * snapshot of the model. It stays unchanged even if the model is
+ * modified afterwards.
+ *
+ * @return List of all machines in the model order
+ */
+QList<Machine> MachineListModel::machines() const
+{
+    return mMachines;
+}
+
+/**
+ * @brief Replace all machine items in the model
+ *
+ * The model is reset once with the new list.
+ *
+ * @param[in] machines   New machines for the model
+ */
+void MachineListModel::setMachines(const QList<Machine> &machines)
+{
+    beginResetModel();
+    mMachines = machines;
+    rebuildIndex();
+    endResetModel();
+}
+
+/**
+ * @brief Move machines from the *rows* before the *destination* row
+ *
+ * The moved machines keep their order, and they are placed together
+ * before the machine that was at the *destination* row. Machines are
+ * moved without copying them.
+ *
+ * If the *rows* are contiguous, this is one @ref moveRows call, and
+ * the rows moved signals are sent. Otherwise, the machines are moved
+ * with one @ref reorderMachines call.
+ *
+ * @param[in] rows          Rows of the machines to move, in any order
+ * @param[in] destination   Move machines before this row, or to the end if it is the row count
+ * @return `true` if machines were moved, `false` if there was nothing to move
+ */
+bool MachineListModel::moveMachines(const QList<int> &rows, int destination)
+{
+    const auto rowCount = static_cast<int>(mMachines.size());
+    if (destination < 0 || destination > rowCount) {
+        destination = rowCount;
+    }
+
+    auto sorted = rows;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    sorted.erase(std::remove_if(sorted.begin(),
+                                sorted.end(),
+                                [rowCount](int row) { return row < 0 || row >= rowCount; }),
+                 sorted.end());
+    if (sorted.isEmpty()) {
+        return false;
+    }
+
+    const auto count = static_cast<int>(sorted.size());
+    if (sorted.last() - sorted.first() + 1 == count) {
+        return moveRows({}, sorted.first(), count, {}, destination);
+    }
+
+    return reorderMachines(moveOrder(sorted, destination, rowCount));
+}
+
+/**
+ * @brief Order of the rows after moving the *rows* before the *destination*
+ *
+ * This is the order used by @ref moveMachines. It can be inverted for
+ * undoing the move with @ref reorderMachines.
+ *
+ * @param[in] rows          Valid rows of the moved machines in ascending order, without duplicates
+ * @param[in] destination   Machines are moved before this row
+ * @param[in] rowCount      Number of rows in the model
+ * @return Old row for each new row
+ */
+QList<int> MachineListModel::moveOrder(const QList<int> &rows, int destination, int rowCount)
+{
+    QVector<bool> moved(rowCount, false);
+    for (const auto row : rows) {
+        moved[row] = true;
+    }
+    QList<int> order;
+    order.reserve(rowCount);
+    for (int row = 0; row < destination; ++row) {
+        if (!moved.at(row)) {
+            order.append(row);
+        }
+    }
+    order.append(rows);
+    for (int row = destination; row < rowCount; ++row) {
+        if (!moved.at(row)) {
+            order.append(row);
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief Put the machines into a new *order*
+ *
+ * The model emits the layout changed signals once, and persistent
+ * indexes are updated to follow their machines.
+ *
+ * @param[in] order   Old row for each new row, must have every row once
+ * @return `true` if machines were reordered, `false` if the order was invalid or unchanged
+ */
+bool MachineListModel::reorderMachines(const QList<int> &order)
+{
+    const auto rowCount = static_cast<int>(mMachines.size());
+    if (order.size() != rowCount) {
+        qCritical() << "Got" << order.size() << "rows for reordering" << rowCount << "machines";
+        return false;
+    }
+
+    // Only the range between the first and the last changed row is re-indexed
+    QVector<int> newRows(rowCount, -1);
+    int firstChanged = rowCount;
+    int lastChanged = -1;
+    for (int newRow = 0; newRow < rowCount; ++newRow) {
+        const auto oldRow = order.at(newRow);
+        if (oldRow < 0 || oldRow >= rowCount || newRows.at(oldRow) != -1) {
+            qCritical() << "Invalid order for reordering machines";
+            return false;
+        }
+        newRows[oldRow] = newRow;
+        if (oldRow != newRow) {
+            firstChanged = std::min(firstChanged, newRow);
+            lastChanged = newRow;
+        }
+    }
+    if (lastChanged < 0) {
+        return false;
+    }
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    QList<Machine> machines;
+    machines.reserve(rowCount);
+    for (const auto oldRow : order) {
+        machines.append(mMachines.at(oldRow));
+    }
+    mMachines.swap(machines);
+    indexRows(firstChanged, lastChanged);
+
+    const auto from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const auto &index : from) {
+        to.append(index.isValid() ? this->index(newRows.at(index.row()), index.column()) : index);
+    }
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+    return true;
+}
+
+/**
+ * @brief Move machines dragged inside the model
+ *
+ * Views call this for machines dropped on themselves. With an
+ * @ref setUndoStack "undo stack", the move is pushed to the stack as a
+ * MoveMachinesCommand, so that the drag can be undone and the rows of
+ * earlier commands stay valid. Otherwise, this is @ref moveMachines.
+ *
+ * @param[in] rows          Rows of the dragged machines, in any order
+ * @param[in] destination   Move machines before this row, or to the end if it is the row count
+ */
+void MachineListModel::moveDraggedMachines(const QList<int> &rows, int destination)
+{
+    if (mUndoStack != nullptr) {
+        mUndoStack->push(new MoveMachinesCommand(this, rows, destination));
+    } else {
+        moveMachines(rows, destination);
+    }
+}
+
+/**
+ * @brief Undo stack getter
+ * @return Undo stack for changes made by drag and drop, or `nullptr`
+ */
+QUndoStack *MachineListModel::undoStack() const
+{
+    return mUndoStack;
+}
+
+/**
+ * @brief Set the undo stack for changes made by drag and drop
+ *
+ * Views change the model directly when machines are dropped. With an
+ * undo stack, dropped machines are moved or inserted with commands
+ * pushed to the stack, so that the drop can be undone.
+ *
+ * @param[in] stack   Undo stack, or `nullptr` to change the model directly
+ */
+void MachineListModel::setUndoStack(QUndoStack *stack)
+{
+    mUndoStack = stack;
+}
+
+/**
+ * @brief Send the collected changes now
+ *
+ * Normally the @ref modelChanged signal is sent when control returns
+ * to the event loop. This sends it right away, if there are changes
+ * waiting.
+ */
+void MachineListModel::flushChanges()
+{
+    if (!mChangesPending) {
+        return;
+    }
+    mChangesPending = false;
+    const auto changes = std::exchange(mChanges, {});
+    emit modelChanged(changes);
+}
+
 /**
  * @brief Save all machine items into QVariantList
  *
@@ -139,6 +585,7 @@ void MachineListModel::restore(const QVariantList &machines)
             qCritical() << "Invalid machine config:" << machine;
         }
     }
+    rebuildIndex();
     endResetModel();
 }
 
@@ -171,12 +618,14 @@ int MachineListModel::rowCount(const QModelIndex &parent) const
  * - For `Qt::DecorationRole` we return Machine icon
  * - For `Qt::DisplayRole` we return Machine name
  * - For `MachineListModel::SummaryRole` we return Machine summary
+ * - For `MachineListModel::IconTypeRole` we return Machine icon type
+ * - For `MachineListModel::IconNameRole` we return Machine icon name
  * 
  * For all other cases, an invalid variant is returned.
  * 
  * @param[in] index   Get data from this index
  * @param[in] role    Get data using this role
- * @return Machine icon, name, summary or invalid variant
+ * @return Machine icon, name, summary, icon key or invalid variant
  */
 QVariant MachineListModel::data(const QModelIndex &index, int role) const
 {
@@ -188,20 +637,34 @@ QVariant MachineListModel::data(const QModelIndex &index, int role) const
         return {};
     }
 
-    switch (role) {
-    case Qt::DecorationRole:
-        return machineForIndex(index).icon();
-
-    case Qt::DisplayRole:
-        return machineForIndex(index).name();
+    return roleData(mMachines.at(index.row()), role);
+}
 
-    case SummaryRole:
-        return machineForIndex(index).summary();
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+/**
+ * @brief Get item data for several roles at once
+ *
+ * Views and delegates use this to get all roles they need for an item
+ * with one call. The machine is looked up once for all roles.
+ *
+ * @param[in] index          Get data from this index
+ * @param[in] roleDataSpan   Roles to fill, see @ref data for the roles
+ */
+void MachineListModel::multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= mMachines.size()) {
+        for (auto &roleData : roleDataSpan) {
+            roleData.clearData();
+        }
+        return;
+    }
 
-    default:
-        return {};
+    const auto &machine = mMachines.at(index.row());
+    for (auto &data : roleDataSpan) {
+        data.setData(roleData(machine, data.role()));
     }
 }
+#endif
 
 /**
  * @brief Model headers
@@ -256,30 +719,34 @@ QStringList MachineListModel::mimeTypes() const
 /**
  * @brief Construct MIME data for machines from the *indexes*
  *
- * This function creates a QVariantList of machines from the given
- * *indexes*.  The list is then converted to JSON and returned as a
- * MIME data object.
+ * This function collects the rows of the given *indexes* in the model
+ * order, and returns them as a MachineMimeData object. The machines
+ * are converted into JSON only if the data is dropped outside of this
+ * model.
  * 
  * @param[in] indexes   Get MIME data for these machines
  * @return MIME data for requested machines
  */
 QMimeData *MachineListModel::mimeData(const QModelIndexList &indexes) const
 {
-    if (indexes.isEmpty()) {
-        return {};
-    }
-
-    QVariantList list;
+    QList<int> rows;
     for (const auto &index : indexes) {
-        if (index.isValid()) {
-            list.append(machineForIndex(index).save());
+        if (index.isValid() && index.row() < mMachines.size()) {
+            rows.append(index.row());
         }
     }
+    if (rows.isEmpty()) {
+        return {};
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
 
-    const auto json = QJsonDocument::fromVariant(list).toJson(QJsonDocument::Compact);
-    auto *mimeData = new QMimeData;
-    mimeData->setData(jsonMimeType, json);
-    return mimeData;
+    QList<Machine> machines;
+    machines.reserve(rows.size());
+    for (const auto row : rows) {
+        machines.append(mMachines.at(row));
+    }
+    return new MachineMimeData(this, rows, machines);
 }
 
 /**
@@ -331,9 +798,15 @@ bool MachineListModel::canDropMimeData(const QMimeData *data,
  * @brief Handle dropped MIME data.
  *
  * The method checks that data can be accepted with the 
- * @ref canDropMimeData. It then decodes JSON data from the dropped
- * MIME data. The decoded JSON is converted to Machine items and
- * inserted into the drop location.
+ * @ref canDropMimeData.
+ *
+ * Machines dragged from this model are moved to the drop location with
+ * @ref moveMachines. In that case, `false` is returned, so that the
+ * view does not remove the dragged rows afterwards.
+ *
+ * Otherwise, the method decodes JSON data from the dropped MIME data.
+ * The decoded JSON is converted to Machine items and inserted into the
+ * drop location.
  * 
  * @param[in] data     Dropped MIME data
  * @param[in] action   Drop action
@@ -342,7 +815,7 @@ bool MachineListModel::canDropMimeData(const QMimeData *data,
  * @param[in] parent   Parent index where data was dropped
  * 
  * @return `true` if data was accepted and inserted into the model,
- *         `false` otherwise 
+ *         `false` if it was moved inside the model or rejected
  */
 bool MachineListModel::dropMimeData(
     const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent)
@@ -351,6 +824,23 @@ bool MachineListModel::dropMimeData(
         return false;
     }
 
+    // Find insert position
+    int first = 0;
+    if (row != -1) {
+        first = row;
+    } else if (parent.isValid()) {
+        first = parent.row();
+    } else {
+        first = static_cast<int>(mMachines.size());
+    }
+
+    // Machines dragged inside this model are moved
+    const auto *machineData = qobject_cast<const MachineMimeData *>(data);
+    if (machineData != nullptr && machineData->model() == this) {
+        moveDraggedMachines(machineData->rows(), first);
+        return false;
+    }
+
     // Decode JSON data
     const auto json = data->data(jsonMimeType);
     QJsonParseError error{};
@@ -367,23 +857,16 @@ bool MachineListModel::dropMimeData(
         machines.append(Machine(machineVariant.toMap()));
     }
 
-    // Find insert position
-    int first = 0;
-    if (row != -1) {
-        first = row;
-    } else if (parent.isValid()) {
-        first = parent.row();
-    } else {
-        first = static_cast<int>(mMachines.size());
-    }
-
     // Insert machines
-    beginInsertRows({}, first, first + static_cast<int>(machines.size()) - 1);
-    for (const auto &machine : machines) {
-        mMachines.insert(first, machine);
-        ++first;
+    QList<int> rows;
+    for (int i = 0; i < machines.size(); ++i) {
+        rows.append(first + i);
+    }
+    if (mUndoStack != nullptr) {
+        mUndoStack->push(new InsertMachinesCommand(this, rows, machines));
+    } else {
+        insertMachines(rows, machines);
     }
-    endInsertRows();
 
     return true;
 }
@@ -420,16 +903,313 @@ bool MachineListModel::removeRows(int row, int count, const QModelIndex &parent)
         return false;
     }
     beginRemoveRows({}, row, row + count - 1);
+    unindexRows(row, row + count - 1);
 #if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
     auto it = mMachines.begin() + row;
 #else
     auto it = mMachines.constBegin() + row;
 #endif
     mMachines.erase(it, it + count);
+    indexRows(row);
     endRemoveRows();
     return true;
 }
 
+/**
+ * @brief Move machines inside the model
+ *
+ * The *count* machines starting from *sourceRow* are moved before the
+ * *destinationChild* row with one rows moved signal.
+ *
+ * @param[in] sourceParent        Parent index of the moved rows (should be invalid)
+ * @param[in] sourceRow           First row to move
+ * @param[in] count               How many machines to move
+ * @param[in] destinationParent   Parent index of the destination (should be invalid)
+ * @param[in] destinationChild    Move machines before this row
+ *
+ * @return `true` if machines were moved, `false` if the move is not possible
+ *
+ * @see MachineListModel::moveMachines
+ */
+bool MachineListModel::moveRows(const QModelIndex &sourceParent,
+                                int sourceRow,
+                                int count,
+                                const QModelIndex &destinationParent,
+                                int destinationChild)
+{
+    if (sourceParent.isValid() || destinationParent.isValid() || count <= 0 || sourceRow < 0
+        || (sourceRow + count) > mMachines.size() || destinationChild < 0
+        || destinationChild > mMachines.size()) {
+        return false;
+    }
+    if (!beginMoveRows({}, sourceRow, sourceRow + count - 1, {}, destinationChild)) {
+        return false;
+    }
+    auto begin = mMachines.begin();
+    if (destinationChild < sourceRow) {
+        std::rotate(begin + destinationChild, begin + sourceRow, begin + sourceRow + count);
+        indexRows(destinationChild, sourceRow + count - 1);
+    } else {
+        std::rotate(begin + sourceRow, begin + sourceRow + count, begin + destinationChild);
+        indexRows(sourceRow, destinationChild - 1);
+    }
+    endMoveRows();
+    return true;
+}
+
+/**
+ * @brief Machines were changed in the model
+ *
+ * Machines in the range are recorded as updated, unless they were
+ * inserted during the same turn.
+ *
+ * @param[in] topLeft       First changed machine
+ * @param[in] bottomRight   Last changed machine
+ */
+void MachineListModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const auto &id = mMachines.at(row).id();
+        if (!mChanges.inserted.contains(id)) {
+            mChanges.updated.insert(id);
+        }
+    }
+    scheduleChanges(ChangeSet::Updated);
+}
+
+/**
+ * @brief Machines were reordered in the model
+ */
+void MachineListModel::onLayoutChanged()
+{
+    scheduleChanges(ChangeSet::Reordered);
+}
+
+/**
+ * @brief The whole model was reset
+ *
+ * Machines recorded before the reset no longer matter.
+ */
+void MachineListModel::onModelReset()
+{
+    mChanges = {};
+    scheduleChanges(ChangeSet::Reset);
+}
+
+/**
+ * @brief Machines are about to be moved in the model
+ * @param[in] first   Row of the first machine to move
+ * @param[in] last    Row of the last machine to move
+ */
+void MachineListModel::onRowsAboutToBeMoved(const QModelIndex & /*parent*/, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        const auto &id = mMachines.at(row).id();
+        if (!mChanges.inserted.contains(id)) {
+            mChanges.moved.insert(id);
+        }
+    }
+    scheduleChanges(ChangeSet::Moved);
+}
+
+/**
+ * @brief Machines are about to be removed from the model
+ * @param[in] first   Row of the first machine to remove
+ * @param[in] last    Row of the last machine to remove
+ */
+void MachineListModel::onRowsAboutToBeRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        recordRemoved(mMachines.at(row).id());
+    }
+    scheduleChanges(ChangeSet::Removed);
+}
+
+/**
+ * @brief Machines were inserted into the model
+ * @param[in] first   Row of the first inserted machine
+ * @param[in] last    Row of the last inserted machine
+ */
+void MachineListModel::onRowsInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        recordInserted(mMachines.at(row).id());
+    }
+    scheduleChanges(ChangeSet::Inserted);
+}
+
+/**
+ * @brief Record the machine with the *id* as inserted
+ *
+ * A machine removed earlier in the same turn is put back, so it is
+ * recorded as updated instead.
+ *
+ * @param[in] id   ID of the inserted machine
+ */
+void MachineListModel::recordInserted(const QUuid &id)
+{
+    if (mChanges.removed.remove(id)) {
+        mChanges.updated.insert(id);
+    } else {
+        mChanges.inserted.insert(id);
+    }
+}
+
+/**
+ * @brief Record the machine with the *id* as removed
+ *
+ * A machine inserted earlier in the same turn is forgotten, as if it
+ * had never been there.
+ *
+ * @param[in] id   ID of the removed machine
+ */
+void MachineListModel::recordRemoved(const QUuid &id)
+{
+    mChanges.moved.remove(id);
+    if (!mChanges.inserted.remove(id)) {
+        mChanges.updated.remove(id);
+        mChanges.removed.insert(id);
+    }
+}
+
+/**
+ * @brief Add the *kind* to the change set and schedule sending it
+ *
+ * The change set is sent with @ref modelChanged when control returns
+ * to the event loop, so all changes of the turn go out together.
+ *
+ * @param[in] kind   Kind of the recorded change
+ */
+void MachineListModel::scheduleChanges(ChangeSet::Kind kind)
+{
+    mChanges.kinds |= kind;
+    if (!mChangesPending) {
+        mChangesPending = true;
+        QMetaObject::invokeMethod(this, &MachineListModel::flushChanges, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief Item data of the *machine* for the *role*
+ * @param[in] machine   Get data from this machine
+ * @param[in] role      Get data using this role
+ * @return Machine icon, name, summary, icon key or invalid variant
+ */
+QVariant MachineListModel::roleData(const Machine &machine, int role)
+{
+    switch (role) {
+    case Qt::DecorationRole:
+        return machine.icon();
+
+    case Qt::DisplayRole:
+        return machine.name();
+
+    case SummaryRole:
+        return machine.summary();
+
+    case IconTypeRole:
+        return QVariant::fromValue(machine.iconType());
+
+    case IconNameRole:
+        return machine.iconName();
+
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief Give new IDs to machines whose ID is already used
+ *
+ * IDs are checked against the model and the other *machines*, so
+ * adding copies of a machine does not make the IDs ambiguous.
+ *
+ * @param[in] machines   Machines to be added to the model
+ * @return The *machines* with unique IDs
+ */
+QList<Machine> MachineListModel::withUniqueIds(QList<Machine> machines) const
+{
+    QSet<QUuid> added;
+    for (auto &machine : machines) {
+        if (mRows.contains(machine.id()) || added.contains(machine.id())) {
+            machine.setId(QUuid::createUuid());
+        }
+        added.insert(machine.id());
+    }
+    return machines;
+}
+
+/**
+ * @brief Replace the machine at the *row* and update its ID in the index
+ * @param[in] row       Row of the replaced machine
+ * @param[in] machine   New machine for the row
+ */
+void MachineListModel::replaceAt(int row, Machine machine)
+{
+    const auto oldId = mMachines.at(row).id();
+    if (machine.id() != oldId) {
+        mRows.remove(oldId);
+        if (mRows.contains(machine.id())) {
+            machine.setId(QUuid::createUuid());
+        }
+        mRows.insert(machine.id(), row);
+        recordRemoved(oldId);
+        recordInserted(machine.id());
+        scheduleChanges(ChangeSet::Removed);
+        scheduleChanges(ChangeSet::Inserted);
+    }
+    mMachines[row] = machine;
+}
+
+/**
+ * @brief Update the rows of machines from *first* to *last* in the index
+ *
+ * This is called for the rows shifted or moved by a change, so the
+ * rest of the index is left as it is.
+ *
+ * @param[in] first   First row to update
+ * @param[in] last    Last row to update, or -1 for the last row of the model
+ */
+void MachineListModel::indexRows(int first, int last)
+{
+    if (last < 0 || last >= mMachines.size()) {
+        last = static_cast<int>(mMachines.size()) - 1;
+    }
+    for (int row = first; row <= last; ++row) {
+        mRows.insert(mMachines.at(row).id(), row);
+    }
+}
+
+/**
+ * @brief Remove the machines from *first* to *last* from the index
+ * @param[in] first   First row to remove
+ * @param[in] last    Last row to remove
+ */
+void MachineListModel::unindexRows(int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        mRows.remove(mMachines.at(row).id());
+    }
+}
+
+/**
+ * @brief Build the index again for all machines
+ *
+ * This is used when the whole list is replaced. Machines with an ID
+ * already used by an earlier machine get a new ID.
+ */
+void MachineListModel::rebuildIndex()
+{
+    mRows.clear();
+    mRows.reserve(static_cast<int>(mMachines.size()));
+    for (int row = 0; row < mMachines.size(); ++row) {
+        if (mRows.contains(mMachines.at(row).id())) {
+            mMachines[row].setId(QUuid::createUuid());
+        }
+        mRows.insert(mMachines.at(row).id(), row);
+    }
+}
+
 /**
  * @brief Item flags for given *index*
  * 
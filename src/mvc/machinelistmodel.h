@@ -10,9 +10,14 @@
 #define MACHINELISTMODEL_H
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QList>
+#include <QSet>
+#include <QUuid>
 #include "data/machine.h"
 
+class QUndoStack;
+
 /**
  * @brief List model of Machine items
  *
@@ -20,13 +25,38 @@
  * - `Qt::DecorationRole`            -> Machine icon
  * - `Qt::DisplayRole`               -> Machine name
  * - `MachineListModel::SummaryRole` -> Machine summary
+ * - `MachineListModel::IconTypeRole` -> Machine icon type
+ * - `MachineListModel::IconNameRole` -> Machine icon name
  * 
  * In addition, @ref machineForIndex allows the Machine object to be
- * retrieved from the given index.
+ * retrieved from the given index, @ref machineAt gives a reference to
+ * the machine without copying it, and @ref indexForId finds the index
+ * of a machine by its ID. The model keeps a hash from machine IDs to
+ * rows, and only the rows shifted by a change are updated in it. Each
+ * machine in the model has a unique ID, and machines added with an ID
+ * already in the model get a new ID.
  * 
- * A @ref modelChanged signal is sent for any changes to the model.
- * Main window uses this signal to know when machine configurations 
- * should be written into the file.
+ * Machines dragged inside the model are moved with
+ * @ref moveDraggedMachines, so they are not copied. JSON is used only for dropping machines from
+ * other applications.
+ *
+ * Machines can be added, removed and replaced in batches. Rows of a
+ * batch are merged into contiguous ranges with one signal per range.
+ *
+ * Item data is read through references to the machines, so no machine
+ * or string is copied until the value is put into a QVariant. On Qt 6,
+ * @ref multiData fills all requested roles of an item with one call.
+ *
+ * Changes can be made undoable with the commands in machinecommands.h,
+ * which use the batch functions of the model. Drops are pushed to the
+ * @ref setUndoStack "undo stack" when one is set.
+ *
+ * Changes to the model are collected into a ChangeSet, which has the
+ * IDs of the affected machines grouped by the kind of change. The
+ * @ref modelChanged signal is sent with the change set once per event
+ * loop turn, however many row signals the changes took. Main window
+ * uses this signal to know when machine configurations should be
+ * written into the file.
  */
 class MachineListModel : public QAbstractListModel
 {
@@ -38,31 +68,89 @@ public:
      * @brief Custom item roles for this model
      */
     enum ItemRole {
-        SummaryRole = Qt::UserRole + 1 /*!< @brief The summary data for the machine. (QString) */
+        SummaryRole = Qt::UserRole + 1, /*!< @brief The summary data for the machine. (QString) */
+        IconTypeRole,                   /*!< @brief Icon type of the machine. (Machine::IconType) */
+        IconNameRole                    /*!< @brief Icon name of the machine. (QString) */
     };
     Q_ENUM(ItemRole); /*!< @brief Registering ItemRole to meta-object system */
 
+    /**
+     * @brief Changes made to the model during one event loop turn
+     *
+     * Each machine ID is in at most one of the sets, and the sets tell
+     * the net effect of the turn. A machine inserted and removed in the
+     * same turn is in neither, and a machine removed and put back is
+     * updated. *kinds* has every kind of change seen in the turn.
+     *
+     * Reordering and reset do not list machines. After a reset, every
+     * machine should be considered changed.
+     */
+    struct ChangeSet
+    {
+        /**
+         * @brief Kinds of changes
+         */
+        enum Kind {
+            Inserted = 0x01,  /*!< @brief Machines were inserted */
+            Updated = 0x02,   /*!< @brief Machines were replaced or edited */
+            Removed = 0x04,   /*!< @brief Machines were removed */
+            Moved = 0x08,     /*!< @brief Contiguous rows were moved */
+            Reordered = 0x10, /*!< @brief The order of the machines changed in one step */
+            Reset = 0x20      /*!< @brief The whole model was reset */
+        };
+        Q_DECLARE_FLAGS(Kinds, Kind)
+
+        Kinds kinds;          /*!< @brief Kinds of changes seen */
+        QSet<QUuid> inserted; /*!< @brief IDs of machines inserted */
+        QSet<QUuid> updated;  /*!< @brief IDs of machines replaced or edited */
+        QSet<QUuid> removed;  /*!< @brief IDs of machines removed */
+        QSet<QUuid> moved;    /*!< @brief IDs of machines in moved rows */
+
+        [[nodiscard]] bool isEmpty() const;
+    };
+
     explicit MachineListModel(QObject *parent = nullptr);
     ~MachineListModel() override;
 
     void addMachine(const Machine &machine);
+    void addMachines(const QList<Machine> &machines);
+    void insertMachines(const QList<int> &rows, const QList<Machine> &machines);
     [[nodiscard]] Machine machineForIndex(const QModelIndex &index) const;
+    [[nodiscard]] const Machine &machineAt(int row) const;
+    [[nodiscard]] QModelIndex indexForId(const QUuid &id) const;
     void setMachineForIndex(const QModelIndex &index, const Machine &machine);
     void remove(const QModelIndex &index);
+    void removeMachines(const QModelIndexList &indexes);
+    void replaceMachines(const QModelIndexList &indexes, const QList<Machine> &machines);
+    [[nodiscard]] QList<Machine> machines() const;
+    void setMachines(const QList<Machine> &machines);
+    bool moveMachines(const QList<int> &rows, int destination);
+    void moveDraggedMachines(const QList<int> &rows, int destination);
+    bool reorderMachines(const QList<int> &order);
+    [[nodiscard]] static QList<int> moveOrder(const QList<int> &rows, int destination, int rowCount);
+
+    [[nodiscard]] QUndoStack *undoStack() const;
+    void setUndoStack(QUndoStack *stack);
+
+    void flushChanges();
 
     [[nodiscard]] QVariantList save() const;
     void restore(const QVariantList &machines);
 
 signals:
     /**
-     * @brief This model was just modified
+     * @brief This model was modified during the last event loop turn
+     * @param[in] changes   Machines affected by the changes
      */
-    void modelChanged();
+    void modelChanged(const MachineListModel::ChangeSet &changes);
 
     // QAbstractItemModel interface
 public:
     [[nodiscard]] int rowCount(const QModelIndex &parent) const override;
     [[nodiscard]] QVariant data(const QModelIndex &index, int role) const override;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const override;
+#endif
     [[nodiscard]] QVariant headerData(int section,
                                       Qt::Orientation orientation,
                                       int role) const override;
@@ -80,10 +168,38 @@ public:
                                     const QModelIndex &parent) override;
     [[nodiscard]] Qt::DropActions supportedDropActions() const override;
     [[nodiscard]] bool removeRows(int row, int count, const QModelIndex &parent) override;
+    bool moveRows(const QModelIndex &sourceParent,
+                  int sourceRow,
+                  int count,
+                  const QModelIndex &destinationParent,
+                  int destinationChild) override;
     [[nodiscard]] Qt::ItemFlags flags(const QModelIndex &index) const override;
 
 private:
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onLayoutChanged();
+    void onModelReset();
+    void onRowsAboutToBeMoved(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void recordInserted(const QUuid &id);
+    void recordRemoved(const QUuid &id);
+    void scheduleChanges(ChangeSet::Kind kind);
+    [[nodiscard]] static QVariant roleData(const Machine &machine, int role);
+    [[nodiscard]] QList<Machine> withUniqueIds(QList<Machine> machines) const;
+    void replaceAt(int row, Machine machine);
+    void indexRows(int first, int last = -1);
+    void unindexRows(int first, int last);
+    void rebuildIndex();
+
     QList<Machine> mMachines; /*!< @brief Data for the model */
+    QHash<QUuid, int> mRows;  /*!< @brief Rows of the machines by their IDs */
+    QUndoStack *mUndoStack{}; /*!< @brief Undo stack for drops, or `nullptr` */
+    ChangeSet mChanges;       /*!< @brief Changes waiting for @ref modelChanged */
+    bool mChangesPending{};   /*!< @brief Sending @ref modelChanged has been scheduled */
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(MachineListModel::ChangeSet::Kinds)
+Q_DECLARE_METATYPE(MachineListModel::ChangeSet)
+
 #endif // MACHINELISTMODEL_H
@@ -0,0 +1,80 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinelistview.cpp
+ * @brief MachineListView class implementation
+ */
+
+#include "machinelistview.h"
+#include "machinelistmodel.h"
+#include "machinemimedata.h"
+
+#include <QAbstractProxyModel>
+#include <QDropEvent>
+
+/**
+ * @brief Construct machine list view
+ * @param[in] parent   Pointer to the parent widget
+ */
+MachineListView::MachineListView(QWidget *parent)
+    : QListView{parent}
+{}
+
+MachineListView::~MachineListView() = default;
+
+/**
+ * @brief Handle dropped data
+ *
+ * Machines dragged from this view are moved before the item under the
+ * drop indicator, or to the end when dropped below the items. The move
+ * goes through the undo stack of the model, if it has one. The drop
+ * action is changed to copy, so that the drag source does not remove
+ * the moved rows afterwards.
+ *
+ * The view may show the machine model through proxy models, such as
+ * the MachineFilterModel. The drop position is then mapped to the
+ * machine model.
+ *
+ * Other drops are handled by QListView.
+ *
+ * @param[in] event   Drop event
+ */
+void MachineListView::dropEvent(QDropEvent *event)
+{
+    // Find the machine model behind proxy models
+    auto *sourceModel = model();
+    while (auto *proxy = qobject_cast<QAbstractProxyModel *>(sourceModel)) {
+        sourceModel = proxy->sourceModel();
+    }
+    auto *machineModel = qobject_cast<MachineListModel *>(sourceModel);
+    const auto *data = qobject_cast<const MachineMimeData *>(event->mimeData());
+    if (event->source() != this || machineModel == nullptr || data == nullptr
+        || data->model() != machineModel) {
+        QListView::dropEvent(event);
+        return;
+    }
+
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+    auto index = indexAt(event->pos());
+#else
+    auto index = indexAt(event->position().toPoint());
+#endif
+    while (const auto *proxy = qobject_cast<const QAbstractProxyModel *>(index.model())) {
+        index = proxy->mapToSource(index);
+    }
+    auto destination = machineModel->rowCount({});
+    if (index.isValid() && dropIndicatorPosition() != QAbstractItemView::OnViewport) {
+        destination = index.row();
+        if (dropIndicatorPosition() == QAbstractItemView::BelowItem) {
+            ++destination;
+        }
+    }
+    machineModel->moveDraggedMachines(data->rows(), destination);
+
+    event->setDropAction(Qt::CopyAction);
+    event->accept();
+    stopAutoScroll();
+    setState(NoState);
+    viewport()->update();
+}
@@ -0,0 +1,35 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinelistview.h
+ * @brief MachineListView class definition
+ */
+
+#ifndef MACHINELISTVIEW_H
+#define MACHINELISTVIEW_H
+
+#include <QListView>
+
+/**
+ * @brief List view for the MachineListModel
+ *
+ * QListView moves dropped rows one at a time with moveRow(). This view
+ * moves all machines dragged inside the view at once with
+ * MachineListModel::moveMachines(), so that the whole selection is
+ * moved with one change to the model.
+ */
+class MachineListView : public QListView
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineListView)
+
+public:
+    explicit MachineListView(QWidget *parent = nullptr);
+    ~MachineListView() override;
+
+protected:
+    void dropEvent(QDropEvent *event) override;
+};
+
+#endif // MACHINELISTVIEW_H
@@ -0,0 +1,105 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinemimedata.cpp
+ * @brief MachineMimeData class implementation
+ */
+
+#include "machinemimedata.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+/**
+ * @brief Construct MIME data for dragged machines
+ * @param[in] model      Model the machines are dragged from
+ * @param[in] rows       Dragged rows in the *model*
+ * @param[in] machines   Machines from the *rows*
+ */
+MachineMimeData::MachineMimeData(const QAbstractItemModel *model,
+                                 const QList<int> &rows,
+                                 const QList<Machine> &machines)
+    : mModel(model)
+    , mRows(rows)
+    , mMachines(machines)
+{}
+
+MachineMimeData::~MachineMimeData() = default;
+
+/**
+ * @brief Source model getter
+ * @return Model the machines were dragged from
+ */
+const QAbstractItemModel *MachineMimeData::model() const
+{
+    return mModel;
+}
+
+/**
+ * @brief Dragged rows getter
+ * @return Rows of the dragged machines in the source model
+ */
+QList<int> MachineMimeData::rows() const
+{
+    return mRows;
+}
+
+/**
+ * @brief Dragged machines getter
+ * @return Dragged machines in the same order as @ref rows
+ */
+QList<Machine> MachineMimeData::machines() const
+{
+    return mMachines;
+}
+
+/**
+ * @brief Formats available from this object
+ * @return `"application/json"`
+ */
+QStringList MachineMimeData::formats() const
+{
+    return {JSON_MIME_TYPE};
+}
+
+/**
+ * @brief Check if the data is available in the *mimeType*
+ * @param[in] mimeType   MIME type to check
+ * @return `true` for `"application/json"`, `false` otherwise
+ */
+bool MachineMimeData::hasFormat(const QString &mimeType) const
+{
+    return mimeType == QLatin1String(JSON_MIME_TYPE);
+}
+
+/**
+ * @brief Convert machines into the requested format
+ *
+ * The JSON is made only when it is first asked for. Drops inside the
+ * same model use @ref rows instead, and never convert the machines.
+ *
+ * @param[in] mimeType        Requested MIME type
+ * @param[in] preferredType   Preferred type for the data (not used)
+ * @return Machines as compact JSON, or invalid QVariant for other types
+ */
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+QVariant MachineMimeData::retrieveData(const QString &mimeType,
+                                       QVariant::Type /*preferredType*/) const
+#else
+QVariant MachineMimeData::retrieveData(const QString &mimeType, QMetaType /*preferredType*/) const
+#endif
+{
+    if (!hasFormat(mimeType)) {
+        return {};
+    }
+    if (mJson.isEmpty()) {
+        QJsonArray array;
+        for (const auto &machine : mMachines) {
+            array.append(QJsonObject::fromVariantMap(machine.save()));
+        }
+        mJson = QJsonDocument(array).toJson(QJsonDocument::Compact);
+    }
+    return mJson;
+}
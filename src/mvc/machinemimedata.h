@@ -0,0 +1,64 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinemimedata.h
+ * @brief MachineMimeData class definition
+ */
+
+#ifndef MACHINEMIMEDATA_H
+#define MACHINEMIMEDATA_H
+
+#include <QList>
+#include <QMimeData>
+#include "data/machine.h"
+
+class QAbstractItemModel;
+
+/**
+ * @brief MIME data for dragging machines
+ *
+ * Dragging machines inside the list only needs the dragged rows, so
+ * this object keeps the source model and the rows. The machines are
+ * kept as implicitly shared copies, and they are converted into JSON
+ * only if another application asks for the data.
+ */
+class MachineMimeData : public QMimeData
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineMimeData)
+
+public:
+    static constexpr const char *JSON_MIME_TYPE = "application/json"; /*!< @brief MIME type for JSON */
+
+    MachineMimeData(const QAbstractItemModel *model,
+                    const QList<int> &rows,
+                    const QList<Machine> &machines);
+    ~MachineMimeData() override;
+
+    [[nodiscard]] const QAbstractItemModel *model() const;
+    [[nodiscard]] QList<int> rows() const;
+    [[nodiscard]] QList<Machine> machines() const;
+
+    // QMimeData interface
+public:
+    [[nodiscard]] QStringList formats() const override;
+    [[nodiscard]] bool hasFormat(const QString &mimeType) const override;
+
+protected:
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+    [[nodiscard]] QVariant retrieveData(const QString &mimeType,
+                                        QVariant::Type preferredType) const override;
+#else
+    [[nodiscard]] QVariant retrieveData(const QString &mimeType,
+                                        QMetaType preferredType) const override;
+#endif
+
+private:
+    const QAbstractItemModel *mModel; /*!< @brief Model the machines were dragged from */
+    QList<int> mRows;                 /*!< @brief Dragged rows in the source model */
+    QList<Machine> mMachines;         /*!< @brief Dragged machines in the row order */
+    mutable QByteArray mJson;         /*!< @brief Machines as JSON, made when first asked */
+};
+
+#endif // MACHINEMIMEDATA_H
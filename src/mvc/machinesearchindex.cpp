@@ -0,0 +1,207 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinesearchindex.cpp
+ * @brief MachineSearchIndex class implementation
+ */
+
+#include "machinesearchindex.h"
+
+#include <algorithm>
+
+/**
+ * @brief Construct an empty index
+ */
+MachineSearchIndex::MachineSearchIndex() = default;
+
+/**
+ * @brief Replace all entries
+ * @param[in] machines   Machines in the row order
+ */
+void MachineSearchIndex::reset(const QList<Machine> &machines)
+{
+    mEntries.clear();
+    insert(0, machines);
+}
+
+/**
+ * @brief Insert entries for new rows
+ * @param[in] row        Row of the first inserted machine
+ * @param[in] machines   Inserted machines
+ */
+void MachineSearchIndex::insert(int row, const QList<Machine> &machines)
+{
+    QList<Entry> entries;
+    entries.reserve(machines.size());
+    for (const auto &machine : machines) {
+        entries.append(makeEntry(machine));
+    }
+    if (row >= mEntries.size()) {
+        mEntries.append(entries);
+    } else {
+        mEntries = mEntries.mid(0, row) + entries + mEntries.mid(row);
+    }
+}
+
+/**
+ * @brief Remove entries of removed rows
+ * @param[in] row     First removed row
+ * @param[in] count   Number of removed rows
+ */
+void MachineSearchIndex::remove(int row, int count)
+{
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+    auto first = mEntries.begin() + row;
+#else
+    auto first = mEntries.constBegin() + row;
+#endif
+    mEntries.erase(first, first + count);
+}
+
+/**
+ * @brief Move entries of moved rows
+ * @param[in] row           First moved row
+ * @param[in] count         Number of moved rows
+ * @param[in] destination   Rows were moved before this row
+ */
+void MachineSearchIndex::move(int row, int count, int destination)
+{
+    auto begin = mEntries.begin();
+    if (destination < row) {
+        std::rotate(begin + destination, begin + row, begin + row + count);
+    } else {
+        std::rotate(begin + row, begin + row + count, begin + destination);
+    }
+}
+
+/**
+ * @brief Replace entries of modified rows
+ * @param[in] row        Row of the first modified machine
+ * @param[in] machines   New content for the rows
+ */
+void MachineSearchIndex::update(int row, const QList<Machine> &machines)
+{
+    for (int i = 0; i < machines.size(); ++i) {
+        mEntries[row + i] = makeEntry(machines.at(i));
+    }
+}
+
+/**
+ * @brief Number of entries
+ * @return Number of rows in the index
+ */
+int MachineSearchIndex::size() const
+{
+    return static_cast<int>(mEntries.size());
+}
+
+/**
+ * @brief Query getter
+ * @return Current query as it was given
+ */
+QString MachineSearchIndex::query() const
+{
+    return mQuery;
+}
+
+/**
+ * @brief Set the query used by @ref matches
+ *
+ * The query is split into words. A row matches when its key contains
+ * all words. An empty query matches all rows.
+ *
+ * @param[in] query   Text the user searched for
+ */
+void MachineSearchIndex::setQuery(const QString &query)
+{
+    mQuery = query;
+    mTerms.clear();
+    mQueryMask = 0;
+    const auto simplified = normalize(query).simplified();
+    if (simplified.isEmpty()) {
+        return;
+    }
+    mTerms = simplified.split(QLatin1Char(' '));
+    mQueryMask = characterMask(simplified);
+}
+
+/**
+ * @brief Check if the *row* matches the query
+ * @param[in] row   Row to check
+ * @return `true` if the row matches, or the query is empty
+ */
+bool MachineSearchIndex::matches(int row) const
+{
+    if (mTerms.isEmpty()) {
+        return true;
+    }
+    if (row < 0 || row >= mEntries.size()) {
+        return false;
+    }
+
+    const auto &entry = mEntries.at(row);
+    if ((entry.mask & mQueryMask) != mQueryMask) {
+        return false;
+    }
+    return std::all_of(mTerms.cbegin(), mTerms.cend(), [&entry](const QString &term) {
+        return entry.key.contains(term);
+    });
+}
+
+/**
+ * @brief Normalize text for searching
+ *
+ * The text is decomposed, accents and other combining marks are
+ * dropped, and the rest is case folded. For example, `"Pentium Ⅱ"`
+ * and `"pentium ii"` have the same normalized form.
+ *
+ * @param[in] text   Text to normalize
+ * @return Normalized text
+ */
+QString MachineSearchIndex::normalize(const QString &text)
+{
+    const auto decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString normalized;
+    normalized.reserve(decomposed.size());
+    for (const auto character : decomposed) {
+        if (character.category() != QChar::Mark_NonSpacing) {
+            normalized.append(character.toCaseFolded());
+        }
+    }
+    return normalized;
+}
+
+/**
+ * @brief Make the search entry for the *machine*
+ * @param[in] machine   Machine to index
+ * @return Entry with the search key and its character mask
+ */
+MachineSearchIndex::Entry MachineSearchIndex::makeEntry(const Machine &machine)
+{
+    QStringList parts = {machine.name(), machine.summary(), machine.configFile()};
+    const auto extraVariables = machine.extraVariables();
+    for (auto it = extraVariables.cbegin(); it != extraVariables.cend(); ++it) {
+        parts.append(it.value().toString());
+    }
+    Entry entry;
+    entry.key = normalize(parts.join(QLatin1Char('\n')));
+    entry.mask = characterMask(entry.key);
+    return entry;
+}
+
+/**
+ * @brief Make a mask of the letters and numbers in the *text*
+ * @param[in] text   Normalized text
+ * @return Mask with one bit for each character, modulo 64
+ */
+quint64 MachineSearchIndex::characterMask(const QString &text)
+{
+    quint64 mask = 0;
+    for (const auto character : text) {
+        if (character.isLetterOrNumber()) {
+            mask |= quint64(1) << (character.unicode() % 64);
+        }
+    }
+    return mask;
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinesearchindex.h
+ * @brief MachineSearchIndex class definition
+ */
+
+#ifndef MACHINESEARCHINDEX_H
+#define MACHINESEARCHINDEX_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "data/machine.h"
+
+/**
+ * @brief In-memory search index for machines
+ *
+ * The index has one entry for each machine row. The entry has a search
+ * key made from the name, summary, configuration file and extra
+ * variables of the machine. The key is @ref normalize "normalized", so
+ * that searching ignores case and accents.
+ *
+ * Each key also has a 64-bit mask of the characters in it. Rows whose
+ * mask does not have all characters of the query are rejected without
+ * looking at the key at all.
+ *
+ * Keys are made once per machine when rows are inserted or updated,
+ * so a keystroke only compares the query against ready keys. Only the
+ * key and the mask are kept, not the machine. Machines restored lazily
+ * are loaded completely when they are indexed.
+ *
+ * The index does not follow any model by itself. The owner updates the
+ * rows with @ref insert, @ref remove, @ref move and @ref update.
+ */
+class MachineSearchIndex
+{
+public:
+    MachineSearchIndex();
+
+    void reset(const QList<Machine> &machines);
+    void insert(int row, const QList<Machine> &machines);
+    void remove(int row, int count);
+    void move(int row, int count, int destination);
+    void update(int row, const QList<Machine> &machines);
+    [[nodiscard]] int size() const;
+
+    [[nodiscard]] QString query() const;
+    void setQuery(const QString &query);
+    [[nodiscard]] bool matches(int row) const;
+
+    static QString normalize(const QString &text);
+
+private:
+    /**
+     * @brief Search data for one machine
+     */
+    struct Entry
+    {
+        QString key;    /*!< @brief Normalized search key */
+        quint64 mask{}; /*!< @brief Characters in the key */
+    };
+
+    static Entry makeEntry(const Machine &machine);
+    static quint64 characterMask(const QString &text);
+
+    QList<Entry> mEntries;         /*!< @brief Entries in the row order */
+    QString mQuery;                /*!< @brief Query as given */
+    QStringList mTerms;            /*!< @brief Normalized words of the query */
+    quint64 mQueryMask{};          /*!< @brief Characters in the query words */
+};
+
+#endif // MACHINESEARCHINDEX_H
@@ -0,0 +1,603 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinetreemodel.cpp
+ * @brief MachineTreeModel class implementation
+ */
+
+#include "machinetreemodel.h"
+#include "data/iconcache.h"
+
+#include <QHash>
+#include <QIcon>
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Number of rows exposed by one @ref MachineTreeModel::fetchMore call
+ */
+constexpr int FETCH_BATCH_SIZE = 256;
+
+} // namespace
+
+/**
+ * @brief Destroy the folder and its subfolders
+ */
+MachineTreeModel::Node::~Node()
+{
+    for (int i = 0; i < children.size(); ++i) {
+        delete children.at(i).folder;
+    }
+}
+
+/**
+ * @brief Construct an empty tree model
+ * @param[in] parent   Pointer to parent object
+ */
+MachineTreeModel::MachineTreeModel(QObject *parent)
+    : QAbstractItemModel{parent}
+    , mRoot(std::make_unique<Node>())
+{
+    connect(this, &MachineTreeModel::modelReset, this, &MachineTreeModel::modelChanged);
+    connect(this, &MachineTreeModel::rowsMoved, this, &MachineTreeModel::modelChanged);
+    connect(this, &MachineTreeModel::rowsRemoved, this, &MachineTreeModel::modelChanged);
+}
+
+MachineTreeModel::~MachineTreeModel() = default;
+
+/**
+ * @brief All machines in the model
+ *
+ * The machines are in their original list order, and their folder
+ * paths follow the moves made in the model.
+ *
+ * @return List of all machines
+ */
+QList<Machine> MachineTreeModel::machines() const
+{
+    return mMachines;
+}
+
+/**
+ * @brief Replace all machines in the model
+ *
+ * The folder tree is built from the `"folder"` extra variables of the
+ * *machines*, and the model is reset. No rows are fetched yet.
+ *
+ * @param[in] machines   New machines for the model
+ */
+void MachineTreeModel::setMachines(const QList<Machine> &machines)
+{
+    beginResetModel();
+    mMachines = machines;
+    mRoot = std::make_unique<Node>();
+
+    // Collect folders and machines
+    QHash<const Node *, QList<int>> folderMachines;
+    QHash<QPair<const Node *, QString>, Node *> folders;
+    for (int i = 0; i < mMachines.size(); ++i) {
+        const auto path = mMachines.at(i).extraVariables().value(FOLDER_VARIABLE).toString();
+        auto *node = mRoot.get();
+        for (const auto &name : path.split(QLatin1Char('/'))) {
+            if (name.isEmpty()) {
+                continue;
+            }
+            auto *&folder = folders[qMakePair(static_cast<const Node *>(node), name)];
+            if (folder == nullptr) {
+                folder = new Node;
+                folder->name = name;
+                folder->parent = node;
+                node->children.append({folder, -1});
+            }
+            node = folder;
+        }
+        folderMachines[node].append(i);
+        for (; node != nullptr; node = node->parent) {
+            ++node->machineCount;
+        }
+    }
+
+    // Sort subfolders by name and add machines after them
+    QList<Node *> pending = {mRoot.get()};
+    while (!pending.isEmpty()) {
+        auto *node = pending.takeLast();
+        std::sort(node->children.begin(), node->children.end(), [](const Child &a, const Child &b) {
+            return a.folder->name.localeAwareCompare(b.folder->name) < 0;
+        });
+        for (int i = 0; i < node->children.size(); ++i) {
+            pending.append(node->children.at(i).folder);
+        }
+        for (const auto machine : folderMachines.value(node)) {
+            node->children.append({nullptr, machine});
+        }
+    }
+    endResetModel();
+}
+
+/**
+ * @brief Get Machine item from the *index*
+ * @param[in] index   Get Machine from this index
+ * @return Machine item, or default machine for folders and invalid indexes
+ */
+Machine MachineTreeModel::machineForIndex(const QModelIndex &index) const
+{
+    const auto *child = childForIndex(index);
+    return child != nullptr && child->folder == nullptr ? mMachines.value(child->machine)
+                                                        : Machine();
+}
+
+/**
+ * @brief Check if the *index* is a folder
+ * @param[in] index   Index to check
+ * @return `true` for folders, `false` for machines and invalid indexes
+ */
+bool MachineTreeModel::isFolder(const QModelIndex &index) const
+{
+    const auto *child = childForIndex(index);
+    return child != nullptr && child->folder != nullptr;
+}
+
+/**
+ * @brief Number of machines in the folder at *index*
+ *
+ * The number is counted when the tree is built, so this does not
+ * depend on which rows have been fetched.
+ *
+ * @param[in] index   Folder index, or invalid index for the whole model
+ * @return Number of machines in the folder and its subfolders, 1 for machines
+ */
+int MachineTreeModel::machineCount(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return mRoot->machineCount;
+    }
+    const auto *child = childForIndex(index);
+    return child != nullptr ? countOf(*child) : 0;
+}
+
+/**
+ * @brief Folder path of the *index*
+ * @param[in] index   Folder or machine index
+ * @return Path of the folder, or the path of the folder containing the machine
+ */
+QString MachineTreeModel::folderPath(const QModelIndex &index) const
+{
+    const auto *child = childForIndex(index);
+    if (child == nullptr) {
+        return {};
+    }
+    return child->folder != nullptr ? pathOf(child->folder)
+                                    : pathOf(static_cast<Node *>(index.internalPointer()));
+}
+
+/**
+ * @brief Create an index for a fetched row
+ *
+ * The internal pointer of an index is the folder containing the row.
+ *
+ * @param[in] row      Row in the parent folder
+ * @param[in] column   Column, only 0 is valid
+ * @param[in] parent   Parent folder index, or invalid index for the top level
+ * @return Index for the row, or invalid index if the row is not fetched
+ */
+QModelIndex MachineTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    auto *node = nodeForParent(parent);
+    if (node == nullptr || column != 0 || row < 0 || row >= node->fetched) {
+        return {};
+    }
+    return createIndex(row, column, node);
+}
+
+/**
+ * @brief Parent index of the *child*
+ * @param[in] child   Index of a folder or machine
+ * @return Index of the folder containing the *child*, or invalid index for the top level
+ */
+QModelIndex MachineTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) {
+        return {};
+    }
+    return indexForNode(static_cast<Node *>(child.internalPointer()));
+}
+
+/**
+ * @brief Number of fetched rows in the folder
+ * @param[in] parent   Parent folder index, or invalid index for the top level
+ * @return Number of rows exposed to views
+ */
+int MachineTreeModel::rowCount(const QModelIndex &parent) const
+{
+    const auto *node = nodeForParent(parent);
+    return node != nullptr ? node->fetched : 0;
+}
+
+/**
+ * @brief Number of columns
+ * @return Always 1
+ */
+int MachineTreeModel::columnCount(const QModelIndex & /*parent*/) const
+{
+    return 1;
+}
+
+/**
+ * @brief Check if the folder has children
+ *
+ * This is answered without fetching, so views can show expand buttons
+ * for folders whose rows are not fetched yet.
+ *
+ * @param[in] parent   Parent folder index, or invalid index for the top level
+ * @return `true` if the folder has subfolders or machines
+ */
+bool MachineTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    const auto *node = nodeForParent(parent);
+    return node != nullptr && !node->children.isEmpty();
+}
+
+/**
+ * @brief Check if the folder has rows that are not fetched yet
+ * @param[in] parent   Parent folder index, or invalid index for the top level
+ * @return `true` if @ref fetchMore would expose more rows
+ */
+bool MachineTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    const auto *node = nodeForParent(parent);
+    return node != nullptr && node->fetched < node->children.size();
+}
+
+/**
+ * @brief Expose the next batch of rows in the folder
+ * @param[in] parent   Parent folder index, or invalid index for the top level
+ */
+void MachineTreeModel::fetchMore(const QModelIndex &parent)
+{
+    auto *node = nodeForParent(parent);
+    if (node == nullptr || node->fetched >= node->children.size()) {
+        return;
+    }
+    const auto count = std::min(FETCH_BATCH_SIZE,
+                                static_cast<int>(node->children.size()) - node->fetched);
+    beginInsertRows(parent, node->fetched, node->fetched + count - 1);
+    node->fetched += count;
+    endInsertRows();
+}
+
+/**
+ * @brief Data for the *index*
+ *
+ * - For `Qt::DisplayRole` we return the folder or machine name
+ * - For `Qt::DecorationRole` we return the folder icon or machine icon
+ * - For `MachineListModel::SummaryRole` we return the machine summary,
+ *   or the number of machines in the folder
+ * - For `MachineListModel::IconTypeRole` and `MachineListModel::IconNameRole`
+ *   we return the machine icon type and name
+ * - For @ref IsFolderRole, @ref MachineCountRole and @ref FolderPathRole
+ *   we return the folder information
+ *
+ * @param[in] index   Index for the item
+ * @param[in] role    Requested data
+ * @return Data for the role, or invalid QVariant
+ */
+QVariant MachineTreeModel::data(const QModelIndex &index, int role) const
+{
+    const auto *child = childForIndex(index);
+    if (child == nullptr) {
+        return {};
+    }
+
+    if (child->folder != nullptr) {
+        switch (role) {
+        case Qt::DisplayRole:
+            return child->folder->name;
+        case Qt::DecorationRole:
+            return IconCache::instance().icon(Machine::IconFromTheme, QStringLiteral("folder"));
+        case MachineListModel::SummaryRole:
+            return tr("%n machine(s)", nullptr, child->folder->machineCount);
+        case IsFolderRole:
+            return true;
+        case MachineCountRole:
+            return child->folder->machineCount;
+        case FolderPathRole:
+            return pathOf(child->folder);
+        default:
+            return {};
+        }
+    }
+
+    const auto &machine = mMachines.at(child->machine);
+    switch (role) {
+    case Qt::DisplayRole:
+        return machine.name();
+    case Qt::DecorationRole:
+        return machine.icon();
+    case MachineListModel::SummaryRole:
+        return machine.summary();
+    case MachineListModel::IconTypeRole:
+        return QVariant::fromValue(machine.iconType());
+    case MachineListModel::IconNameRole:
+        return machine.iconName();
+    case IsFolderRole:
+        return false;
+    case MachineCountRole:
+        return 1;
+    case FolderPathRole:
+        return pathOf(static_cast<Node *>(index.internalPointer()));
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief Move fetched rows into another folder
+ *
+ * Folders are moved with everything in them. The folder paths of all
+ * moved machines are updated, and the machine counts of the old and
+ * new parent folders are updated.
+ *
+ * The rows are placed where @ref setMachines would put them, so the
+ * tree looks the same after it is restored from the saved machines.
+ * The *destinationChild* must be a valid row, but the moved rows go
+ * to their sorted places in the destination folder. For the same
+ * reason, rows cannot be moved inside their own folder.
+ *
+ * The move is not possible if the destination folder already has a
+ * subfolder or a machine with the name of a moved folder or machine.
+ * Folders with the same name would be merged when the tree is built
+ * again, and machines with the same name could not be told apart.
+ *
+ * Each row is moved separately. A row whose sorted place is in the
+ * part of the destination folder that is not fetched yet is removed
+ * from the view, and it is shown when that part is fetched.
+ *
+ * @param[in] sourceParent        Folder of the moved rows
+ * @param[in] sourceRow           First row to move
+ * @param[in] count               How many rows to move
+ * @param[in] destinationParent   Folder to move the rows into
+ * @param[in] destinationChild    Requested row, at most the fetched row count
+ *
+ * @return `true` if rows were moved, `false` if the move is not possible
+ */
+bool MachineTreeModel::moveRows(const QModelIndex &sourceParent,
+                                int sourceRow,
+                                int count,
+                                const QModelIndex &destinationParent,
+                                int destinationChild)
+{
+    auto *source = nodeForParent(sourceParent);
+    auto *destination = nodeForParent(destinationParent);
+    if (source == nullptr || destination == nullptr || source == destination || count <= 0
+        || sourceRow < 0 || sourceRow + count > source->fetched || destinationChild < 0
+        || destinationChild > destination->fetched) {
+        return false;
+    }
+
+    // A folder cannot be moved into itself. With the same folder check above,
+    // this covers everything beginMoveRows() checks, so no row is moved if
+    // the move is not possible.
+    for (auto *node = destination; node != nullptr; node = node->parent) {
+        for (int row = sourceRow; row < sourceRow + count; ++row) {
+            if (source->children.at(row).folder == node) {
+                return false;
+            }
+        }
+    }
+
+    // Names must stay unique in the destination folder
+    for (int row = sourceRow; row < sourceRow + count; ++row) {
+        if (hasNameOf(destination, source->children.at(row))) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const auto child = source->children.at(sourceRow);
+        const auto position = sortedPosition(destination, child);
+        const auto sourceIndex = indexForNode(source);
+        const auto destinationIndex = indexForNode(destination);
+        const auto visible = position <= destination->fetched;
+        if (visible) {
+            const auto started = beginMoveRows(sourceIndex,
+                                               sourceRow,
+                                               sourceRow,
+                                               destinationIndex,
+                                               position);
+            Q_ASSERT(started);
+            Q_UNUSED(started)
+        } else {
+            beginRemoveRows(sourceIndex, sourceRow, sourceRow);
+        }
+
+        source->children.removeAt(sourceRow);
+        --source->fetched;
+        destination->children.insert(position, child);
+        if (child.folder != nullptr) {
+            child.folder->parent = destination;
+        }
+
+        if (visible) {
+            ++destination->fetched;
+            endMoveRows();
+        } else {
+            endRemoveRows();
+        }
+
+        setFolderPaths(child, pathOf(destination));
+        addToCounts(source, -countOf(child));
+        addToCounts(destination, countOf(child));
+    }
+    return true;
+}
+
+/**
+ * @brief Folder for a parent index
+ * @param[in] parent   Folder index, or invalid index for the root
+ * @return Folder node, or `nullptr` if the *parent* is a machine
+ */
+MachineTreeModel::Node *MachineTreeModel::nodeForParent(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return mRoot.get();
+    }
+    const auto *child = childForIndex(parent);
+    return child != nullptr ? child->folder : nullptr;
+}
+
+/**
+ * @brief Child for an index
+ * @param[in] index   Folder or machine index
+ * @return Child in its parent folder, or `nullptr` for invalid indexes
+ */
+const MachineTreeModel::Child *MachineTreeModel::childForIndex(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.model() != this) {
+        return nullptr;
+    }
+    const auto *node = static_cast<Node *>(index.internalPointer());
+    if (index.row() >= node->fetched) {
+        return nullptr;
+    }
+    return &node->children.at(index.row());
+}
+
+/**
+ * @brief Index of a folder
+ * @param[in] node   Folder node
+ * @return Index of the folder, or invalid index for the root
+ */
+QModelIndex MachineTreeModel::indexForNode(Node *node) const
+{
+    if (node == nullptr || node->parent == nullptr) {
+        return {};
+    }
+    const auto &siblings = node->parent->children;
+    for (int row = 0; row < node->parent->fetched; ++row) {
+        if (siblings.at(row).folder == node) {
+            return createIndex(row, 0, node->parent);
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Row of the *child* in the sorted order of the *node*
+ *
+ * Subfolders come first in name order, and then the machines in their
+ * list order, like in @ref setMachines.
+ *
+ * @param[in] node    Folder where the *child* is added
+ * @param[in] child   Folder or machine to add
+ * @return Row before which the *child* belongs
+ */
+int MachineTreeModel::sortedPosition(const Node *node, const Child &child) const
+{
+    const auto &children = node->children;
+    const auto belongsBefore = [&child](const Child &other) {
+        if (child.folder != nullptr) {
+            return other.folder == nullptr
+                   || other.folder->name.localeAwareCompare(child.folder->name) > 0;
+        }
+        return other.folder == nullptr && other.machine > child.machine;
+    };
+    const auto place = std::find_if(children.cbegin(), children.cend(), belongsBefore);
+    return static_cast<int>(place - children.cbegin());
+}
+
+/**
+ * @brief Check if the *node* has a child with the name of the *child*
+ *
+ * Folders are compared with folders, and machines with machines.
+ *
+ * @param[in] node    Folder to check
+ * @param[in] child   Folder or machine to look for
+ * @return `true` if the name is already used in the *node*
+ */
+bool MachineTreeModel::hasNameOf(const Node *node, const Child &child) const
+{
+    const auto &name = child.folder != nullptr ? child.folder->name
+                                               : mMachines.at(child.machine).name();
+    return std::any_of(node->children.cbegin(), node->children.cend(), [&](const Child &other) {
+        if (child.folder != nullptr) {
+            return other.folder != nullptr && other.folder->name == name;
+        }
+        return other.folder == nullptr && mMachines.at(other.machine).name() == name;
+    });
+}
+
+/**
+ * @brief Set the folder path of machines in the *child*
+ * @param[in] child   Moved folder or machine
+ * @param[in] path    Path of the folder containing the *child*
+ */
+void MachineTreeModel::setFolderPaths(const Child &child, const QString &path)
+{
+    if (child.folder == nullptr) {
+        auto &machine = mMachines[child.machine];
+        machine.setExtraVariable(FOLDER_VARIABLE, path.isEmpty() ? QVariant() : QVariant(path));
+        return;
+    }
+    const auto folderPath = joinPath(path, child.folder->name);
+    const auto &children = child.folder->children;
+    for (const auto &grandchild : children) {
+        setFolderPaths(grandchild, folderPath);
+    }
+}
+
+/**
+ * @brief Add to the machine counts of the *node* and its parents
+ *
+ * Data changed signals are sent for the counts of fetched folders.
+ *
+ * @param[in] node    Folder where machines were added or removed
+ * @param[in] count   Number of machines added, negative for removed
+ */
+void MachineTreeModel::addToCounts(Node *node, int count)
+{
+    for (; node != nullptr; node = node->parent) {
+        node->machineCount += count;
+        const auto index = indexForNode(node);
+        if (index.isValid()) {
+            emit dataChanged(index, index, {MachineListModel::SummaryRole, MachineCountRole});
+        }
+    }
+}
+
+/**
+ * @brief Path of a folder
+ * @param[in] node   Folder node
+ * @return Folder names from the top level separated with slashes, empty for the root
+ */
+QString MachineTreeModel::pathOf(const Node *node)
+{
+    QStringList names;
+    for (; node != nullptr && node->parent != nullptr; node = node->parent) {
+        names.prepend(node->name);
+    }
+    return names.join(QLatin1Char('/'));
+}
+
+/**
+ * @brief Append a folder name to a path
+ * @param[in] path   Parent folder path, or empty for the top level
+ * @param[in] name   Folder name
+ * @return Path to the folder
+ */
+QString MachineTreeModel::joinPath(const QString &path, const QString &name)
+{
+    return path.isEmpty() ? name : path + QLatin1Char('/') + name;
+}
+
+/**
+ * @brief Number of machines in a child
+ * @param[in] child   Folder or machine
+ * @return Machine count of the folder, or 1 for a machine
+ */
+int MachineTreeModel::countOf(const Child &child)
+{
+    return child.folder != nullptr ? child.folder->machineCount : 1;
+}
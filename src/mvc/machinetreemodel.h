@@ -0,0 +1,141 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  machinetreemodel.h
+ * @brief MachineTreeModel class definition
+ */
+
+#ifndef MACHINETREEMODEL_H
+#define MACHINETREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QList>
+#include <memory>
+#include "data/machine.h"
+#include "machinelistmodel.h"
+
+/**
+ * @brief Tree model of machines grouped into folders
+ *
+ * The folder of a machine is kept in its `"folder"` extra variable as
+ * a path separated with slashes, such as `"1990s/Gaming"`. Machines
+ * without a folder are shown at the top level. In each folder, the
+ * subfolders come first in name order, and then the machines in their
+ * list order.
+ *
+ * The folder tree is built once from the machine list, but rows are
+ * exposed to views only when they are fetched. A folder has no rows
+ * until the view expands it and calls @ref fetchMore, and the rows are
+ * then fetched in batches. The number of machines in each folder,
+ * including subfolders, is counted when the tree is built and kept up
+ * to date when rows are moved.
+ *
+ * A folder with everything in it is moved with one @ref moveRows call.
+ * The folder paths of the moved machines are updated, and the moved
+ * rows are kept in the sorted order, so that the same tree is restored
+ * from the saved machines. Names of folders and machines stay unique
+ * in each folder.
+ *
+ * The model provides the same roles as MachineListModel for machines.
+ * For folders, the summary is the number of machines in the folder.
+ */
+class MachineTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(MachineTreeModel)
+
+public:
+    /**
+     * @brief Custom item roles for this model in addition to MachineListModel::ItemRole
+     */
+    enum ItemRole {
+        IsFolderRole = MachineListModel::IconNameRole + 1, /*!< @brief Item is a folder. (bool) */
+        MachineCountRole, /*!< @brief Number of machines in the folder and its subfolders. (int) */
+        FolderPathRole    /*!< @brief Path of the folder, or the folder of the machine. (QString) */
+    };
+    Q_ENUM(ItemRole); /*!< @brief Registering ItemRole to meta-object system */
+
+    static constexpr const char *FOLDER_VARIABLE = "folder"; /*!< @brief Extra variable for the folder */
+
+    explicit MachineTreeModel(QObject *parent = nullptr);
+    ~MachineTreeModel() override;
+
+    [[nodiscard]] QList<Machine> machines() const;
+    void setMachines(const QList<Machine> &machines);
+    [[nodiscard]] Machine machineForIndex(const QModelIndex &index) const;
+    [[nodiscard]] bool isFolder(const QModelIndex &index) const;
+    [[nodiscard]] int machineCount(const QModelIndex &index) const;
+    [[nodiscard]] QString folderPath(const QModelIndex &index) const;
+
+signals:
+    /**
+     * @brief This model was just modified
+     */
+    void modelChanged();
+
+    // QAbstractItemModel interface
+public:
+    [[nodiscard]] QModelIndex index(int row,
+                                    int column,
+                                    const QModelIndex &parent = {}) const override;
+    [[nodiscard]] QModelIndex parent(const QModelIndex &child) const override;
+    [[nodiscard]] int rowCount(const QModelIndex &parent = {}) const override;
+    [[nodiscard]] int columnCount(const QModelIndex &parent = {}) const override;
+    [[nodiscard]] bool hasChildren(const QModelIndex &parent = {}) const override;
+    [[nodiscard]] bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role) const override;
+    bool moveRows(const QModelIndex &sourceParent,
+                  int sourceRow,
+                  int count,
+                  const QModelIndex &destinationParent,
+                  int destinationChild) override;
+
+private:
+    struct Node;
+
+    /**
+     * @brief Child of a folder, either a subfolder or a machine
+     */
+    struct Child
+    {
+        Node *folder{};  /*!< @brief Subfolder, or `nullptr` for a machine */
+        int machine{-1}; /*!< @brief Index of the machine in mMachines */
+    };
+
+    /**
+     * @brief Folder in the tree
+     *
+     * The folder owns its subfolders.
+     */
+    struct Node
+    {
+        Node() = default;
+        ~Node();
+        Q_DISABLE_COPY_MOVE(Node)
+
+        QString name;          /*!< @brief Folder name */
+        Node *parent{};        /*!< @brief Parent folder, `nullptr` for the root */
+        QList<Child> children; /*!< @brief Subfolders and machines in the row order */
+        int fetched{};         /*!< @brief Number of children exposed as rows */
+        int machineCount{};    /*!< @brief Machines in the folder and its subfolders */
+    };
+
+    [[nodiscard]] Node *nodeForParent(const QModelIndex &parent) const;
+    [[nodiscard]] const Child *childForIndex(const QModelIndex &index) const;
+    [[nodiscard]] QModelIndex indexForNode(Node *node) const;
+    [[nodiscard]] int sortedPosition(const Node *node, const Child &child) const;
+    [[nodiscard]] bool hasNameOf(const Node *node, const Child &child) const;
+    void setFolderPaths(const Child &child, const QString &path);
+    void addToCounts(Node *node, int count);
+
+    static QString pathOf(const Node *node);
+    static QString joinPath(const QString &path, const QString &name);
+    static int countOf(const Child &child);
+
+    QList<Machine> mMachines;    /*!< @brief Machines in the list order */
+    std::unique_ptr<Node> mRoot; /*!< @brief Top level folder */
+};
+
+#endif // MACHINETREEMODEL_H
@@ -0,0 +1,393 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  sqlmachinemodel.cpp
+ * @brief SqlMachineModel class implementation
+ */
+
+#include "sqlmachinemodel.h"
+#include "machinelistmodel.h"
+
+#include <QDebug>
+#include <QIcon>
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Number of rows read from the database by one @ref SqlMachineModel::fetchMore call
+ */
+constexpr int FETCH_BATCH_SIZE = 256;
+
+/**
+ * @brief Default number of machines kept in the cache
+ */
+constexpr int DEFAULT_CACHE_SIZE = 2048;
+
+} // namespace
+
+/**
+ * @brief Construct a model for the database *fileName*
+ *
+ * The model is empty until the database is opened with @ref open.
+ *
+ * @param[in] fileName   Path to the SQLite database file
+ * @param[in] parent     Pointer to parent object
+ */
+SqlMachineModel::SqlMachineModel(const QString &fileName, QObject *parent)
+    : QAbstractListModel{parent}
+    , mStore(std::make_unique<SqlMachineStore>(fileName))
+    , mAtEnd(true)
+    , mMachines(DEFAULT_CACHE_SIZE)
+{}
+
+SqlMachineModel::~SqlMachineModel() = default;
+
+/**
+ * @brief Open the database
+ *
+ * The model is reset, and rows are fetched when the view asks for
+ * them.
+ *
+ * @return `true` if the database was opened, `false` otherwise
+ */
+bool SqlMachineModel::open()
+{
+    const auto opened = mStore->open();
+    reset();
+    return opened;
+}
+
+/**
+ * @brief Description of the last database error
+ * @return Error message for the last failed operation
+ */
+QString SqlMachineModel::errorString() const
+{
+    return mStore->errorString();
+}
+
+/**
+ * @brief Cache size getter
+ * @return Maximum number of machines kept in memory
+ */
+int SqlMachineModel::cacheSize() const
+{
+    return mMachines.maxCost();
+}
+
+/**
+ * @brief Cache size setter
+ *
+ * The cache should hold at least the rows visible in the view.
+ * Otherwise, the same machines are read again on each repaint.
+ *
+ * @param[in] size   Maximum number of machines kept in memory
+ */
+void SqlMachineModel::setCacheSize(int size)
+{
+    mMachines.setMaxCost(size);
+}
+
+/**
+ * @brief Search text getter
+ * @return Text the rows are matched against, empty if all rows are shown
+ */
+QString SqlMachineModel::searchText() const
+{
+    return mSearchText;
+}
+
+/**
+ * @brief Show only machines matching the *text*
+ *
+ * A machine matches when its name or summary has words starting with
+ * each word of the *text*. The model is reset, and matching rows are
+ * fetched from the database.
+ *
+ * @param[in] text   Search text, or empty to show all machines
+ */
+void SqlMachineModel::setSearchText(const QString &text)
+{
+    if (text == mSearchText) {
+        return;
+    }
+    mSearchText = text;
+    reset();
+}
+
+/**
+ * @brief Add new *machines* to the end of the list
+ *
+ * If all rows have been fetched and no search is active, the new rows
+ * are inserted right away. Otherwise, they are fetched later with the
+ * rest of the rows.
+ *
+ * @param[in] machines   Add these machines to the model
+ */
+void SqlMachineModel::addMachines(const QList<Machine> &machines)
+{
+    if (machines.isEmpty()) {
+        return;
+    }
+    QList<qint64> ids;
+    if (!mStore->append(machines, &ids)) {
+        qCritical() << "Adding machines failed:" << mStore->errorString();
+        return;
+    }
+
+    if (!mSearchText.isEmpty()) {
+        reset();
+    } else if (mAtEnd) {
+        const auto row = static_cast<int>(mIds.size());
+        beginInsertRows({}, row, row + static_cast<int>(ids.size()) - 1);
+        mIds.append(ids);
+        endInsertRows();
+    }
+    emit modelChanged();
+}
+
+/**
+ * @brief Get Machine item from the *index*
+ *
+ * The machine is read from the database if it is not in the cache.
+ *
+ * @param[in] index   Get Machine from this index
+ * @return Machine item from given *index*
+ * @note Default machine is returned if given *index* is invalid
+ */
+Machine SqlMachineModel::machineForIndex(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= mIds.size()) {
+        return {};
+    }
+    const auto id = mIds.at(index.row());
+    if (const auto *machine = mMachines.object(id)) {
+        return *machine;
+    }
+    Machine machine;
+    if (!mStore->machine(id, machine)) {
+        qCritical() << "Reading machine failed:" << mStore->errorString();
+        return {};
+    }
+    mMachines.insert(id, new Machine(machine));
+    return machine;
+}
+
+/**
+ * @brief Replace the Machine item at the given *index*.
+ *
+ * Only an error message is printed to the console if the given *index*
+ * is invalid or the database cannot be written.
+ *
+ * @param[in] index     Replace machine item at this index
+ * @param[in] machine   Replace it with this machine
+ */
+void SqlMachineModel::setMachineForIndex(const QModelIndex &index, const Machine &machine)
+{
+    if (!index.isValid() || index.row() >= mIds.size()) {
+        qCritical() << "Invalid index:" << index;
+        return;
+    }
+    const auto id = mIds.at(index.row());
+    if (!mStore->update(id, machine)) {
+        qCritical() << "Updating machine failed:" << mStore->errorString();
+        return;
+    }
+    mMachines.insert(id, new Machine(machine));
+    emit dataChanged(index,
+                     index,
+                     {Qt::DecorationRole,
+                      Qt::DisplayRole,
+                      MachineListModel::SummaryRole,
+                      MachineListModel::IconTypeRole,
+                      MachineListModel::IconNameRole});
+    emit modelChanged();
+}
+
+/**
+ * @brief Remove machines at the *indexes*
+ *
+ * The machines are removed from the database in one transaction, and
+ * contiguous rows are removed together starting from the last row.
+ *
+ * @param[in] indexes   Remove machines from these indexes, in any order
+ */
+void SqlMachineModel::removeMachines(const QModelIndexList &indexes)
+{
+    QList<int> rows;
+    for (const auto &index : indexes) {
+        if (index.isValid() && index.row() < mIds.size()) {
+            rows.append(index.row());
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    QList<qint64> ids;
+    ids.reserve(rows.size());
+    for (const auto row : rows) {
+        ids.append(mIds.at(row));
+    }
+    if (!mStore->remove(ids)) {
+        qCritical() << "Removing machines failed:" << mStore->errorString();
+        return;
+    }
+
+    // Remove contiguous ranges with one signal each, starting from the last
+    for (auto last = static_cast<int>(rows.size()) - 1; last >= 0;) {
+        auto first = last;
+        while (first > 0 && rows.at(first - 1) == rows.at(first) - 1) {
+            --first;
+        }
+        beginRemoveRows({}, rows.at(first), rows.at(last));
+        for (int i = last; i >= first; --i) {
+            mMachines.remove(mIds.takeAt(rows.at(i)));
+        }
+        endRemoveRows();
+        last = first - 1;
+    }
+    emit modelChanged();
+}
+
+/**
+ * @brief All machines in the database
+ *
+ * This reads the whole list into memory, and is meant for exporting
+ * the machines.
+ *
+ * @return All machines in the list order
+ */
+QList<Machine> SqlMachineModel::machines() const
+{
+    QList<Machine> machines;
+    if (!mStore->machines(machines)) {
+        qCritical() << "Reading machines failed:" << mStore->errorString();
+    }
+    return machines;
+}
+
+/**
+ * @brief Replace all machines in the database
+ *
+ * This is used for importing a machine list, such as the content of
+ * `machines.json`. The model is reset.
+ *
+ * @param[in] machines   New machine list
+ */
+void SqlMachineModel::setMachines(const QList<Machine> &machines)
+{
+    if (!mStore->replaceAll(machines)) {
+        qCritical() << "Replacing machines failed:" << mStore->errorString();
+        return;
+    }
+    reset();
+    emit modelChanged();
+}
+
+/**
+ * @brief Number of fetched rows
+ * @return Number of rows exposed to views
+ */
+int SqlMachineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(mIds.size());
+}
+
+/**
+ * @brief Check if there are rows that are not fetched yet
+ * @return `true` if @ref fetchMore may expose more rows
+ */
+bool SqlMachineModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !mAtEnd;
+}
+
+/**
+ * @brief Read the next page of rows from the database
+ *
+ * The machines of the page are put into the cache, so the view does
+ * not have to read them one by one.
+ */
+void SqlMachineModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || mAtEnd) {
+        return;
+    }
+
+    QList<SqlMachineStore::Entry> entries;
+    if (!mStore->fetch(mSearchText, mLastPosition, FETCH_BATCH_SIZE, entries)) {
+        qCritical() << "Fetching machines failed:" << mStore->errorString();
+        mAtEnd = true;
+        return;
+    }
+    mAtEnd = entries.size() < FETCH_BATCH_SIZE;
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    const auto row = static_cast<int>(mIds.size());
+    beginInsertRows({}, row, row + static_cast<int>(entries.size()) - 1);
+    for (const auto &entry : entries) {
+        mIds.append(entry.id);
+        mMachines.insert(entry.id, new Machine(entry.machine));
+    }
+    mLastPosition = entries.last().position;
+    endInsertRows();
+}
+
+/**
+ * @brief Data for the *index*
+ *
+ * The same roles are provided as in MachineListModel.
+ *
+ * @param[in] index   Index for the item
+ * @param[in] role    Requested data
+ * @return Data for the role, or invalid QVariant
+ */
+QVariant SqlMachineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= mIds.size()) {
+        return {};
+    }
+
+    switch (role) {
+    case Qt::DecorationRole:
+        return machineForIndex(index).icon();
+
+    case Qt::DisplayRole:
+        return machineForIndex(index).name();
+
+    case MachineListModel::SummaryRole:
+        return machineForIndex(index).summary();
+
+    case MachineListModel::IconTypeRole:
+        return QVariant::fromValue(machineForIndex(index).iconType());
+
+    case MachineListModel::IconNameRole:
+        return machineForIndex(index).iconName();
+
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief Drop the fetched rows and the cache
+ *
+ * Rows are fetched again from the start when the view asks for them.
+ */
+void SqlMachineModel::reset()
+{
+    beginResetModel();
+    mIds.clear();
+    mMachines.clear();
+    mLastPosition = -1;
+    mAtEnd = !mStore->isOpen();
+    endResetModel();
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  sqlmachinemodel.h
+ * @brief SqlMachineModel class definition
+ */
+
+#ifndef SQLMACHINEMODEL_H
+#define SQLMACHINEMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QList>
+#include <memory>
+#include "data/machine.h"
+#include "data/sqlmachinestore.h"
+
+/**
+ * @brief List model of machines kept in an SQLite database
+ *
+ * This model is an alternative to MachineListModel for machine lists
+ * too large to keep in memory. It provides the same roles, but reads
+ * the machines from an SqlMachineStore.
+ *
+ * Rows are fetched in pages through @ref canFetchMore and
+ * @ref fetchMore as the view scrolls. For each fetched row, only the
+ * row id of the machine is kept. Machine objects are kept in a cache
+ * of limited size, and machines dropped from the cache are read again
+ * when they are needed. Memory use and startup time do not grow with
+ * the number of machines in the database.
+ *
+ * The search text set with @ref setSearchText is matched in the
+ * database with the full-text index, and only matching rows are
+ * fetched.
+ */
+class SqlMachineModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(SqlMachineModel)
+
+public:
+    explicit SqlMachineModel(const QString &fileName, QObject *parent = nullptr);
+    ~SqlMachineModel() override;
+
+    bool open();
+    [[nodiscard]] QString errorString() const;
+
+    [[nodiscard]] int cacheSize() const;
+    void setCacheSize(int size);
+    [[nodiscard]] QString searchText() const;
+    void setSearchText(const QString &text);
+
+    void addMachines(const QList<Machine> &machines);
+    [[nodiscard]] Machine machineForIndex(const QModelIndex &index) const;
+    void setMachineForIndex(const QModelIndex &index, const Machine &machine);
+    void removeMachines(const QModelIndexList &indexes);
+    [[nodiscard]] QList<Machine> machines() const;
+    void setMachines(const QList<Machine> &machines);
+
+signals:
+    /**
+     * @brief This model was just modified
+     */
+    void modelChanged();
+
+    // QAbstractItemModel interface
+public:
+    [[nodiscard]] int rowCount(const QModelIndex &parent = {}) const override;
+    [[nodiscard]] bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role) const override;
+
+private:
+    void reset();
+
+    std::unique_ptr<SqlMachineStore> mStore;  /*!< @brief Database of the machines */
+    QString mSearchText;                      /*!< @brief Only rows matching this text are fetched */
+    QList<qint64> mIds;                       /*!< @brief Row ids of the fetched rows */
+    qint64 mLastPosition{-1};                 /*!< @brief Position of the last fetched machine */
+    bool mAtEnd{};                            /*!< @brief All matching rows have been fetched */
+    mutable QCache<qint64, Machine> mMachines; /*!< @brief Recently used machines by row id */
+};
+
+#endif // SQLMACHINEMODEL_H
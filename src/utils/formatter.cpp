@@ -8,25 +8,59 @@
 
 #include "formatter.h"
 
-// StringPart
+#include <QVector>
+
+#include <algorithm>
+
+// Token
 //--------------------------------------------------------------------------------------------------
 
 /**
- * @brief Formattable string part
+ * @brief Piece of the input found by the tokenizer
  */
-struct StringPart
+struct Token
 {
     /**
-     * @brief Type of the part
-     * 
-     * The type defines how the *string* is interpreted.
+     * @brief Type of the token
      */
     enum Type {
-        Text,    /*!< @brief This part is literal text */
-        Variable /*!< @brief This part is a variable that should be replaced when text is formatted */
+        Text, /*!< @brief Literal text */
+        Field /*!< @brief Content between single braces */
+    };
+    Type type;     /*!< @brief Type for this token */
+    int offset{0}; /*!< @brief Start of the token in the input */
+    int length{0}; /*!< @brief Length of the token in the input */
+};
+
+// Instruction
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Single step of a compiled template
+ *
+ * Templates are compiled into a flat list of instructions, which is
+ * run from start to end for each formatting. Variables are loaded as
+ * views into their values, and filters only narrow the view, so
+ * nothing but the output is allocated while formatting.
+ */
+struct Instruction
+{
+    /**
+     * @brief Operation of the instruction
+     */
+    enum Op : quint8 {
+        Text,          /*!< @brief Append *b* characters of the input from offset *a* */
+        Load,          /*!< @brief Take the value of variable *a* as the current value */
+        Directory,     /*!< @brief Keep the directory part of the current value */
+        BaseName,      /*!< @brief Keep the part after the last separator of the current value */
+        Emit,          /*!< @brief Append the current value */
+        EmitShell,     /*!< @brief Append the current value quoted for a POSIX shell */
+        SkipUnlessSet, /*!< @brief Continue from instruction *b* if variable *a* is empty */
+        NextArgument   /*!< @brief Start the next argument in argument mode */
     };
-    Type type;      /*!< @brief Type for this part */
-    QString string; /*!< @brief Text or variable name */
+    Op op;    /*!< @brief What the instruction does */
+    int a{0}; /*!< @brief First operand */
+    int b{0}; /*!< @brief Second operand */
 };
 
 // FormatterData
@@ -38,7 +72,13 @@ struct StringPart
 class FormatterData : public QSharedData
 {
 public:
-    QVector<StringPart> parts; /*!< @brief Parts of string to format */
+    QString input;                        /*!< @brief Input string for the text instructions */
+    QVector<Instruction> program;         /*!< @brief Instructions for formatting a string */
+    QVector<Instruction> argumentProgram; /*!< @brief Instructions for formatting arguments */
+    QStringList variables;                /*!< @brief Names of the variables in the programs */
+    QVector<int> schemaSlots;             /*!< @brief Position of each variable in the schema */
+    QStringList schema;                   /*!< @brief Variable names the formatter is bound to */
+    int argumentCount{0};                 /*!< @brief Most arguments the argument program makes */
 };
 
 // Formatter
@@ -58,7 +98,7 @@ Formatter::Formatter()
 Formatter::Formatter(const Formatter &other) = default;
 
 /**
- * @brief Construct Formatter object and move the reference from *other*. 
+ * @brief Construct Formatter object and move the reference from *other*.
  * @param[in] other   Move reference from this object
  */
 Formatter::Formatter(Formatter &&other) noexcept
@@ -67,158 +107,634 @@ Formatter::Formatter(Formatter &&other) noexcept
 
 namespace {
 
-// Processing next character for Text segment
-bool textProcessing(QString::ConstIterator &it,
-                    QVector<StringPart> &parts,
-                    StringPart::Type &type,
-                    QString &string)
-{
-    if (*it == '{') {
-        it = std::next(it);
-        if (*it == '{') {
-            // double { is one { in the text segment
-            string += *it;
-        } else {
-            // Switching to Variable mode, save text segment if have any content
-            if (!string.isEmpty()) {
-                parts.push_back({type, string});
+/**
+ * @brief Add a literal text token to the *tokens*
+ * @param[in,out] tokens   Tokens found so far
+ * @param[in] first        Start of the text in the input
+ * @param[in] end          End of the text in the input, exclusive
+ */
+void appendText(QVector<Token> &tokens, qsizetype first, qsizetype end)
+{
+    if (end > first) {
+        tokens.push_back(
+            {Token::Text, static_cast<int>(first), static_cast<int>(end - first)});
+    }
+}
+
+/**
+ * @brief Split the *input* into tokens
+ *
+ * Braces are found with QStringView::indexOf(), which scans many
+ * characters at a time, so plain text between the braces is never
+ * looked at one character at a time. The position of the next brace of
+ * each kind is kept until the scan has passed it.
+ *
+ * Literal text is recorded as runs in the *input*. A doubled brace
+ * ends the run after its first brace, and the next run starts after
+ * the second one.
+ *
+ * @param[in] input    Input string to split
+ * @param[out] tokens  Text and field tokens of the input
+ * @return `true` if input is valid, `false` otherwise
+ */
+bool tokenize(QStringView input, QVector<Token> &tokens)
+{
+    const auto size = input.size();
+    qsizetype runStart = 0;
+    auto nextOpen = input.indexOf(QLatin1Char('{'));
+    auto nextClose = input.indexOf(QLatin1Char('}'));
+
+    while (nextOpen >= 0 || nextClose >= 0) {
+        if (nextOpen >= 0 && (nextClose < 0 || nextOpen < nextClose)) {
+            const auto brace = nextOpen;
+            if (brace + 1 < size && input.at(brace + 1) == QLatin1Char('{')) {
+                // double { is one { in the text segment
+                appendText(tokens, runStart, brace + 1);
+                runStart = brace + 2;
+                nextOpen = input.indexOf(QLatin1Char('{'), runStart);
+                continue;
             }
-            type = StringPart::Variable;
-            string.clear();
 
-            // We are ahead one characater, reverse a little bit
-            it = std::prev(it);
-        }
-    } else if (*it == '}') {
-        it = std::next(it);
-        if (*it == '}') {
-            // double } is one } in the text segment
-            string += *it;
+            // Field ends at the next }, and it cannot have {
+            appendText(tokens, runStart, brace);
+            nextOpen = input.indexOf(QLatin1Char('{'), brace + 1);
+            if (nextClose < 0 || (nextOpen >= 0 && nextOpen < nextClose)) {
+                return false;
+            }
+
+            // We do not allow empty fields
+            if (nextClose == brace + 1) {
+                return false;
+            }
+            tokens.push_back({Token::Field,
+                              static_cast<int>(brace + 1),
+                              static_cast<int>(nextClose - brace - 1)});
+            runStart = nextClose + 1;
+            nextClose = input.indexOf(QLatin1Char('}'), runStart);
         } else {
-            // single } in text segment is error
-            return false;
+            // single } in text segment is error, double } is one }
+            const auto brace = nextClose;
+            if (brace + 1 >= size || input.at(brace + 1) != QLatin1Char('}')) {
+                return false;
+            }
+            appendText(tokens, runStart, brace + 1);
+            runStart = brace + 2;
+            nextClose = input.indexOf(QLatin1Char('}'), runStart);
         }
-    } else {
-        string += *it;
     }
 
+    appendText(tokens, runStart, size);
     return true;
 }
 
-// Processing next character for Variable segment
-bool variableProcessing(QString::ConstIterator &it,
-                        QVector<StringPart> &parts,
-                        StringPart::Type &type,
-                        QString &string)
+/**
+ * @brief Compiler from tokens to instructions
+ *
+ * The same tokens are compiled twice: once for formatting a string,
+ * and once for formatting command line arguments. In argument mode,
+ * literal text is split with the same rules as QProcess::splitCommand():
+ * whitespace separates arguments, double quotes group text with spaces
+ * into one argument, and three double quotes in a row are one literal
+ * double quote. Values are not split, so they end up in the argument
+ * as they are, without any quoting.
+ */
+class Compiler
 {
-    // We do not allow { in variable names
-    if (*it == '{') {
-        return false;
+public:
+    /**
+     * @brief Construct a compiler for the tokens of the *input*
+     * @param[in] input          Input string of the tokens
+     * @param[in,out] variables  Variable names, new names are added here
+     * @param[in] arguments      Compile for argument mode
+     */
+    Compiler(const QString &input, QStringList &variables, bool arguments)
+        : mInput(input)
+        , mVariables(variables)
+        , mArguments(arguments)
+    {}
+
+    /**
+     * @brief Compile the *tokens*
+     * @param[in] tokens    Tokens of the input
+     * @param[out] program  Compiled instructions
+     * @return `true` if all fields are valid, `false` otherwise
+     */
+    bool compile(const QVector<Token> &tokens, QVector<Instruction> &program)
+    {
+        for (const auto &token : tokens) {
+            if (token.type == Token::Field) {
+                if (!compileField(QStringView(mInput).mid(token.offset, token.length))) {
+                    return false;
+                }
+            } else if (mArguments) {
+                splitText(token);
+            } else {
+                mProgram.push_back({Instruction::Text, token.offset, token.length});
+            }
+        }
+        endRun();
+
+        // Every conditional must be closed
+        if (!mOpenConditions.isEmpty()) {
+            return false;
+        }
+        program = mProgram;
+        return true;
     }
 
-    if (*it == '}') {
-        // We do not allow empty variable names
-        if (string.isEmpty()) {
+private:
+    /**
+     * @brief Compile the content of a field
+     *
+     * - `?name` starts a conditional, which ends at the next `/` field
+     * - `/` ends the innermost conditional
+     * - `name|filter|...` is a variable with optional filters
+     *
+     * @param[in] field   Content between the braces
+     * @return `true` if the field is valid, `false` otherwise
+     */
+    bool compileField(QStringView field)
+    {
+        // Conditionals are not characters of the output, so they do not change quoting
+        endRun();
+        if (field.startsWith(QLatin1Char('?'))) {
+            const auto name = field.mid(1);
+            if (name.isEmpty()) {
+                return false;
+            }
+            mOpenConditions.push_back(static_cast<int>(mProgram.size()));
+            mProgram.push_back({Instruction::SkipUnlessSet, variable(name), 0});
+            return true;
+        }
+        if (field == QStringView(u"/")) {
+            if (mOpenConditions.isEmpty()) {
+                return false;
+            }
+            mProgram[mOpenConditions.takeLast()].b = static_cast<int>(mProgram.size());
+            return true;
+        }
+
+        resolveQuotes();
+        mHasContent = true;
+        auto bar = field.indexOf(QLatin1Char('|'));
+        const auto name = field.left(bar);
+        if (name.isEmpty()) {
             return false;
         }
+        mProgram.push_back({Instruction::Load, variable(name), 0});
+        while (bar >= 0) {
+            const auto start = bar + 1;
+            bar = field.indexOf(QLatin1Char('|'), start);
+            const auto filter = bar < 0 ? field.mid(start) : field.mid(start, bar - start);
+            if (filter == QStringView(u"dir")) {
+                mProgram.push_back({Instruction::Directory, 0, 0});
+            } else if (filter == QStringView(u"basename")) {
+                mProgram.push_back({Instruction::BaseName, 0, 0});
+            } else if (filter == QStringView(u"shell") && bar < 0) {
+                // Quoting must be the last step
+                mProgram.push_back({Instruction::EmitShell, 0, 0});
+                return true;
+            } else {
+                return false;
+            }
+        }
+        mProgram.push_back({Instruction::Emit, 0, 0});
+        return true;
+    }
 
-        parts.push_back({type, string});
-        type = StringPart::Text;
-        string.clear();
-    } else {
-        string += *it;
+    /**
+     * @brief Split a literal text token into arguments
+     *
+     * The text instructions still point to the input. Quotes are left
+     * out by ending a text run before them.
+     *
+     * @param[in] token   Text token to split
+     */
+    void splitText(const Token &token)
+    {
+        for (int i = token.offset; i < token.offset + token.length; ++i) {
+            const auto c = mInput.at(i);
+            if (c == QLatin1Char('"')) {
+                endRun();
+                if (++mQuoteCount == 3) {
+                    // third consecutive quote is the quote character itself
+                    mQuoteCount = 0;
+                    appendCharacter(i);
+                }
+                continue;
+            }
+            resolveQuotes();
+            if (!mInQuote && c.isSpace()) {
+                endRun();
+                if (mHasContent) {
+                    mProgram.push_back({Instruction::NextArgument, 0, 0});
+                    mHasContent = false;
+                }
+            } else {
+                appendCharacter(i);
+            }
+        }
     }
 
-    return true;
+    /**
+     * @brief Add the input character at the *position* to the text run
+     * @param[in] position   Position of the character in the input
+     */
+    void appendCharacter(int position)
+    {
+        mHasContent = true;
+        if (mRunStart >= 0 && mRunEnd == position) {
+            ++mRunEnd;
+        } else {
+            endRun();
+            mRunStart = position;
+            mRunEnd = position + 1;
+        }
+    }
+
+    /**
+     * @brief Write the text run as an instruction
+     */
+    void endRun()
+    {
+        if (mRunStart >= 0) {
+            mProgram.push_back({Instruction::Text, mRunStart, mRunEnd - mRunStart});
+            mRunStart = -1;
+        }
+    }
+
+    /**
+     * @brief Apply the quotes seen before the next character
+     *
+     * One quote toggles quoting, and two quotes are an empty string.
+     */
+    void resolveQuotes()
+    {
+        if (mQuoteCount == 1) {
+            mInQuote = !mInQuote;
+        }
+        mQuoteCount = 0;
+    }
+
+    /**
+     * @brief Index of the variable with the *name*
+     * @param[in] name   Variable name
+     * @return Index in the variable names, which are added as needed
+     */
+    int variable(QStringView name)
+    {
+        const auto string = name.toString();
+        auto index = mVariables.indexOf(string);
+        if (index < 0) {
+            index = mVariables.size();
+            mVariables.append(string);
+        }
+        return static_cast<int>(index);
+    }
+
+    const QString &mInput;         /*!< @brief Input string of the tokens */
+    QStringList &mVariables;       /*!< @brief Variable names used by the programs */
+    bool mArguments;               /*!< @brief Compile for argument mode */
+    QVector<Instruction> mProgram; /*!< @brief Instructions compiled so far */
+    QVector<int> mOpenConditions;  /*!< @brief Instructions of the conditionals not yet closed */
+    bool mHasContent{false};       /*!< @brief The current argument has content */
+    bool mInQuote{false};          /*!< @brief Whitespace does not separate arguments */
+    int mQuoteCount{0};            /*!< @brief Consecutive quotes before the next character */
+    int mRunStart{-1};             /*!< @brief Start of the text run, or -1 */
+    int mRunEnd{-1};               /*!< @brief End of the text run, exclusive */
+};
+
+/**
+ * @brief Directory part of the *path*
+ *
+ * Both `/` and `\` are taken as separators, so that Windows paths work
+ * on every platform.
+ *
+ * @param[in] path   Path to a file
+ * @return Path without the last part, `/` for the root, or `.` if there is no separator
+ */
+QStringView directoryOf(QStringView path)
+{
+    const auto separator = std::max(path.lastIndexOf(QLatin1Char('/')),
+                                    path.lastIndexOf(QLatin1Char('\\')));
+    if (separator < 0) {
+        return QStringView(u".");
+    }
+    return path.left(separator > 0 ? separator : 1);
 }
 
-} // namespace
+/**
+ * @brief Last part of the *path*
+ * @param[in] path   Path to a file
+ * @return Part after the last `/` or `\`, or the whole path
+ */
+QStringView baseNameOf(QStringView path)
+{
+    const auto separator = std::max(path.lastIndexOf(QLatin1Char('/')),
+                                    path.lastIndexOf(QLatin1Char('\\')));
+    return path.mid(separator + 1);
+}
 
 /**
- * @brief Set input string for formatting
- * 
- * The function splits the given string into parts, which can then be
- * used to form the formatted string.
- * 
- * @param[in] input   Format this string
- * @return `true` if input is valid, 
- *         `false` if something is wrong with the input.
+ * @brief Append the *value* quoted for a POSIX shell
+ *
+ * The value is put in single quotes, and each single quote in it is
+ * written as `'\''`. Without *output*, only the length is counted.
+ *
+ * @param[out] output   String to append to, or `nullptr`
+ * @param[in] value     Value to quote
+ * @return Length of the quoted value
  */
-bool Formatter::setInput(const QString &input)
+int appendShellQuoted(QString *output, QStringView value)
 {
-    data->parts.clear();
-    auto parts = QVector<StringPart>();
+    const auto quotes = std::count(value.begin(), value.end(), QChar(u'\''));
+    const auto length = static_cast<int>(value.size() + 2 + 3 * quotes);
+    if (output == nullptr) {
+        return length;
+    }
 
-    auto type = StringPart::Text;
-    QString string;
+    output->append(QLatin1Char('\''));
+    qsizetype start = 0;
+    for (auto quote = value.indexOf(QLatin1Char('\'')); quote >= 0;
+         quote = value.indexOf(QLatin1Char('\''), start)) {
+        output->append(value.data() + start, static_cast<int>(quote - start));
+        output->append(QLatin1String(R"('\'')"));
+        start = quote + 1;
+    }
+    output->append(value.data() + start, static_cast<int>(value.size() - start));
+    output->append(QLatin1Char('\''));
+    return length;
+}
 
-    const auto *it = input.begin();
-    while (it != input.end()) {
-        switch (type) {
-        case StringPart::Text:
-            if (!textProcessing(it, parts, type, string)) {
-                return false;
+/**
+ * @brief Run a compiled *program*
+ *
+ * Without *output*, only the length of the output is counted, so that
+ * the output can be reserved at its final length before the real run.
+ *
+ * In argument mode, each finished argument is moved from *output* to
+ * *arguments*. Arguments that end up empty are left out, like in
+ * QProcess::splitCommand().
+ *
+ * @param[in] data        Formatter data with the input
+ * @param[in] program     Instructions to run
+ * @param[in] valueOf     Function giving the value of a variable by its index
+ * @param[out] output     Formatted string, or `nullptr` for counting the length
+ * @param[out] arguments  Formatted arguments in argument mode, or `nullptr`
+ * @return Length of the output
+ */
+template<typename ValueOf>
+int run(const FormatterData &data,
+        const QVector<Instruction> &program,
+        ValueOf valueOf,
+        QString *output,
+        QStringList *arguments = nullptr)
+{
+    int length = 0;
+    QStringView value;
+    for (int pc = 0; pc < program.size(); ++pc) {
+        const auto &instruction = program.at(pc);
+        switch (instruction.op) {
+        case Instruction::Text:
+            length += instruction.b;
+            if (output != nullptr) {
+                output->append(data.input.constData() + instruction.a, instruction.b);
             }
             break;
-
-        case StringPart::Variable:
-            if (!variableProcessing(it, parts, type, string)) {
-                return false;
+        case Instruction::Load:
+            value = valueOf(instruction.a);
+            break;
+        case Instruction::Directory:
+            value = directoryOf(value);
+            break;
+        case Instruction::BaseName:
+            value = baseNameOf(value);
+            break;
+        case Instruction::Emit:
+            length += static_cast<int>(value.size());
+            if (output != nullptr) {
+                output->append(value.data(), static_cast<int>(value.size()));
+            }
+            break;
+        case Instruction::EmitShell:
+            length += appendShellQuoted(output, value);
+            break;
+        case Instruction::SkipUnlessSet:
+            if (valueOf(instruction.a).isEmpty()) {
+                pc = instruction.b - 1;
+            }
+            break;
+        case Instruction::NextArgument:
+            if (arguments != nullptr && !output->isEmpty()) {
+                arguments->append(*output);
+                output->clear();
             }
             break;
         }
-
-        it = std::next(it);
     }
+    if (arguments != nullptr && !output->isEmpty()) {
+        arguments->append(*output);
+        output->clear();
+    }
+    return length;
+}
 
-    // If we end up to Variable type, then input is missing a }
-    if (type == StringPart::Variable) {
+/**
+ * @brief Value lookup from a hash map of variables
+ * @param[in] data        Formatter data with the variable names
+ * @param[in] variables   Variables with their values
+ * @return Function giving the value of a variable by its index
+ */
+auto valuesFromHash(const FormatterData &data, const QHash<QString, QString> &variables)
+{
+    return [&data, &variables](int variable) {
+        const auto it = variables.constFind(data.variables.at(variable));
+        return it != variables.cend() ? QStringView(*it) : QStringView();
+    };
+}
+
+/**
+ * @brief Value lookup from the values of a bound schema
+ * @param[in] data     Formatter data with the schema positions
+ * @param[in] values   Value for each variable in the schema
+ * @return Function giving the value of a variable by its index
+ */
+auto valuesFromList(const FormatterData &data, const QStringList &values)
+{
+    return [&data, &values](int variable) {
+        const auto slot = data.schemaSlots.at(variable);
+        return slot >= 0 && slot < values.size() ? QStringView(values.at(slot)) : QStringView();
+    };
+}
+
+} // namespace
+
+/**
+ * @brief Set input string for formatting
+ *
+ * The function splits the given string into tokens, and compiles them
+ * into instructions for formatting strings and for formatting command
+ * line arguments. The input is kept as it is, and text instructions
+ * point into it, so literal text is not copied.
+ *
+ * @param[in] input   Format this string
+ * @return `true` if input is valid,
+ *         `false` if something is wrong with the input.
+ */
+bool Formatter::setInput(const QString &input)
+{
+    data->input.clear();
+    data->program.clear();
+    data->argumentProgram.clear();
+    data->variables.clear();
+    data->schemaSlots.clear();
+    data->schema.clear();
+    data->argumentCount = 0;
+
+    QVector<Token> tokens;
+    if (!tokenize(input, tokens)) {
         return false;
     }
 
-    // Append last text part if we have content for it
-    if (!string.isEmpty()) {
-        parts.push_back({type, string});
+    QStringList variables;
+    QVector<Instruction> program;
+    QVector<Instruction> argumentProgram;
+    if (!Compiler(input, variables, false).compile(tokens, program)
+        || !Compiler(input, variables, true).compile(tokens, argumentProgram)) {
+        return false;
     }
 
     // Input was valid
-    data->parts = parts;
+    data->input = input;
+    data->program = program;
+    data->argumentProgram = argumentProgram;
+    data->variables = variables;
+    data->schemaSlots.fill(-1, static_cast<int>(variables.size()));
+    data->argumentCount = 1
+                          + static_cast<int>(std::count_if(argumentProgram.cbegin(),
+                                                           argumentProgram.cend(),
+                                                           [](const Instruction &instruction) {
+                                                               return instruction.op
+                                                                      == Instruction::NextArgument;
+                                                           }));
     return true;
 }
 
 /**
  * @brief Make formatted string
- * 
+ *
  * Format the given input string and replace the variables in it with
  * the given *variables*.
  *
  * Variables are given as a hash map where *key* is the variable and
- * *value* is the text that should replace the variable. 
- * 
+ * *value* is the text that should replace the variable.
+ *
  * @param[in] variables   Use these variables for formatting the output
  * @return Formatted string
  */
 QString Formatter::format(const QHash<QString, QString> &variables) const
 {
     QString string;
-    for (const auto &part : data->parts) {
-        switch (part.type) {
-        case StringPart::Text:
-            string.append(part.string);
-            break;
-        case StringPart::Variable:
-            string.append(variables.value(part.string));
-            break;
-        }
+    run(*data, data->program, valuesFromHash(*data, variables), &string);
+    return string;
+}
+
+/**
+ * @brief Bind the variables to a fixed *schema*
+ *
+ * Each variable in the template is resolved to its position in the
+ * *schema*, so that @ref format(const QStringList &) const can take
+ * the values as a list. Variables missing from the schema are replaced
+ * with an empty string, just like variables missing from the hash map.
+ *
+ * Binding is kept until the next @ref setInput call.
+ *
+ * @param[in] schema   Variable names in the order of the values
+ * @return `true` if all variables of the template are in the *schema*,
+ *         `false` otherwise.
+ */
+bool Formatter::bind(const QStringList &schema)
+{
+    auto allFound = true;
+    data->schema = schema;
+    for (int i = 0; i < data->variables.size(); ++i) {
+        data->schemaSlots[i] = static_cast<int>(schema.indexOf(data->variables.at(i)));
+        allFound = allFound && data->schemaSlots.at(i) >= 0;
     }
+    return allFound;
+}
+
+/**
+ * @brief Schema getter
+ * @return Variable names the formatter is bound to, or an empty list
+ */
+QStringList Formatter::schema() const
+{
+    return data->schema;
+}
+
+/**
+ * @brief Make formatted string from the values of a bound schema
+ *
+ * The *values* are given in the order of the @ref bind "bound" schema.
+ * The output length is counted first, so the string is allocated only
+ * once. Missing values are replaced with an empty string.
+ *
+ * @param[in] values   Value for each variable in the schema
+ * @return Formatted string
+ */
+QString Formatter::format(const QStringList &values) const
+{
+    const auto valueOf = valuesFromList(*data, values);
+    QString string;
+    string.reserve(run(*data, data->program, valueOf, nullptr));
+    run(*data, data->program, valueOf, &string);
     return string;
 }
 
+/**
+ * @brief Make command line arguments
+ *
+ * The input is taken as a command line, which is split into arguments
+ * when the input is set. The variables are replaced in each argument
+ * with their values as they are, so values with spaces or quotes do
+ * not need any quoting.
+ *
+ * @param[in] variables   Use these variables for formatting the arguments
+ * @return Formatted arguments, starting from the program
+ */
+QStringList Formatter::formatArguments(const QHash<QString, QString> &variables) const
+{
+    QStringList arguments;
+    arguments.reserve(data->argumentCount);
+    QString argument;
+    run(*data, data->argumentProgram, valuesFromHash(*data, variables), &argument, &arguments);
+    return arguments;
+}
+
+/**
+ * @brief Make command line arguments from the values of a bound schema
+ *
+ * This works like @ref formatArguments(const QHash<QString, QString> &) const,
+ * but the *values* are given in the order of the @ref bind "bound" schema.
+ *
+ * @param[in] values   Value for each variable in the schema
+ * @return Formatted arguments, starting from the program
+ */
+QStringList Formatter::formatArguments(const QStringList &values) const
+{
+    QStringList arguments;
+    arguments.reserve(data->argumentCount);
+    QString argument;
+    run(*data, data->argumentProgram, valuesFromList(*data, values), &argument, &arguments);
+    return arguments;
+}
+
 /**
  * @brief Convenience function text formatting
- * 
+ *
  * This static function is a convenient one-command way to perform text formatting.
- * 
+ *
  * @param[in] input       Input string for formatting
  * @param[in] variables   Hash map of variables with their values
  * @param[out] ok         This optional flag allows checking if the formatting was successful
@@ -238,7 +754,7 @@ Formatter::~Formatter() = default;
 
 /**
  * @brief Assignment operator
- * @param[in] other   Use the same values as this object 
+ * @param[in] other   Use the same values as this object
  * @return Reference to this object
  */
 Formatter &Formatter::operator=(const Formatter &other) = default;
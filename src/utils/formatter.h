@@ -11,6 +11,7 @@
 
 #include <QHash>
 #include <QSharedDataPointer>
+#include <QStringList>
 
 class FormatterData;
 
@@ -19,20 +20,45 @@ class FormatterData;
  * 
  * This class allows us to format simple text similarly to Python
  * f-string and Rust format. It can find and replace variables
- * surrounded with `{braces}`. However, that is all it can do,
- * and it has no advanced features.
- * 
- * It works by tokenizing a given string to a vector of StringPart
- * items with types of @ref StringPart::Type::Text "Text" and 
- * @ref StringPart::Type::Variable "Variable".
- * 
- * For example: `Hello {what}` results vector with:
- * 
- * - @ref StringPart::Type::Text "Text": "Hello "
- * - @ref StringPart::Type::Variable "Variable": "what"
+ * surrounded with `{braces}`, with a few filters and conditionals.
  * 
+ * Variables can have filters, which are separated with `|`:
+ *
+ * - `{config|dir}` gives the directory of a path, or `.` if it has none
+ * - `{config|basename}` gives the part after the last path separator
+ * - `{name|shell}` quotes the value for a POSIX shell. It must be the
+ *   last filter. Use it only where a shell reads the text, such as
+ *   inside `sh -c "..."`. @ref formatArguments() does not go through
+ *   a shell, so the quotes would end up in the argument.
+ *
+ * Parts of the template can be made conditional with `{?name}` and
+ * `{/}`. Everything between them is left out when the variable is
+ * empty or missing, for example `86Box{?config} --config {config}{/}`.
+ * Conditionals can be nested.
+ *
  * Braces can be used in the text. To do this, type two braces in a row.
- * @verbatim Input of "{{Hello}}" results a single text part with "{Hello}" @endverbatim
+ * @verbatim Input of "{{Hello}}" results "{Hello}" in the output @endverbatim
+ *
+ * The template is compiled once, when it is set, into a short list of
+ * instructions that point into the input string. Formatting only runs
+ * the instructions, and filters work on views of the values, so the
+ * output is the only thing allocated.
+ *
+ * Templates used again and again should be taken from the
+ * FormatterCache, so that they are parsed only once.
+ *
+ * A formatter can also be @ref bind "bound" to a fixed schema of
+ * variable names. The variables of the template are then resolved to
+ * slots in the schema once, and @ref format(const QStringList &) const
+ * takes the values as a list in the schema order. No names are hashed
+ * while formatting, and the output is allocated once at its final
+ * length.
+ *
+ * For running programs, @ref formatArguments() gives the command line
+ * split into arguments. The template is split once when it is set,
+ * with the rules of QProcess::splitCommand(), and the values are put
+ * into the arguments without quoting. Values with spaces or quotes
+ * therefore stay in one argument.
  * 
  * @par Example
  * 
@@ -69,6 +95,13 @@ public:
     bool setInput(const QString &input);
     [[nodiscard]] QString format(const QHash<QString, QString> &variables) const;
 
+    bool bind(const QStringList &schema);
+    [[nodiscard]] QStringList schema() const;
+    [[nodiscard]] QString format(const QStringList &values) const;
+
+    [[nodiscard]] QStringList formatArguments(const QHash<QString, QString> &variables) const;
+    [[nodiscard]] QStringList formatArguments(const QStringList &values) const;
+
     static QString format(const QString &input,
                           const QHash<QString, QString> &variables,
                           bool *ok = nullptr);
@@ -0,0 +1,126 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  formattercache.cpp
+ * @brief FormatterCache class implementation
+ */
+
+#include "formattercache.h"
+
+/**
+ * @brief The process-wide cache instance
+ * @return Reference to the shared cache
+ */
+FormatterCache &FormatterCache::instance()
+{
+    static FormatterCache cache;
+    return cache;
+}
+
+/**
+ * @brief Get the compiled formatter for the *input* template
+ *
+ * The template is parsed on the first request, and the same formatter
+ * is returned for later requests.
+ *
+ * @param[in] input   Template text
+ * @param[out] ok     Optional flag telling if the template is valid
+ * @return Shared formatter, which formats an empty string if the template is invalid
+ */
+Formatter FormatterCache::formatter(const QString &input, bool *ok)
+{
+    return formatter(input, {}, ok);
+}
+
+/**
+ * @brief Get the compiled formatter for the *input* template bound to the *schema*
+ *
+ * The template is parsed and bound on the first request, and the same
+ * formatter is returned for later requests with the same schema.
+ *
+ * @param[in] input    Template text
+ * @param[in] schema   Variable names for Formatter::bind(), or an empty list for no binding
+ * @param[out] ok      Optional flag telling if the template is valid
+ * @return Shared formatter, which formats an empty string if the template is invalid
+ */
+Formatter FormatterCache::formatter(const QString &input, const QStringList &schema, bool *ok)
+{
+    QMutexLocker locker(&mMutex);
+    const Key key{schema, input};
+    auto it = mFormatters.find(key);
+    if (it != mFormatters.end()) {
+        ++mHits;
+    } else {
+        ++mMisses;
+        Entry entry;
+        entry.valid = entry.formatter.setInput(input);
+        if (entry.valid && !schema.isEmpty()) {
+            entry.formatter.bind(schema);
+        }
+        it = mFormatters.insert(key, entry);
+    }
+    if (ok != nullptr) {
+        *ok = it->valid;
+    }
+    return it->formatter;
+}
+
+/**
+ * @brief Format the *input* template with the cached formatter
+ *
+ * This works like the static Formatter::format() function,
+ * except that the template is parsed only once.
+ *
+ * @param[in] input       Template text
+ * @param[in] variables   Hash map of variables with their values
+ * @param[out] ok         Optional flag telling if the template is valid
+ * @return Formatted string
+ */
+QString FormatterCache::format(const QString &input,
+                               const QHash<QString, QString> &variables,
+                               bool *ok)
+{
+    return formatter(input, ok).format(variables);
+}
+
+/**
+ * @brief Remove all formatters from the cache
+ *
+ * The counters are reset too.
+ */
+void FormatterCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mFormatters.clear();
+    mHits = 0;
+    mMisses = 0;
+}
+
+/**
+ * @brief Cache hit counter
+ * @return Number of requests served from the cache
+ */
+qint64 FormatterCache::hits() const
+{
+    return mHits;
+}
+
+/**
+ * @brief Cache miss counter
+ * @return Number of requests that parsed the template
+ */
+qint64 FormatterCache::misses() const
+{
+    return mMisses;
+}
+
+/**
+ * @brief Number of cached templates
+ * @return Template count in the cache
+ */
+int FormatterCache::size() const
+{
+    QMutexLocker locker(&mMutex);
+    return static_cast<int>(mFormatters.size());
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  formattercache.h
+ * @brief FormatterCache class definition
+ */
+
+#ifndef FORMATTERCACHE_H
+#define FORMATTERCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include "formatter.h"
+
+/**
+ * @brief Process-wide cache of compiled Formatter templates
+ *
+ * Commands are formatted from only a few templates: the default
+ * commands from the settings and the alternative commands of some
+ * machines. The cache parses each template once and keeps the
+ * compiled Formatter, so formatting a command later only substitutes
+ * the variables.
+ *
+ * Formatter objects are implicitly shared, so handing out a cached
+ * formatter does not copy the parsed parts. Invalid templates are
+ * cached too, so they are not parsed again either.
+ *
+ * Formatters can be requested bound to a variable schema. Each
+ * template and schema pair is then parsed and bound once. See
+ * Formatter::bind().
+ *
+ * The cache can be used from any thread.
+ */
+class FormatterCache
+{
+    Q_DISABLE_COPY_MOVE(FormatterCache)
+
+public:
+    static FormatterCache &instance();
+
+    Formatter formatter(const QString &input, bool *ok = nullptr);
+    Formatter formatter(const QString &input, const QStringList &schema, bool *ok = nullptr);
+    QString format(const QString &input,
+                   const QHash<QString, QString> &variables,
+                   bool *ok = nullptr);
+    void clear();
+
+    [[nodiscard]] qint64 hits() const;
+    [[nodiscard]] qint64 misses() const;
+    [[nodiscard]] int size() const;
+
+private:
+    FormatterCache() = default;
+    ~FormatterCache() = default;
+
+    /**
+     * @brief Compiled template
+     */
+    struct Entry
+    {
+        Formatter formatter; /*!< @brief Formatter with the parsed template */
+        bool valid{false};   /*!< @brief The template was parsed without errors */
+    };
+
+    /**
+     * @brief Key for cached formatters
+     */
+    using Key = QPair<QStringList, QString>;
+
+    mutable QMutex mMutex;          /*!< @brief Protects mFormatters */
+    QHash<Key, Entry> mFormatters;  /*!< @brief Compiled formatters by schema and template text */
+    std::atomic<qint64> mHits{0};   /*!< @brief Lookups served from the cache */
+    std::atomic<qint64> mMisses{0}; /*!< @brief Lookups that parsed the template */
+};
+
+#endif // FORMATTERCACHE_H
@@ -0,0 +1,332 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  fuzzymatcher.cpp
+ * @brief FuzzyMatcher class implementation
+ */
+
+#include "fuzzymatcher.h"
+
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int SCORE_MATCH = 16;            /*!< @brief Points for each matched character */
+constexpr int SCORE_GAP_START = -3;        /*!< @brief Points for the first character of a gap */
+constexpr int SCORE_GAP_EXTENSION = -1;    /*!< @brief Points for other characters of a gap */
+constexpr int BONUS_BOUNDARY = 8;          /*!< @brief Bonus for the first character of a word */
+constexpr int BONUS_NON_WORD = 8;          /*!< @brief Bonus for punctuation and spaces */
+constexpr int BONUS_CAMEL = 7;             /*!< @brief Bonus for case changes and letters to digits */
+constexpr int BONUS_CONSECUTIVE = 4;       /*!< @brief Minimum bonus for consecutive characters */
+constexpr int BONUS_FIRST_MULTIPLIER = 2;  /*!< @brief Multiplier for the first pattern character */
+constexpr int PARALLEL_THRESHOLD = 8192;   /*!< @brief Candidates needed for parallel matching */
+constexpr int CHUNK_SIZE = 2048;           /*!< @brief Candidates scored by one parallel step */
+
+/**
+ * @brief Thread pool for parallel matching
+ *
+ * Matching has its own pool, so that it does not wait behind unrelated
+ * tasks in the global thread pool.
+ *
+ * @return Pool with a thread for each processor core
+ */
+QThreadPool *matchPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+/**
+ * @brief State shared by the threads of one parallel match
+ *
+ * Helper tasks hold a reference to the job, so a helper that starts
+ * only after the match has returned finds no chunks left and exits
+ * without touching anything else.
+ */
+struct MatchJob
+{
+    std::atomic<int> nextChunk{0}; /*!< @brief Next chunk to be claimed */
+    QSemaphore finished;           /*!< @brief Released once for each scored chunk */
+};
+
+/**
+ * @brief Case fold the *text* one character at a time
+ *
+ * Folding each character separately keeps the positions of the folded
+ * text the same as in the original text.
+ *
+ * @param[in] text   Text to fold
+ * @return Case folded text with the same length
+ */
+QString fold(const QString &text)
+{
+    QString folded(text.size(), Qt::Uninitialized);
+    for (int i = 0; i < text.size(); ++i) {
+        folded[i] = text.at(i).toCaseFolded();
+    }
+    return folded;
+}
+
+/**
+ * @brief Bonus for matching the character at *position*
+ * @param[in] text       Original text
+ * @param[in] position   Position of the matched character
+ * @return Bonus points for the character
+ */
+int bonusAt(const QString &text, int position)
+{
+    const auto current = text.at(position);
+    if (!current.isLetterOrNumber()) {
+        return BONUS_NON_WORD;
+    }
+    if (position == 0) {
+        return BONUS_BOUNDARY;
+    }
+    const auto previous = text.at(position - 1);
+    if (!previous.isLetterOrNumber()) {
+        return BONUS_BOUNDARY;
+    }
+    if ((previous.isLower() && current.isUpper()) || (previous.isLetter() && current.isDigit())) {
+        return BONUS_CAMEL;
+    }
+    return 0;
+}
+
+} // namespace
+
+/**
+ * @brief Construct a matcher without candidates
+ */
+FuzzyMatcher::FuzzyMatcher() = default;
+
+/**
+ * @brief Number of candidates
+ * @return Number of candidates given to @ref setCandidates
+ */
+int FuzzyMatcher::size() const
+{
+    return static_cast<int>(mCandidates.size());
+}
+
+/**
+ * @brief Candidate getter
+ * @param[in] index   Index of the candidate
+ * @return Candidate text as it was given
+ */
+QString FuzzyMatcher::candidate(int index) const
+{
+    return mCandidates.value(index).text;
+}
+
+/**
+ * @brief Set the texts to match against
+ * @param[in] candidates   Candidate texts
+ */
+void FuzzyMatcher::setCandidates(const QStringList &candidates)
+{
+    mCandidates.clear();
+    mCandidates.reserve(candidates.size());
+    for (const auto &candidate : candidates) {
+        mCandidates.append({candidate, fold(candidate)});
+    }
+}
+
+/**
+ * @brief Find and rank the candidates matching the *pattern*
+ *
+ * An empty pattern matches all candidates with zero score, and they
+ * are returned in their original order.
+ *
+ * The call is synchronous. Long candidate lists are split into chunks,
+ * which are scored by the calling thread together with helpers from a
+ * thread pool of the matcher. The caller scores chunks itself until
+ * none are left, so it never waits for a helper to be started, but it
+ * is still blocked until all matches are scored.
+ *
+ * @param[in] pattern   Characters to search for
+ * @param[in] limit     Maximum number of matches to return, or -1 for all
+ * @return Matches from the best to the worst
+ */
+QList<FuzzyMatcher::Match> FuzzyMatcher::match(const QString &pattern, int limit) const
+{
+    const auto count = size();
+    if (limit < 0 || limit > count) {
+        limit = count;
+    }
+
+    QList<Match> matches;
+    if (pattern.isEmpty()) {
+        for (int index = 0; index < limit; ++index) {
+            matches.append({index, 0});
+        }
+        return matches;
+    }
+
+    const auto folded = fold(pattern);
+    if (count < PARALLEL_THRESHOLD) {
+        matches = matchRange(folded, 0, count);
+    } else {
+        // Chunks are claimed from a counter by the helpers and this thread,
+        // so this thread only waits for chunks that are already being scored
+        const auto chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        std::vector<QList<Match>> results(chunks);
+        auto job = std::make_shared<MatchJob>();
+        const auto work = [this, job, &folded, &results, chunks, count]() {
+            for (auto chunk = job->nextChunk++; chunk < chunks; chunk = job->nextChunk++) {
+                const auto first = chunk * CHUNK_SIZE;
+                results[chunk] = matchRange(folded, first, std::min(count, first + CHUNK_SIZE));
+                job->finished.release();
+            }
+        };
+
+        auto *pool = matchPool();
+        const auto helpers = std::min(pool->maxThreadCount() - 1, chunks - 1);
+        for (int helper = 0; helper < helpers; ++helper) {
+            pool->start(work);
+        }
+        work();
+        job->finished.acquire(chunks);
+        for (const auto &result : results) {
+            matches.append(result);
+        }
+    }
+
+    limit = std::min(limit, static_cast<int>(matches.size()));
+    std::partial_sort(matches.begin(),
+                      matches.begin() + limit,
+                      matches.end(),
+                      [this](const Match &match, const Match &other) {
+                          return isBetter(match, other);
+                      });
+    return matches.mid(0, limit);
+}
+
+/**
+ * @brief Score a single *text*
+ *
+ * This is mostly useful for testing, as it prepares the text for each
+ * call.
+ *
+ * @param[in] pattern   Characters to search for
+ * @param[in] text      Text to score
+ * @return Score of the match, or -1 if the text does not match
+ */
+int FuzzyMatcher::score(const QString &pattern, const QString &text)
+{
+    return score(fold(pattern), {text, fold(text)});
+}
+
+/**
+ * @brief Score the *candidate*
+ *
+ * A forward scan finds where the first match ends, and a backward scan
+ * from there finds the shortest match. The characters of that match
+ * are then scored.
+ *
+ * @param[in] pattern     Case folded pattern
+ * @param[in] candidate   Prepared candidate
+ * @return Score of the match, or -1 if the candidate does not match
+ */
+int FuzzyMatcher::score(const QString &pattern, const Candidate &candidate)
+{
+    const auto &text = candidate.folded;
+    const auto length = static_cast<int>(text.size());
+    const auto patternLength = static_cast<int>(pattern.size());
+    if (patternLength == 0) {
+        return 0;
+    }
+
+    // Find the end of the first match
+    int end = -1;
+    for (int i = 0, p = 0; i < length; ++i) {
+        if (text.at(i) == pattern.at(p) && ++p == patternLength) {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) {
+        return -1;
+    }
+
+    // Find the start of the shortest match ending there
+    int start = end;
+    for (int i = end, p = patternLength - 1; i >= 0; --i) {
+        if (text.at(i) == pattern.at(p) && --p < 0) {
+            start = i;
+            break;
+        }
+    }
+
+    // Score the match
+    int score = 0;
+    int firstBonus = 0;
+    bool consecutive = false;
+    bool inGap = false;
+    for (int i = start, p = 0; i <= end; ++i) {
+        if (p < patternLength && text.at(i) == pattern.at(p)) {
+            auto bonus = bonusAt(candidate.text, i);
+            if (!consecutive) {
+                firstBonus = bonus;
+            } else {
+                if (bonus >= BONUS_BOUNDARY && bonus > firstBonus) {
+                    firstBonus = bonus;
+                }
+                bonus = std::max({bonus, firstBonus, BONUS_CONSECUTIVE});
+            }
+            score += SCORE_MATCH + (p == 0 ? bonus * BONUS_FIRST_MULTIPLIER : bonus);
+            consecutive = true;
+            inGap = false;
+            ++p;
+        } else {
+            score += inGap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            consecutive = false;
+            inGap = true;
+        }
+    }
+    return score;
+}
+
+/**
+ * @brief Score a range of candidates
+ * @param[in] pattern   Case folded pattern
+ * @param[in] first     First candidate to score
+ * @param[in] last      One past the last candidate to score
+ * @return Matching candidates in their original order
+ */
+QList<FuzzyMatcher::Match> FuzzyMatcher::matchRange(const QString &pattern, int first, int last) const
+{
+    QList<Match> matches;
+    for (int index = first; index < last; ++index) {
+        const auto score = FuzzyMatcher::score(pattern, mCandidates.at(index));
+        if (score >= 0) {
+            matches.append({index, score});
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Compare two matches for ranking
+ * @param[in] match   Match to compare
+ * @param[in] other   Match to compare against
+ * @return `true` if *match* ranks before *other*
+ */
+bool FuzzyMatcher::isBetter(const Match &match, const Match &other) const
+{
+    if (match.score != other.score) {
+        return match.score > other.score;
+    }
+    const auto length = mCandidates.at(match.index).text.size();
+    const auto otherLength = mCandidates.at(other.index).text.size();
+    if (length != otherLength) {
+        return length < otherLength;
+    }
+    return match.index < other.index;
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2024 Ossi Saukko <osaukko@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * @file  fuzzymatcher.h
+ * @brief FuzzyMatcher class definition
+ */
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Ranked fuzzy matching of short texts
+ *
+ * The matcher finds the candidates that contain all characters of the
+ * pattern in the same order, ignoring case. Matches are scored in the
+ * same spirit as the fzf tool:
+ *
+ * - Each matched character is worth points.
+ * - Characters at the start of a word, or at a lower-to-upper case
+ *   change, get a bonus. The first pattern character gets it twice.
+ * - Consecutive matched characters keep the bonus of the first one.
+ * - Gaps between matched characters cost points.
+ *
+ * For each candidate, the shortest match ending at the first possible
+ * place is scored. Candidates with the same score are ranked by their
+ * length and then by their position in the list.
+ *
+ * Candidates are case folded once by @ref setCandidates. Long candidate
+ * lists are scored in parallel by the calling thread and a thread pool
+ * of the matcher. Matching is still synchronous, so the caller is
+ * blocked until all candidates are scored.
+ *
+ * @par Example
+ *
+ * @code{.cpp}
+ * FuzzyMatcher matcher;
+ * matcher.setCandidates({"Windows 98 SE", "Windows 2000", "MS-DOS 6.22"});
+ * const auto matches = matcher.match("w98");
+ * Q_ASSERT(matches.first().index == 0);
+ * @endcode
+ */
+class FuzzyMatcher
+{
+public:
+    /**
+     * @brief One matching candidate
+     */
+    struct Match
+    {
+        int index; /*!< @brief Index of the candidate */
+        int score; /*!< @brief Score of the match, higher is better */
+    };
+
+    FuzzyMatcher();
+
+    [[nodiscard]] int size() const;
+    [[nodiscard]] QString candidate(int index) const;
+    void setCandidates(const QStringList &candidates);
+    [[nodiscard]] QList<Match> match(const QString &pattern, int limit = -1) const;
+
+    static int score(const QString &pattern, const QString &text);
+
+private:
+    /**
+     * @brief Candidate prepared for matching
+     */
+    struct Candidate
+    {
+        QString text;   /*!< @brief Original text */
+        QString folded; /*!< @brief Case folded text */
+    };
+
+    static int score(const QString &pattern, const Candidate &candidate);
+    [[nodiscard]] QList<Match> matchRange(const QString &pattern, int first, int last) const;
+    [[nodiscard]] bool isBetter(const Match &match, const Match &other) const;
+
+    QList<Candidate> mCandidates; /*!< @brief Candidates in the original order */
+};
+
+#endif // FUZZYMATCHER_H
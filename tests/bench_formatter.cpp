@@ -0,0 +1,54 @@
+#include "utils/formatter.h"
+
+#include <QtTest/QTest>
+
+class BenchFormatter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void hashVariables();
+    void boundVariables();
+
+private:
+    Formatter formatter;
+};
+
+// Number of commands formatted in one benchmark round
+constexpr int COMMAND_COUNT = 10000;
+
+void BenchFormatter::initTestCase()
+{
+    QVERIFY(formatter.setInput("{86box} --settings --config {config}"));
+    QVERIFY(formatter.bind({"86box", "config"}));
+}
+
+// The old way: a new hash for each command, and a lookup for each variable
+void BenchFormatter::hashVariables()
+{
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (int i = 0; i < COMMAND_COUNT; ++i) {
+            const QHash<QString, QString> variables = {{"86box", "\"/usr/bin/86Box\""},
+                                                       {"config", "\"/vms/machine/86box.cfg\""}};
+            length += formatter.format(variables).size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+void BenchFormatter::boundVariables()
+{
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (int i = 0; i < COMMAND_COUNT; ++i) {
+            const QStringList values = {"\"/usr/bin/86Box\"", "\"/vms/machine/86box.cfg\""};
+            length += formatter.format(values).size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchFormatter)
+#include "bench_formatter.moc"
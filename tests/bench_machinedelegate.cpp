@@ -0,0 +1,100 @@
+#include "mvc/machinedelegate.h"
+#include "mvc/machinelistmodel.h"
+
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QtTest/QTest>
+
+class BenchMachineDelegate : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void paintRows();
+    void paintUniformRows();
+    void sizeHintRows();
+    void sizeHintUniformRows();
+
+private:
+    void paint(bool uniform);
+    void sizeHint(bool uniform);
+
+    MachineListModel model;
+    QStyleOptionViewItem option;
+};
+
+// Number of machines in the model
+constexpr int MACHINE_COUNT = 5000;
+
+void BenchMachineDelegate::initTestCase()
+{
+    QList<Machine> machines;
+    machines.reserve(MACHINE_COUNT);
+    for (int i = 0; i < MACHINE_COUNT; ++i) {
+        Machine machine;
+        machine.setName(QString("Machine %1").arg(i));
+        machine.setSummary(QString("Summary for the machine number %1").arg(i));
+        machine.setIcon(Machine::IconFromTheme, "pc");
+        machines.append(machine);
+    }
+    model.setMachines(machines);
+
+    option.rect = QRect(0, 0, 320, 48);
+    option.decorationSize = QSize(32, 32);
+    option.font = QApplication::font();
+    option.palette = QApplication::palette();
+    option.state = QStyle::State_Enabled;
+}
+
+// Painting all rows, as when a long list is scrolled through
+void BenchMachineDelegate::paint(bool uniform)
+{
+    MachineDelegate delegate;
+    delegate.setUniformRowHeights(uniform);
+    QImage image(option.rect.size(), QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            delegate.paint(&painter, option, model.index(row));
+        }
+    }
+}
+
+void BenchMachineDelegate::paintRows()
+{
+    paint(false);
+}
+
+void BenchMachineDelegate::paintUniformRows()
+{
+    paint(true);
+}
+
+// Size hints for all rows, as when the view lays out the items
+void BenchMachineDelegate::sizeHint(bool uniform)
+{
+    MachineDelegate delegate;
+    delegate.setUniformRowHeights(uniform);
+    int height = 0;
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            height += delegate.sizeHint(option, model.index(row)).height();
+        }
+    }
+    QVERIFY(height > 0);
+}
+
+void BenchMachineDelegate::sizeHintRows()
+{
+    sizeHint(false);
+}
+
+void BenchMachineDelegate::sizeHintUniformRows()
+{
+    sizeHint(true);
+}
+
+QTEST_MAIN(BenchMachineDelegate)
+#include "bench_machinedelegate.moc"
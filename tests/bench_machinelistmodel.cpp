@@ -0,0 +1,128 @@
+#include "mvc/machinefiltermodel.h"
+#include "mvc/machinelistmodel.h"
+
+#include <QtTest/QTest>
+
+#include <array>
+
+class BenchMachineListModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void copyMachines();
+    void referenceMachines();
+    void dataRoles();
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    void multiDataRoles();
+#endif
+    void filterKeystroke();
+
+private:
+    MachineListModel model;
+};
+
+// Number of machines in the model
+constexpr int MACHINE_COUNT = 50000;
+
+void BenchMachineListModel::initTestCase()
+{
+    QList<Machine> machines;
+    machines.reserve(MACHINE_COUNT);
+    for (int i = 0; i < MACHINE_COUNT; ++i) {
+        Machine machine;
+        machine.setName(QString("Machine %1").arg(i));
+        machine.setSummary(QString("Summary for the machine number %1").arg(i));
+        machine.setIcon(Machine::IconFromTheme, "pc");
+        machines.append(machine);
+    }
+    model.setMachines(machines);
+}
+
+// The old way: copy the machine and its strings for each role
+void BenchMachineListModel::copyMachines()
+{
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            const auto index = model.index(row);
+            length += QString(model.machineForIndex(index).name()).size();
+            length += QString(model.machineForIndex(index).summary()).size();
+            length += QString(model.machineForIndex(index).iconName()).size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+void BenchMachineListModel::referenceMachines()
+{
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            const auto &machine = model.machineAt(row);
+            length += machine.name().size();
+            length += machine.summary().size();
+            length += machine.iconName().size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+void BenchMachineListModel::dataRoles()
+{
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            const auto index = model.index(row);
+            length += index.data(Qt::DisplayRole).toString().size();
+            length += index.data(MachineListModel::SummaryRole).toString().size();
+            length += index.data(MachineListModel::IconTypeRole).value<Machine::IconType>();
+            length += index.data(MachineListModel::IconNameRole).toString().size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+void BenchMachineListModel::multiDataRoles()
+{
+    qsizetype length = 0;
+    std::array<QModelRoleData, 4> roles = {QModelRoleData(Qt::DisplayRole),
+                                           QModelRoleData(MachineListModel::SummaryRole),
+                                           QModelRoleData(MachineListModel::IconTypeRole),
+                                           QModelRoleData(MachineListModel::IconNameRole)};
+    QBENCHMARK {
+        for (int row = 0; row < MACHINE_COUNT; ++row) {
+            model.index(row).multiData(roles);
+            length += roles[0].data().toString().size();
+            length += roles[1].data().toString().size();
+            length += roles[2].data().value<Machine::IconType>();
+            length += roles[3].data().toString().size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+#endif
+
+// One keystroke in the search field: the query changes, and the proxy
+// filters all rows again. The target is below 1 ms per keystroke.
+void BenchMachineListModel::filterKeystroke()
+{
+    MachineFilterModel filter;
+    filter.setSourceModel(&model);
+    filter.setSearchText("number 499");
+    QCOMPARE(filter.rowCount(), 200);
+
+    const QStringList keystrokes = {"number 4999", "number 499"};
+    int keystroke = 0;
+    int rows = 0;
+    QBENCHMARK {
+        filter.setSearchText(keystrokes.at(keystroke++ % 2));
+        rows += filter.rowCount();
+    }
+    QVERIFY(rows > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchMachineListModel)
+#include "bench_machinelistmodel.moc"
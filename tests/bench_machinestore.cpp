@@ -0,0 +1,114 @@
+#include "data/machinestore.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class BenchMachineStore : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void documentRestore();
+    void streamRestore();
+    void lazyRestore();
+    void sameResult();
+
+private:
+    static QList<Machine> restoreFromDocument(const QByteArray &json);
+
+    QTemporaryDir dir;
+    QByteArray json;
+};
+
+// Number of machines in the synthetic snapshot
+constexpr int MACHINE_COUNT = 50000;
+
+void BenchMachineStore::initTestCase()
+{
+    QVERIFY(dir.isValid());
+
+    QList<Machine> machines;
+    machines.reserve(MACHINE_COUNT);
+    for (int i = 0; i < MACHINE_COUNT; ++i) {
+        Machine machine(QVariantMap{{"extra", i}, {"tags", QVariantList{"retro", "dos"}}});
+        machine.setName(QString("Machine %1").arg(i));
+        machine.setSummary(QString("Summary for the machine number %1").arg(i));
+        machine.setConfigFile(QString("/home/user/86box/machine-%1/86box.cfg").arg(i));
+        machines.append(machine);
+    }
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact(machines));
+
+    QFile file(store.snapshotFileName());
+    QVERIFY(file.open(QFile::ReadOnly));
+    json = file.readAll();
+}
+
+// The old way: build a document and a variant tree, then the machines
+QList<Machine> BenchMachineStore::restoreFromDocument(const QByteArray &json)
+{
+    QList<Machine> machines;
+    const auto variants = QJsonDocument::fromJson(json).toVariant().toList();
+    machines.reserve(variants.size());
+    for (const auto &variant : variants) {
+        machines.append(Machine(variant.toMap()));
+    }
+    return machines;
+}
+
+void BenchMachineStore::documentRestore()
+{
+    QList<Machine> machines;
+    QBENCHMARK {
+        machines = restoreFromDocument(json);
+    }
+    QCOMPARE(machines.size(), MACHINE_COUNT);
+}
+
+void BenchMachineStore::streamRestore()
+{
+    MachineStore store(dir.path());
+    QList<Machine> machines;
+    QBENCHMARK {
+        QVERIFY(store.restore(machines));
+    }
+    QCOMPARE(machines.size(), MACHINE_COUNT);
+}
+
+void BenchMachineStore::lazyRestore()
+{
+    MachineStore store(dir.path());
+    store.setLazyRestore(true);
+    QList<Machine> machines;
+    QBENCHMARK {
+        QVERIFY(store.restore(machines));
+    }
+    QCOMPARE(machines.size(), MACHINE_COUNT);
+}
+
+void BenchMachineStore::sameResult()
+{
+    MachineStore store(dir.path());
+    QList<Machine> machines;
+    QVERIFY(store.restore(machines));
+
+    MachineStore lazyStore(dir.path());
+    lazyStore.setLazyRestore(true);
+    QList<Machine> lazyMachines;
+    QVERIFY(lazyStore.restore(lazyMachines));
+
+    const auto expected = restoreFromDocument(json);
+    QCOMPARE(machines.size(), expected.size());
+    QCOMPARE(lazyMachines.size(), expected.size());
+    for (int i = 0; i < machines.size(); ++i) {
+        QCOMPARE(machines.at(i).save(), expected.at(i).save());
+        QCOMPARE(lazyMachines.at(i).save(), expected.at(i).save());
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchMachineStore)
+#include "bench_machinestore.moc"
@@ -1,5 +1,8 @@
 #include "utils/formatter.h"
+#include "utils/formattercache.h"
 
+#include <QProcess>
+#include <QRandomGenerator>
 #include <QtTest/QTest>
 
 class TestFormatter : public QObject
@@ -14,10 +17,83 @@ private slots:
     void validInput_data();
     void validInput();
 
+    void boundInput_data();
+    void boundInput();
+
+    void filters_data();
+    void filters();
+
+    void conditionals_data();
+    void conditionals();
+
+    void cacheParsesOnce();
+
+    void matchesCharacterParser();
+
+    void arguments_data();
+    void arguments();
+    void argumentsMatchSplitCommand();
+
 private:
     QHash<QString, QString> variables;
 };
 
+namespace {
+
+// The earlier parser, which reads the input one character at a time
+bool characterFormat(const QString &input,
+                     const QHash<QString, QString> &variables,
+                     QString &output)
+{
+    output.clear();
+    QString result;
+    QString string;
+    bool inVariable = false;
+    for (int i = 0; i < input.size(); ++i) {
+        const auto c = input.at(i);
+        const auto next = i + 1 < input.size() ? input.at(i + 1) : QChar();
+        if (inVariable) {
+            if (c == '{') {
+                return false;
+            }
+            if (c == '}') {
+                if (string.isEmpty()) {
+                    return false;
+                }
+                result += variables.value(string);
+                string.clear();
+                inVariable = false;
+            } else {
+                string += c;
+            }
+        } else if (c == '{') {
+            if (next == '{') {
+                string += next;
+                ++i;
+            } else {
+                result += string;
+                string.clear();
+                inVariable = true;
+            }
+        } else if (c == '}') {
+            if (next != '}') {
+                return false;
+            }
+            string += next;
+            ++i;
+        } else {
+            string += c;
+        }
+    }
+    if (inVariable) {
+        return false;
+    }
+    output = result + string;
+    return true;
+}
+
+} // namespace
+
 void TestFormatter::initTestCase()
 {
     variables["test"] = "hello";
@@ -34,6 +110,13 @@ void TestFormatter::invalidInput_data()
     QTest::addRow("empty {}") << "{}";
     QTest::addRow("single {") << "{";
     QTest::addRow("single }") << "}";
+    QTest::addRow("unknown filter") << "{test|upper}";
+    QTest::addRow("empty filter") << "{test|}";
+    QTest::addRow("empty name") << "{|dir}";
+    QTest::addRow("shell not last") << "{test|shell|dir}";
+    QTest::addRow("empty condition") << "{?}";
+    QTest::addRow("unclosed condition") << "{?test}hello";
+    QTest::addRow("unopened condition") << "hello{/}";
 }
 
 void TestFormatter::invalidInput()
@@ -98,5 +181,220 @@ void TestFormatter::validInput()
     QCOMPARE(result, expected);
 }
 
+void TestFormatter::boundInput_data()
+{
+    validInput_data();
+}
+
+void TestFormatter::boundInput()
+{
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    Formatter formatter;
+    QVERIFY(formatter.setInput(input));
+    formatter.bind({"foo", "test"});
+    QCOMPARE(formatter.schema(), QStringList({"foo", "test"}));
+    QCOMPARE(formatter.format(QStringList{"bar", "hello"}), expected);
+
+    // Binding does not change formatting with names
+    QCOMPARE(formatter.format(variables), expected);
+}
+
+void TestFormatter::filters_data()
+{
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::addRow("dir") << "{path|dir}"
+                         << "/home/user/vms";
+    QTest::addRow("basename") << "{path|basename}"
+                              << "86box.cfg";
+    QTest::addRow("dir of dir") << "{path|dir|dir}"
+                                << "/home/user";
+    QTest::addRow("windows path") << "{windows|dir} {windows|basename}"
+                                  << R"(C:\VMs 86box.cfg)";
+    QTest::addRow("dir without separator") << "{name|dir}"
+                                           << ".";
+    QTest::addRow("dir of root") << "{root|dir}"
+                                 << "/";
+    QTest::addRow("shell") << "echo {name|shell}"
+                           << R"(echo 'it'\''s')";
+    QTest::addRow("shell after basename") << "{path|basename|shell}"
+                                          << "'86box.cfg'";
+    QTest::addRow("shell of missing") << "{none|shell}"
+                                      << "''";
+}
+
+void TestFormatter::filters()
+{
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    const QHash<QString, QString> pathVariables = {{"path", "/home/user/vms/86box.cfg"},
+                                                   {"windows", R"(C:\VMs\86box.cfg)"},
+                                                   {"name", "it's"},
+                                                   {"root", "/vms"}};
+    Formatter formatter;
+    QVERIFY(formatter.setInput(input));
+    QCOMPARE(formatter.format(pathVariables), expected);
+
+    formatter.bind(pathVariables.keys());
+    QStringList values;
+    for (const auto &name : formatter.schema()) {
+        values.append(pathVariables.value(name));
+    }
+    QCOMPARE(formatter.format(values), expected);
+}
+
+void TestFormatter::conditionals_data()
+{
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::addRow("set") << "a{?test} {test}{/} b"
+                         << "a hello b";
+    QTest::addRow("missing") << "a{?none} {none}{/} b"
+                             << "a b";
+    QTest::addRow("empty") << "a{?empty}!{/}"
+                           << "a";
+    QTest::addRow("nested") << "{?test}1{?none}2{/}3{?foo}4{/}{/}5"
+                            << "1345";
+    QTest::addRow("nested outer missing") << "{?none}1{?test}2{/}3{/}4"
+                                          << "4";
+    QTest::addRow("with braces") << "{?test}{{{test}}}{/}"
+                                 << "{hello}";
+}
+
+void TestFormatter::conditionals()
+{
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    auto conditionVariables = variables;
+    conditionVariables["empty"] = QString();
+    Formatter formatter;
+    QVERIFY(formatter.setInput(input));
+    QCOMPARE(formatter.format(conditionVariables), expected);
+
+    formatter.bind({"test", "foo", "empty"});
+    QCOMPARE(formatter.format(QStringList{"hello", "bar", ""}), expected);
+}
+
+void TestFormatter::cacheParsesOnce()
+{
+    auto &cache = FormatterCache::instance();
+    cache.clear();
+
+    bool ok = false;
+    QCOMPARE(cache.format("{test} {foo}", variables, &ok), QString("hello bar"));
+    QVERIFY(ok);
+    QCOMPARE(cache.format("{test} {foo}", {{"test", "a"}, {"foo", "b"}}, &ok), QString("a b"));
+    QVERIFY(ok);
+    QCOMPARE(cache.format("{test", variables, &ok), QString{});
+    QVERIFY(!ok);
+    QCOMPARE(cache.format("{test", variables, &ok), QString{});
+    QVERIFY(!ok);
+
+    const QStringList schema = {"test", "foo"};
+    QVERIFY(cache.formatter("{test} {foo}", schema).format(QStringList{"a", "b"}) == "a b");
+    QVERIFY(cache.formatter("{test} {foo}", schema).format(QStringList{"c", "d"}) == "c d");
+
+    QCOMPARE(cache.size(), 3);
+    QCOMPARE(cache.misses(), 3);
+    QCOMPARE(cache.hits(), 3);
+}
+
+void TestFormatter::matchesCharacterParser()
+{
+    const QHash<QString, QString> fuzzVariables = {{"a", "1"}, {"b", "22"}, {"ab", "333"}};
+    const QString alphabet = "{}ab ";
+    QRandomGenerator generator(2024);
+
+    for (int round = 0; round < 20000; ++round) {
+        QString input;
+        const auto length = generator.bounded(16);
+        for (int i = 0; i < length; ++i) {
+            input += alphabet.at(generator.bounded(static_cast<int>(alphabet.size())));
+        }
+
+        QString expected;
+        const auto expectedOk = characterFormat(input, fuzzVariables, expected);
+        bool ok = false;
+        const auto result = Formatter::format(input, fuzzVariables, &ok);
+        QVERIFY2(ok == expectedOk, qPrintable(input));
+        QVERIFY2(result == expected, qPrintable(input));
+    }
+}
+
+void TestFormatter::arguments_data()
+{
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QStringList>("expected");
+
+    const QString emulator = "/opt/86 Box/86Box";
+    const QString config = R"(C:\VMs\"odd" name\86box.cfg)";
+    QTest::addRow("empty") << "" << QStringList();
+    QTest::addRow("default command") << "{86box} --config {config}"
+                                     << QStringList({emulator, "--config", config});
+    QTest::addRow("quoted variables") << R"("{86box}" -c "{config}")"
+                                      << QStringList({emulator, "-c", config});
+    QTest::addRow("quoted text") << R"("/usr/bin/my emulator" {config})"
+                                 << QStringList({"/usr/bin/my emulator", config});
+    QTest::addRow("triple quotes") << R"(echo """hi""")" << QStringList({"echo", R"("hi")"});
+    QTest::addRow("extra spaces") << "  {86box}   --settings  "
+                                  << QStringList({emulator, "--settings"});
+    QTest::addRow("variable in argument") << "{86box} --config={config}"
+                                          << QStringList({emulator, "--config=" + config});
+    QTest::addRow("braces") << "{86box} {{x}}" << QStringList({emulator, "{x}"});
+    QTest::addRow("missing variable") << "{86box} {none} -S" << QStringList({emulator, "-S"});
+    QTest::addRow("optional flag") << "{86box}{?config} --config {config}{/}{?none} -n {none}{/}"
+                                   << QStringList({emulator, "--config", config});
+    QTest::addRow("optional quoted flag") << R"({86box} {?config}"--config={config}"{/} -S)"
+                                          << QStringList({emulator, "--config=" + config, "-S"});
+    QTest::addRow("filters") << "{86box|basename} -P {config|dir}"
+                             << QStringList({"86Box", "-P", R"(C:\VMs\"odd" name)"});
+}
+
+void TestFormatter::arguments()
+{
+    QFETCH(QString, input);
+    QFETCH(QStringList, expected);
+
+    const QHash<QString, QString> commandVariables = {{"86box", "/opt/86 Box/86Box"},
+                                                      {"config", R"(C:\VMs\"odd" name\86box.cfg)"}};
+    Formatter formatter;
+    QVERIFY(formatter.setInput(input));
+    QCOMPARE(formatter.formatArguments(commandVariables), expected);
+
+    formatter.bind({"config", "86box"});
+    QCOMPARE(formatter.formatArguments(QStringList({commandVariables.value("config"),
+                                                    commandVariables.value("86box")})),
+             expected);
+}
+
+void TestFormatter::argumentsMatchSplitCommand()
+{
+    const QHash<QString, QString> fuzzVariables = {{"a", "1"}, {"b", "22"}, {"ab", "333"}};
+    const QString alphabet = R"({}ab ")";
+    QRandomGenerator generator(2024);
+
+    for (int round = 0; round < 20000; ++round) {
+        QString input;
+        const auto length = generator.bounded(18);
+        for (int i = 0; i < length; ++i) {
+            input += alphabet.at(generator.bounded(static_cast<int>(alphabet.size())));
+        }
+
+        // Values without spaces or quotes split the same way in a flat string
+        Formatter formatter;
+        if (!formatter.setInput(input) || !formatter.bind(fuzzVariables.keys())) {
+            continue;
+        }
+        const auto expected = QProcess::splitCommand(formatter.format(fuzzVariables));
+        QVERIFY2(formatter.formatArguments(fuzzVariables) == expected, qPrintable(input));
+    }
+}
+
 QTEST_GUILESS_MAIN(TestFormatter)
 #include "test_formatter.moc"
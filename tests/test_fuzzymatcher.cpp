@@ -0,0 +1,106 @@
+#include "utils/fuzzymatcher.h"
+
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtTest/QTest>
+
+class TestFuzzyMatcher : public QObject
+{
+    Q_OBJECT
+private slots:
+    void subsequence_is_required();
+    void word_starts_rank_higher();
+    void ties_prefer_shorter_texts();
+    void empty_pattern_keeps_order();
+    void parallel_matches_serial();
+    void busy_global_pool_does_not_block();
+};
+
+void TestFuzzyMatcher::subsequence_is_required()
+{
+    QVERIFY(FuzzyMatcher::score("w98", "Windows 98") > 0);
+    QVERIFY(FuzzyMatcher::score("W98", "windows 98") > 0);
+    QCOMPARE(FuzzyMatcher::score("98w", "Windows 98"), -1);
+    QCOMPARE(FuzzyMatcher::score("xyz", "Windows 98"), -1);
+}
+
+void TestFuzzyMatcher::word_starts_rank_higher()
+{
+    QVERIFY(FuzzyMatcher::score("dos", "MS-DOS 6.22") > FuzzyMatcher::score("dos", "Windows"));
+    QVERIFY(FuzzyMatcher::score("pc", "IBM PC") > FuzzyMatcher::score("pc", "Epic"));
+    QVERIFY(FuzzyMatcher::score("ab", "ab") > FuzzyMatcher::score("ab", "a-b"));
+
+    FuzzyMatcher matcher;
+    matcher.setCandidates({"Windows 2000", "Windows 98 SE", "MS-DOS 6.22"});
+    const auto matches = matcher.match("w98");
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches.first().index, 1);
+}
+
+void TestFuzzyMatcher::ties_prefer_shorter_texts()
+{
+    FuzzyMatcher matcher;
+    matcher.setCandidates({"Amiga 1200", "Amiga", "Amiga 500"});
+    const auto matches = matcher.match("amiga");
+    QCOMPARE(matches.size(), 3);
+    QCOMPARE(matches.at(0).index, 1);
+    QCOMPARE(matches.at(1).index, 2);
+    QCOMPARE(matches.at(2).index, 0);
+}
+
+void TestFuzzyMatcher::empty_pattern_keeps_order()
+{
+    FuzzyMatcher matcher;
+    matcher.setCandidates({"c", "b", "a"});
+    const auto matches = matcher.match({}, 2);
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).index, 0);
+    QCOMPARE(matches.at(1).index, 1);
+}
+
+void TestFuzzyMatcher::parallel_matches_serial()
+{
+    QStringList candidates;
+    for (int i = 0; i < 50000; ++i) {
+        candidates.append(QString("Machine %1 with Pentium %2").arg(i).arg(i % 7));
+    }
+    FuzzyMatcher matcher;
+    matcher.setCandidates(candidates);
+
+    QList<FuzzyMatcher::Match> matches;
+    QBENCHMARK {
+        matches = matcher.match("m123p", 20);
+    }
+    QCOMPARE(matches.size(), 20);
+    for (const auto &match : matches) {
+        QCOMPARE(match.score, FuzzyMatcher::score("m123p", candidates.at(match.index)));
+    }
+    for (int i = 1; i < matches.size(); ++i) {
+        QVERIFY(matches.at(i - 1).score >= matches.at(i).score);
+    }
+}
+
+void TestFuzzyMatcher::busy_global_pool_does_not_block()
+{
+    QStringList candidates;
+    for (int i = 0; i < 50000; ++i) {
+        candidates.append(QString("Machine %1").arg(i));
+    }
+    FuzzyMatcher matcher;
+    matcher.setCandidates(candidates);
+
+    // Keep every thread of the global pool busy until matching is done
+    auto *pool = QThreadPool::globalInstance();
+    QSemaphore release;
+    for (int i = 0; i < pool->maxThreadCount(); ++i) {
+        pool->start([&release]() { release.acquire(); });
+    }
+
+    const auto matches = matcher.match("m4999");
+    release.release(pool->maxThreadCount());
+    pool->waitForDone();
+    QCOMPARE(matches.size(), 41);
+}
+
+QTEST_GUILESS_MAIN(TestFuzzyMatcher)
+#include "test_fuzzymatcher.moc"
@@ -0,0 +1,66 @@
+#include "data/iconcache.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class TestIconCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+
+    void machines_share_icons();
+    void modified_file_is_reloaded();
+};
+
+void TestIconCache::init()
+{
+    IconCache::instance().clear();
+    IconCache::instance().setFileCheckInterval(0);
+}
+
+void TestIconCache::machines_share_icons()
+{
+    Machine a;
+    a.setIcon(Machine::IconFromFile, TEST_ICON);
+    Machine b;
+    b.setIcon(Machine::IconFromFile, TEST_ICON);
+    Machine none;
+
+    const auto icon = a.icon();
+    QVERIFY(!icon.isNull());
+    QCOMPARE(b.icon().cacheKey(), icon.cacheKey());
+    QVERIFY(none.icon().isNull());
+
+    auto &cache = IconCache::instance();
+    QCOMPARE(cache.size(), 1);
+    QCOMPARE(cache.misses(), 1);
+    QCOMPARE(cache.hits(), 1);
+}
+
+void TestIconCache::modified_file_is_reloaded()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.filePath("icon.svg");
+    QVERIFY(QFile::copy(TEST_ICON, fileName));
+
+    auto &cache = IconCache::instance();
+    const auto icon = cache.icon(Machine::IconFromFile, fileName);
+    QCOMPARE(cache.icon(Machine::IconFromFile, fileName).cacheKey(), icon.cacheKey());
+    QCOMPARE(cache.misses(), 1);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(60),
+                             QFileDevice::FileModificationTime));
+    file.close();
+
+    QVERIFY(cache.icon(Machine::IconFromFile, fileName).cacheKey() != icon.cacheKey());
+    QCOMPARE(cache.misses(), 2);
+    QCOMPARE(cache.hits(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestIconCache)
+#include "test_iconcache.moc"
@@ -0,0 +1,117 @@
+#include "mvc/iconpixmapcache.h"
+
+#include <QIcon>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class TestIconPixmapCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void theme_icons_are_rendered_once();
+    void pending_reads_are_shared();
+    void unreadable_file_is_rendered();
+    void cost_is_pixel_data();
+
+private:
+    static QIcon solidIcon(int size);
+};
+
+// Icon with a solid 32-bit pixmap of the given size
+QIcon TestIconPixmapCache::solidIcon(int size)
+{
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::darkCyan);
+    return QIcon(QPixmap::fromImage(image));
+}
+
+void TestIconPixmapCache::theme_icons_are_rendered_once()
+{
+    IconPixmapCache cache;
+    QSignalSpy ready(&cache, &IconPixmapCache::pixmapReady);
+    const auto icon = solidIcon(64);
+
+    const auto pixmap = cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(32, 32), 1.0);
+    QVERIFY(!pixmap.isNull());
+    QCOMPARE(pixmap.size(), QSize(32, 32));
+    QCOMPARE(cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(32, 32), 1.0).cacheKey(),
+             pixmap.cacheKey());
+    QCOMPARE(ready.count(), 0);
+
+    // Another device pixel ratio is another pixmap
+    const auto hiDpi = cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(32, 32), 2.0);
+    QCOMPARE(hiDpi.size(), QSize(64, 64));
+    QCOMPARE(hiDpi.devicePixelRatio(), 2.0);
+}
+
+void TestIconPixmapCache::pending_reads_are_shared()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.filePath("icon.png");
+    QImage image(64, 64, QImage::Format_ARGB32);
+    image.fill(Qt::darkRed);
+    QVERIFY(image.save(fileName));
+
+    IconPixmapCache cache;
+    QSignalSpy ready(&cache, &IconPixmapCache::pixmapReady);
+    const QIcon icon(fileName);
+
+    // Both requests wait for the same read
+    QVERIFY(cache.pixmap(icon, Machine::IconFromFile, fileName, QSize(32, 32), 1.0).isNull());
+    QVERIFY(cache.pixmap(icon, Machine::IconFromFile, fileName, QSize(32, 32), 1.0).isNull());
+    QTRY_COMPARE(ready.count(), 1);
+    QTest::qWait(50);
+    QCOMPARE(ready.count(), 1);
+
+    const auto pixmap = cache.pixmap(icon, Machine::IconFromFile, fileName, QSize(32, 32), 1.0);
+    QCOMPARE(pixmap.size(), QSize(32, 32));
+    QCOMPARE(pixmap.toImage().pixelColor(16, 16), QColor(Qt::darkRed));
+}
+
+void TestIconPixmapCache::unreadable_file_is_rendered()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    IconPixmapCache cache;
+    QSignalSpy ready(&cache, &IconPixmapCache::pixmapReady);
+    const auto icon = solidIcon(32);
+    const auto fileName = dir.filePath("missing.png");
+
+    QVERIFY(cache.pixmap(icon, Machine::IconFromFile, fileName, QSize(32, 32), 1.0).isNull());
+    QTRY_COMPARE(ready.count(), 1);
+
+    const auto pixmap = cache.pixmap(icon, Machine::IconFromFile, fileName, QSize(32, 32), 1.0);
+    QCOMPARE(pixmap.size(), QSize(32, 32));
+    QCOMPARE(pixmap.toImage().pixelColor(16, 16), QColor(Qt::darkCyan));
+}
+
+void TestIconPixmapCache::cost_is_pixel_data()
+{
+    IconPixmapCache cache;
+    const auto icon = solidIcon(64);
+    QCOMPARE(cache.totalCost(), 0);
+
+    // 64 x 64 x 4 bytes is 16 kB, and 32 x 32 x 4 bytes is 4 kB
+    QVERIFY(!cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(64, 64), 1.0).isNull());
+    QCOMPARE(cache.totalCost(), 16);
+    QVERIFY(!cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(32, 32), 1.0).isNull());
+    QCOMPARE(cache.totalCost(), 20);
+
+    // Small pixmaps cost at least one kilobyte
+    QVERIFY(!cache.pixmap(icon, Machine::IconFromTheme, "pc", QSize(8, 8), 1.0).isNull());
+    QCOMPARE(cache.totalCost(), 21);
+
+    // A smaller maximum drops the least recently used pixmaps
+    cache.setMaxCost(20);
+    QCOMPARE(cache.maxCost(), 20);
+    QVERIFY(cache.totalCost() <= 20);
+    cache.clear();
+    QCOMPARE(cache.totalCost(), 0);
+}
+
+QTEST_MAIN(TestIconPixmapCache)
+#include "test_iconpixmapcache.moc"
@@ -0,0 +1,121 @@
+#include "data/jsonstreamreader.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtTest/QTest>
+
+class TestJsonStreamReader : public QObject
+{
+    Q_OBJECT
+private slots:
+    void tokens();
+
+    void invalidInput_data();
+    void invalidInput();
+
+    void sameAsJsonDocument_data();
+    void sameAsJsonDocument();
+
+    void skipValue();
+};
+
+void TestJsonStreamReader::tokens()
+{
+    JsonStreamReader reader(R"( [ {"a": "b\n", "c": -1.5e2}, true, null ] )");
+    QCOMPARE(reader.readNext(), JsonStreamReader::StartArray);
+    QCOMPARE(reader.readNext(), JsonStreamReader::StartObject);
+    QCOMPARE(reader.readNext(), JsonStreamReader::Name);
+    QCOMPARE(reader.text(), QString("a"));
+    QCOMPARE(reader.readNext(), JsonStreamReader::String);
+    QCOMPARE(reader.text(), QString("b\n"));
+    QCOMPARE(reader.readNext(), JsonStreamReader::Name);
+    QCOMPARE(reader.text(), QString("c"));
+    QCOMPARE(reader.readNext(), JsonStreamReader::Number);
+    QCOMPARE(reader.toVariant().toDouble(), -150.0);
+    QCOMPARE(reader.readNext(), JsonStreamReader::EndObject);
+    QCOMPARE(reader.readNext(), JsonStreamReader::Bool);
+    QCOMPARE(reader.toVariant(), QVariant(true));
+    QCOMPARE(reader.readNext(), JsonStreamReader::Null);
+    QCOMPARE(reader.readNext(), JsonStreamReader::EndArray);
+    QCOMPARE(reader.readNext(), JsonStreamReader::EndDocument);
+    QVERIFY(!reader.hasError());
+}
+
+void TestJsonStreamReader::invalidInput_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addRow("empty") << QByteArray("");
+    QTest::addRow("unterminated array") << QByteArray("[1, 2");
+    QTest::addRow("unterminated string") << QByteArray(R"(["abc)");
+    QTest::addRow("trailing comma") << QByteArray("[1, 2,]");
+    QTest::addRow("trailing comma in object") << QByteArray(R"({"a": 1,})");
+    QTest::addRow("missing comma") << QByteArray("[1 2]");
+    QTest::addRow("missing colon") << QByteArray(R"({"a" 1})");
+    QTest::addRow("missing value") << QByteArray(R"({"a":})");
+    QTest::addRow("name is not a string") << QByteArray("{a: 1}");
+    QTest::addRow("mismatched brackets") << QByteArray("[1}");
+    QTest::addRow("invalid literal") << QByteArray("[tru]");
+    QTest::addRow("invalid number") << QByteArray("[-]");
+    QTest::addRow("invalid fraction") << QByteArray("[1.]");
+    QTest::addRow("invalid escape") << QByteArray(R"(["\x"])");
+    QTest::addRow("invalid unicode escape") << QByteArray(R"(["\u12g4"])");
+    QTest::addRow("garbage at the end") << QByteArray("[] []");
+}
+
+void TestJsonStreamReader::invalidInput()
+{
+    QFETCH(QByteArray, input);
+
+    JsonStreamReader reader(input);
+    auto token = reader.readNext();
+    while (token != JsonStreamReader::Invalid && token != JsonStreamReader::EndDocument) {
+        token = reader.readNext();
+    }
+    QCOMPARE(token, JsonStreamReader::Invalid);
+    QVERIFY(reader.hasError());
+    QVERIFY(!reader.errorString().isEmpty());
+}
+
+void TestJsonStreamReader::sameAsJsonDocument_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addRow("empty array") << QByteArray("[]");
+    QTest::addRow("empty object") << QByteArray("{}");
+    QTest::addRow("scalars") << QByteArray(R"([1, -2, 0.5, 1e3, true, false, null, ""])");
+    QTest::addRow("nested") << QByteArray(R"({"a": [{"b": {"c": []}}, [1, [2]]], "d": {}})");
+    QTest::addRow("escapes") << QByteArray(R"(["\"\\\/\b\f\n\r\t", "ä€", "😀"])");
+    QTest::addRow("utf-8") << QByteArray("[\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\"]");
+    QTest::addRow("whitespace") << QByteArray(" \n\t{ \"a\" :\r\n 1 , \"b\" : [ ] }\n");
+}
+
+void TestJsonStreamReader::sameAsJsonDocument()
+{
+    QFETCH(QByteArray, input);
+
+    const auto document = QJsonDocument::fromJson(input);
+    const auto expected = document.isArray() ? QJsonValue(document.array())
+                                             : QJsonValue(document.object());
+
+    JsonStreamReader reader(input);
+    reader.readNext();
+    const auto value = reader.readValue();
+    QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+    QCOMPARE(reader.readNext(), JsonStreamReader::EndDocument);
+    QCOMPARE(QJsonValue::fromVariant(value), expected);
+}
+
+void TestJsonStreamReader::skipValue()
+{
+    JsonStreamReader reader(R"([{"a": [1, {"b": 2}]}, "next"])");
+    QCOMPARE(reader.readNext(), JsonStreamReader::StartArray);
+    QCOMPARE(reader.readNext(), JsonStreamReader::StartObject);
+    QVERIFY(reader.skipValue());
+    QCOMPARE(reader.tokenType(), JsonStreamReader::EndObject);
+    QCOMPARE(reader.readNext(), JsonStreamReader::String);
+    QCOMPARE(reader.text(), QString("next"));
+    QCOMPARE(reader.readNext(), JsonStreamReader::EndArray);
+}
+
+QTEST_GUILESS_MAIN(TestJsonStreamReader)
+#include "test_jsonstreamreader.moc"
@@ -8,6 +8,7 @@ class TestMachine : public QObject
 private slots:
     void save_and_restore();
     void extra_varibles_are_kept();
+    void id_is_kept_or_assigned();
 };
 
 void TestMachine::save_and_restore()
@@ -45,7 +46,8 @@ void TestMachine::save_and_restore()
 
 void TestMachine::extra_varibles_are_kept()
 {
-    QVariantMap customConfig = {{"configFile", "config-file"},
+    QVariantMap customConfig = {{"id", "0f8fad5b-d9cb-469f-a165-70867728950e"},
+                                {"configFile", "config-file"},
                                 {"iconName", TEST_ICON},
                                 {"iconType", Machine::IconFromFile},
                                 {"name", "Test machine"},
@@ -57,5 +59,38 @@ void TestMachine::extra_varibles_are_kept()
     QCOMPARE(customConfig, machine.save());
 }
 
+void TestMachine::id_is_kept_or_assigned()
+{
+    Machine a;
+    QVERIFY(!a.id().isNull());
+    QVERIFY(a.id() != Machine().id());
+    QVERIFY(!a.idAssigned());
+
+    Machine b(a.save());
+    QCOMPARE(b.id(), a.id());
+    QVERIFY(!b.idAssigned());
+    b.setName("Renamed");
+    QCOMPARE(b.id(), a.id());
+
+    // The ID is created on the first read, and copies share it
+    Machine c;
+    Machine d = c;
+    d.setName("Copy");
+    QVERIFY(!c.id().isNull());
+    QCOMPARE(d.id(), c.id());
+
+    // Configurations saved before IDs get a new ID
+    Machine old(QVariantMap{{"name", "Old machine"}});
+    QVERIFY(!old.id().isNull());
+    QCOMPARE(old.save().value("id").toString(), old.id().toString(QUuid::WithoutBraces));
+    QVERIFY(!old.extraVariables().contains("id"));
+    QVERIFY(old.idAssigned());
+
+    // Once saved, the assigned ID is restored
+    Machine saved(old.save());
+    QCOMPARE(saved.id(), old.id());
+    QVERIFY(!saved.idAssigned());
+}
+
 QTEST_GUILESS_MAIN(TestMachine)
 #include "test_machine.moc"
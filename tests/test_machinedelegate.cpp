@@ -0,0 +1,107 @@
+#include "mvc/machinedelegate.h"
+#include "mvc/machinelistmodel.h"
+
+#include <QApplication>
+#include <QProxyStyle>
+#include <QtTest/QTest>
+
+#include <algorithm>
+
+class TestMachineDelegate : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void texts_are_cached();
+    void font_change_clears_cache();
+    void palette_change_clears_cache();
+    void style_change_clears_cache();
+
+private:
+    [[nodiscard]] int sizeHintWidth(const MachineDelegate &delegate) const;
+
+    MachineListModel model;
+    QStyleOptionViewItem option;
+};
+
+void TestMachineDelegate::initTestCase()
+{
+    QList<Machine> machines;
+    for (int i = 0; i < 3; ++i) {
+        Machine machine;
+        machine.setName(QString("Machine %1").arg(i));
+        machine.setSummary(QString("Summary %1").arg(i));
+        machines.append(machine);
+    }
+    model.setMachines(machines);
+
+    option.rect = QRect(0, 0, 320, 48);
+    option.decorationSize = QSize(32, 32);
+    option.font = QApplication::font();
+    option.font.setPointSize(10);
+    option.palette = QApplication::palette();
+}
+
+// Size hints of all rows, which measures the name and summary of each row
+int TestMachineDelegate::sizeHintWidth(const MachineDelegate &delegate) const
+{
+    int width = 0;
+    for (int row = 0; row < model.rowCount({}); ++row) {
+        width = std::max(width, delegate.sizeHint(option, model.index(row)).width());
+    }
+    return width;
+}
+
+void TestMachineDelegate::texts_are_cached()
+{
+    MachineDelegate delegate;
+    QCOMPARE(delegate.cachedTextCount(), 0);
+    const auto width = sizeHintWidth(delegate);
+    QCOMPARE(delegate.cachedTextCount(), 6);
+    QCOMPARE(sizeHintWidth(delegate), width);
+    QCOMPARE(delegate.cachedTextCount(), 6);
+}
+
+void TestMachineDelegate::font_change_clears_cache()
+{
+    MachineDelegate delegate;
+    const auto width = sizeHintWidth(delegate);
+    QCOMPARE(delegate.cachedTextCount(), 6);
+
+    const auto font = option.font;
+    option.font.setPointSize(20);
+    QVERIFY(delegate.sizeHint(option, model.index(0)).isValid());
+    QCOMPARE(delegate.cachedTextCount(), 2);
+    QVERIFY(sizeHintWidth(delegate) > width);
+    option.font = font;
+}
+
+void TestMachineDelegate::palette_change_clears_cache()
+{
+    MachineDelegate delegate;
+    QVERIFY(sizeHintWidth(delegate) > 0);
+    QCOMPARE(delegate.cachedTextCount(), 6);
+
+    const auto palette = option.palette;
+    option.palette.setColor(QPalette::Window, Qt::darkBlue);
+    QVERIFY(delegate.sizeHint(option, model.index(0)).isValid());
+    QCOMPARE(delegate.cachedTextCount(), 2);
+    option.palette = palette;
+}
+
+void TestMachineDelegate::style_change_clears_cache()
+{
+    QProxyStyle style;
+    QWidget widget;
+    auto *delegate = new MachineDelegate(&widget);
+    QVERIFY(sizeHintWidth(*delegate) > 0);
+    QCOMPARE(delegate->cachedTextCount(), 6);
+
+    widget.setStyle(&style);
+    QVERIFY(delegate->sizeHint(option, model.index(0)).isValid());
+    QCOMPARE(delegate->cachedTextCount(), 2);
+}
+
+QTEST_MAIN(TestMachineDelegate)
+#include "test_machinedelegate.moc"
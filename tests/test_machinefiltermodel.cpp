@@ -0,0 +1,119 @@
+#include "mvc/machinefiltermodel.h"
+#include "mvc/machinelistmodel.h"
+
+#include <QtTest/QTest>
+
+class TestMachineFilterModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void normalize_ignores_case_and_accents();
+    void index_matches_all_words();
+    void filter_follows_source_changes();
+    void large_list_filters_quickly();
+
+private:
+    static Machine machine(const QString &name,
+                           const QString &summary = {},
+                           const QString &configFile = {});
+    static QStringList names(const QAbstractItemModel &model);
+};
+
+Machine TestMachineFilterModel::machine(const QString &name,
+                                        const QString &summary,
+                                        const QString &configFile)
+{
+    Machine machine;
+    machine.setName(name);
+    machine.setSummary(summary);
+    machine.setConfigFile(configFile);
+    return machine;
+}
+
+QStringList TestMachineFilterModel::names(const QAbstractItemModel &model)
+{
+    QStringList names;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        names.append(model.index(row, 0).data().toString());
+    }
+    return names;
+}
+
+void TestMachineFilterModel::normalize_ignores_case_and_accents()
+{
+    QCOMPARE(MachineSearchIndex::normalize("Café DOS"), QString("cafe dos"));
+    QCOMPARE(MachineSearchIndex::normalize("Pentium Ⅱ"), QString("pentium ii"));
+}
+
+void TestMachineFilterModel::index_matches_all_words()
+{
+    MachineSearchIndex index;
+    index.reset({machine("IBM PC", "8088"),
+                 machine("Pentium", "Windows 98", "/vms/win98/86box.cfg"),
+                 machine("486", "DOS")});
+
+    index.setQuery("win 98");
+    QVERIFY(!index.matches(0));
+    QVERIFY(index.matches(1));
+    QVERIFY(!index.matches(2));
+
+    index.setQuery("VMS");
+    QVERIFY(index.matches(1));
+
+    index.setQuery("  ");
+    QVERIFY(index.matches(0));
+    QVERIFY(index.matches(2));
+}
+
+void TestMachineFilterModel::filter_follows_source_changes()
+{
+    MachineListModel source;
+    source.setMachines({machine("Amiga"), machine("Atari"), machine("IBM PC")});
+
+    MachineFilterModel filter;
+    filter.setSourceModel(&source);
+    filter.setSearchText("a");
+    QCOMPARE(names(filter), QStringList({"Amiga", "Atari"}));
+
+    source.addMachines({machine("Apple"), machine("Commodore")});
+    QCOMPARE(names(filter), QStringList({"Amiga", "Atari", "Apple"}));
+
+    source.setMachineForIndex(source.index(1), machine("C64"));
+    QCOMPARE(names(filter), QStringList({"Amiga", "Apple"}));
+
+    source.removeMachines({source.index(0)});
+    source.moveRows({}, 2, 1, {}, 0);
+    QCOMPARE(names(filter), QStringList({"Apple"}));
+
+    filter.setSearchText({});
+    QCOMPARE(filter.rowCount(), 4);
+}
+
+void TestMachineFilterModel::large_list_filters_quickly()
+{
+    QList<Machine> machines;
+    for (int i = 0; i < 50000; ++i) {
+        machines.append(machine(QString("Machine %1").arg(i),
+                                QString("Summary for machine number %1").arg(i)));
+    }
+
+    MachineSearchIndex index;
+    index.reset(machines);
+    index.setQuery("warm up");
+    for (int row = 0; row < index.size(); ++row) {
+        index.matches(row);
+    }
+
+    int found = 0;
+    QBENCHMARK {
+        index.setQuery("number 4999");
+        found = 0;
+        for (int row = 0; row < index.size(); ++row) {
+            found += index.matches(row) ? 1 : 0;
+        }
+    }
+    QCOMPARE(found, 15);
+}
+
+QTEST_GUILESS_MAIN(TestMachineFilterModel)
+#include "test_machinefiltermodel.moc"
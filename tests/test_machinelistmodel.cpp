@@ -0,0 +1,410 @@
+#include "mvc/machinecommands.h"
+#include "mvc/machinelistmodel.h"
+#include "mvc/machinemimedata.h"
+
+#include <QSignalSpy>
+#include <QUndoStack>
+#include <QtTest/QTest>
+
+#include <array>
+
+class TestMachineListModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void move_rows();
+    void move_scattered_machines();
+    void internal_drop_moves_rows();
+    void mime_data_converts_to_json();
+    void add_machines_at_once();
+    void remove_machines_by_range();
+    void replace_machines_by_range();
+    void index_follows_machine_ids();
+    void index_follows_scattered_rows();
+    void duplicate_ids_are_replaced();
+    void changes_are_collected_per_turn();
+    void undo_insert_and_remove();
+    void undo_replace();
+    void undo_moves();
+    void undo_internal_drop();
+    void undo_after_drag();
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    void multi_data_matches_data();
+#endif
+
+private:
+    static QList<Machine> machines(const QStringList &names);
+    static QStringList names(const MachineListModel &model);
+};
+
+QList<Machine> TestMachineListModel::machines(const QStringList &names)
+{
+    QList<Machine> machines;
+    for (const auto &name : names) {
+        Machine machine;
+        machine.setName(name);
+        machines.append(machine);
+    }
+    return machines;
+}
+
+QStringList TestMachineListModel::names(const MachineListModel &model)
+{
+    QStringList names;
+    for (const auto &machine : model.machines()) {
+        names.append(machine.name());
+    }
+    return names;
+}
+
+void TestMachineListModel::move_rows()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e"}));
+    QSignalSpy moved(&model, &MachineListModel::rowsMoved);
+
+    QVERIFY(model.moveRows({}, 1, 2, {}, 5));
+    QCOMPARE(names(model), QStringList({"a", "d", "e", "b", "c"}));
+    QVERIFY(model.moveRows({}, 3, 2, {}, 0));
+    QCOMPARE(names(model), QStringList({"b", "c", "a", "d", "e"}));
+    QCOMPARE(moved.count(), 2);
+
+    // Moving rows over themselves is not possible
+    QVERIFY(!model.moveRows({}, 1, 2, {}, 2));
+}
+
+void TestMachineListModel::move_scattered_machines()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e"}));
+    QSignalSpy layoutChanged(&model, &MachineListModel::layoutChanged);
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+    const QPersistentModelIndex d = model.index(3);
+
+    QVERIFY(model.moveMachines({3, 0, 4}, 2));
+    QCOMPARE(names(model), QStringList({"b", "a", "d", "e", "c"}));
+    QCOMPARE(layoutChanged.count(), 1);
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(d.row(), 2);
+}
+
+void TestMachineListModel::internal_drop_moves_rows()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c"}));
+    QSignalSpy inserted(&model, &MachineListModel::rowsInserted);
+
+    QScopedPointer<QMimeData> data(model.mimeData({model.index(0), model.index(1)}));
+    QVERIFY(!model.dropMimeData(data.data(), Qt::MoveAction, 3, 0, {}));
+    QCOMPARE(names(model), QStringList({"c", "a", "b"}));
+    QCOMPARE(inserted.count(), 0);
+}
+
+void TestMachineListModel::mime_data_converts_to_json()
+{
+    MachineListModel source;
+    source.setMachines(machines({"a", "b", "c"}));
+    QScopedPointer<QMimeData> data(source.mimeData({source.index(2), source.index(0)}));
+    QVERIFY(data->hasFormat(MachineMimeData::JSON_MIME_TYPE));
+
+    MachineListModel target;
+    target.setMachines(machines({"x"}));
+    QVERIFY(target.dropMimeData(data.data(), Qt::MoveAction, 0, 0, {}));
+    QCOMPARE(names(target), QStringList({"a", "c", "x"}));
+}
+
+void TestMachineListModel::add_machines_at_once()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a"}));
+    QSignalSpy inserted(&model, &MachineListModel::rowsInserted);
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+
+    model.addMachines(machines({"b", "c"}));
+    QCOMPARE(names(model), QStringList({"a", "b", "c"}));
+    QCOMPARE(inserted.count(), 1);
+    QTRY_COMPARE(changed.count(), 1);
+}
+
+void TestMachineListModel::remove_machines_by_range()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e", "f"}));
+    QSignalSpy removed(&model, &MachineListModel::rowsRemoved);
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+
+    model.removeMachines({model.index(4), model.index(1), model.index(2), model.index(5)});
+    QCOMPARE(names(model), QStringList({"a", "d"}));
+    QCOMPARE(removed.count(), 2);
+    QTRY_COMPARE(changed.count(), 1);
+}
+
+void TestMachineListModel::replace_machines_by_range()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d"}));
+    QSignalSpy dataChanged(&model, &MachineListModel::dataChanged);
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+
+    model.replaceMachines({model.index(0), model.index(3), model.index(1)},
+                          machines({"A", "D", "B"}));
+    QCOMPARE(names(model), QStringList({"A", "B", "c", "D"}));
+    QCOMPARE(dataChanged.count(), 2);
+    QTRY_COMPARE(changed.count(), 1);
+}
+
+void TestMachineListModel::index_follows_machine_ids()
+{
+    MachineListModel model;
+    const auto list = machines({"a", "b", "c", "d", "e"});
+    model.setMachines(list);
+    const auto id = [&list](int i) { return list.at(i).id(); };
+
+    QCOMPARE(model.indexForId(id(3)).row(), 3);
+    QVERIFY(!model.indexForId(QUuid::createUuid()).isValid());
+
+    QVERIFY(model.moveRows({}, 3, 2, {}, 0));
+    QCOMPARE(model.indexForId(id(3)).row(), 0);
+    QCOMPARE(model.indexForId(id(0)).row(), 2);
+
+    QVERIFY(model.moveMachines({0, 4}, 2));
+    QCOMPARE(names(model), QStringList({"e", "d", "c", "a", "b"}));
+    for (int row = 0; row < model.rowCount({}); ++row) {
+        QCOMPARE(model.indexForId(model.machineForIndex(model.index(row)).id()).row(), row);
+    }
+
+    model.removeMachines({model.index(0), model.index(2)});
+    QVERIFY(!model.indexForId(id(4)).isValid());
+    QCOMPARE(model.indexForId(id(1)).row(), 2);
+
+    const auto added = machines({"x"});
+    model.addMachines(added);
+    QCOMPARE(model.indexForId(added.first().id()).row(), 3);
+
+    model.replaceMachines({model.index(0)}, added);
+    QVERIFY(!model.indexForId(id(3)).isValid());
+    QCOMPARE(model.indexForId(added.first().id()).row(), 3);
+}
+
+void TestMachineListModel::index_follows_scattered_rows()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e", "f", "g", "h", "i", "j"}));
+    const auto checkIndex = [&model]() {
+        for (int row = 0; row < model.rowCount({}); ++row) {
+            QCOMPARE(model.indexForId(model.machineAt(row).id()).row(), row);
+        }
+    };
+
+    const QList<int> rows = {1, 4, 5, 8};
+    QList<Machine> removed;
+    QModelIndexList indexes;
+    for (const auto row : rows) {
+        removed.append(model.machineAt(row));
+        indexes.append(model.index(row));
+    }
+    model.removeMachines(indexes);
+    QCOMPARE(names(model), QStringList({"a", "c", "d", "g", "h", "j"}));
+    checkIndex();
+    for (const auto &machine : removed) {
+        QVERIFY(!model.indexForId(machine.id()).isValid());
+    }
+
+    model.insertMachines(rows, removed);
+    QCOMPARE(names(model), QStringList({"a", "b", "c", "d", "e", "f", "g", "h", "i", "j"}));
+    checkIndex();
+}
+
+void TestMachineListModel::duplicate_ids_are_replaced()
+{
+    MachineListModel model;
+    const auto list = machines({"a"});
+    model.setMachines(list + list);
+    QCOMPARE(model.indexForId(list.first().id()).row(), 0);
+    QVERIFY(model.machineForIndex(model.index(1)).id() != list.first().id());
+
+    model.addMachine(list.first());
+    QCOMPARE(model.rowCount({}), 3);
+    QCOMPARE(model.indexForId(list.first().id()).row(), 0);
+    QCOMPARE(model.indexForId(model.machineForIndex(model.index(2)).id()).row(), 2);
+}
+
+void TestMachineListModel::changes_are_collected_per_turn()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c"}));
+    model.flushChanges();
+    const auto a = model.machineAt(0).id();
+    const auto b = model.machineAt(1).id();
+    const auto c = model.machineAt(2).id();
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+
+    auto edited = model.machineAt(0);
+    edited.setName("A");
+    model.setMachineForIndex(model.index(0), edited);
+    QVERIFY(model.moveRows({}, 1, 1, {}, 3));
+    model.remove(model.index(1));
+    model.addMachine(machines({"d"}).first());
+    model.remove(model.index(2));
+    QCOMPARE(names(model), QStringList({"A", "b"}));
+    QCOMPARE(changed.count(), 0);
+
+    QVERIFY(changed.wait());
+    QCOMPARE(changed.count(), 1);
+    const auto changes = changed.first().first().value<MachineListModel::ChangeSet>();
+    QCOMPARE(changes.kinds,
+             MachineListModel::ChangeSet::Kinds(
+                 MachineListModel::ChangeSet::Inserted | MachineListModel::ChangeSet::Updated
+                 | MachineListModel::ChangeSet::Removed | MachineListModel::ChangeSet::Moved));
+    QCOMPARE(changes.updated, QSet<QUuid>({a}));
+    QCOMPARE(changes.moved, QSet<QUuid>({b}));
+    QCOMPARE(changes.removed, QSet<QUuid>({c}));
+    QVERIFY(changes.inserted.isEmpty());
+
+    // Nothing is sent for a turn without changes
+    QVERIFY(!changed.wait(100));
+}
+
+void TestMachineListModel::undo_insert_and_remove()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e"}));
+    const auto a = model.machineAt(0).id();
+    QUndoStack stack;
+    QSignalSpy changed(&model, &MachineListModel::modelChanged);
+
+    stack.push(new RemoveMachinesCommand(&model, {3, 0, 4}));
+    QCOMPARE(names(model), QStringList({"b", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c", "d", "e"}));
+    QCOMPARE(model.machineAt(0).id(), a);
+    QCOMPARE(model.indexForId(a).row(), 0);
+    stack.redo();
+    QCOMPARE(names(model), QStringList({"b", "c"}));
+    QTRY_COMPARE(changed.count(), 1);
+    auto changes = changed.last().first().value<MachineListModel::ChangeSet>();
+    QCOMPARE(changes.removed.size(), 3);
+    QVERIFY(changes.removed.contains(a));
+    QVERIFY(changes.updated.isEmpty());
+
+    stack.push(new InsertMachinesCommand(&model, {0, 2, 4}, machines({"x", "y", "z"})));
+    QCOMPARE(names(model), QStringList({"x", "b", "y", "c", "z"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"b", "c"}));
+    stack.redo();
+    QCOMPARE(names(model), QStringList({"x", "b", "y", "c", "z"}));
+    QTRY_COMPARE(changed.count(), 2);
+    changes = changed.last().first().value<MachineListModel::ChangeSet>();
+    QCOMPARE(changes.inserted.size(), 3);
+    QVERIFY(changes.removed.isEmpty());
+}
+
+void TestMachineListModel::undo_replace()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c"}));
+    QUndoStack stack;
+
+    auto edited = model.machineAt(1);
+    edited.setName("B");
+    stack.push(new ReplaceMachinesCommand(&model, {1}, {edited}));
+    QCOMPARE(names(model), QStringList({"a", "B", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c"}));
+    QCOMPARE(model.indexForId(edited.id()).row(), 1);
+}
+
+void TestMachineListModel::undo_moves()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c", "d", "e"}));
+    QUndoStack stack;
+    QSignalSpy layoutChanged(&model, &MachineListModel::layoutChanged);
+    QSignalSpy moved(&model, &MachineListModel::rowsMoved);
+
+    stack.push(new MoveMachinesCommand(&model, {4, 0, 3}, 2));
+    QCOMPARE(names(model), QStringList({"b", "a", "d", "e", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c", "d", "e"}));
+    QCOMPARE(layoutChanged.count(), 2);
+
+    stack.push(new MoveMachinesCommand(&model, {1, 2}, 5));
+    QCOMPARE(names(model), QStringList({"a", "d", "e", "b", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c", "d", "e"}));
+    stack.push(new MoveMachinesCommand(&model, {3, 4}, 1));
+    QCOMPARE(names(model), QStringList({"a", "d", "e", "b", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c", "d", "e"}));
+    QCOMPARE(moved.count(), 4);
+    QCOMPARE(layoutChanged.count(), 2);
+
+    // Moves that keep the order are not kept in the history
+    stack.clear();
+    stack.push(new MoveMachinesCommand(&model, {1, 2}, 1));
+    QCOMPARE(stack.count(), 0);
+}
+
+void TestMachineListModel::undo_internal_drop()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c"}));
+    QUndoStack stack;
+    model.setUndoStack(&stack);
+
+    QScopedPointer<QMimeData> data(model.mimeData({model.index(0), model.index(1)}));
+    QVERIFY(!model.dropMimeData(data.data(), Qt::MoveAction, 3, 0, {}));
+    QCOMPARE(names(model), QStringList({"c", "a", "b"}));
+    QCOMPARE(stack.count(), 1);
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c"}));
+}
+
+void TestMachineListModel::undo_after_drag()
+{
+    MachineListModel model;
+    model.setMachines(machines({"a", "b", "c"}));
+    QUndoStack stack;
+    model.setUndoStack(&stack);
+
+    // Edit the first machine, then drag it to the end like the view does
+    auto edited = model.machineAt(0);
+    edited.setName("A");
+    stack.push(new ReplaceMachinesCommand(&model, {0}, {edited}));
+    model.moveDraggedMachines({0}, 3);
+    QCOMPARE(names(model), QStringList({"b", "c", "A"}));
+    QCOMPARE(stack.count(), 2);
+
+    // The drag is undone first, so the edit is undone at the row it was made
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"A", "b", "c"}));
+    stack.undo();
+    QCOMPARE(names(model), QStringList({"a", "b", "c"}));
+    stack.redo();
+    stack.redo();
+    QCOMPARE(names(model), QStringList({"b", "c", "A"}));
+}
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+void TestMachineListModel::multi_data_matches_data()
+{
+    MachineListModel model;
+    auto list = machines({"a"});
+    list.first().setSummary("summary");
+    list.first().setIcon(Machine::IconFromTheme, "pc");
+    model.setMachines(list);
+
+    std::array<QModelRoleData, 4> roles = {QModelRoleData(Qt::DisplayRole),
+                                           QModelRoleData(MachineListModel::SummaryRole),
+                                           QModelRoleData(MachineListModel::IconNameRole),
+                                           QModelRoleData(Qt::ToolTipRole)};
+    model.index(0).multiData(roles);
+    QCOMPARE(roles[0].data().toString(), QString("a"));
+    QCOMPARE(roles[1].data().toString(), QString("summary"));
+    QCOMPARE(roles[2].data().toString(), QString("pc"));
+    QVERIFY(!roles[3].data().isValid());
+}
+#endif
+
+QTEST_GUILESS_MAIN(TestMachineListModel)
+#include "test_machinelistmodel.moc"
@@ -0,0 +1,331 @@
+#include "data/machinestore.h"
+#include "data/machinestoreloader.h"
+#include "data/machinestorewriter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class TestMachineStore : public QObject
+{
+    Q_OBJECT
+private slots:
+    void journal_is_replayed();
+    void stale_journal_is_ignored();
+    void incomplete_record_stops_replay();
+    void writer_saves_queued_work();
+    void loader_restores_in_background();
+    void cbor_round_trip();
+    void corrupt_cbor_length_fails();
+    void format_change_converts_snapshot();
+    void lazy_restore_keeps_records_data();
+    void lazy_restore_keeps_records();
+    void backup_moves_files_aside();
+
+private:
+    static Machine machine(const QString &name);
+    static QStringList names(const QList<Machine> &machines);
+};
+
+Machine TestMachineStore::machine(const QString &name)
+{
+    Machine machine;
+    machine.setName(name);
+    return machine;
+}
+
+QStringList TestMachineStore::names(const QList<Machine> &machines)
+{
+    QStringList names;
+    for (const auto &machine : machines) {
+        names.append(machine.name());
+    }
+    return names;
+}
+
+void TestMachineStore::journal_is_replayed()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact({machine("a"), machine("b"), machine("c")}));
+
+    MachineJournal::Entry insert;
+    insert.operation = MachineJournal::Insert;
+    insert.row = 1;
+    insert.machines = {machine("x"), machine("y")};
+
+    MachineJournal::Entry update;
+    update.operation = MachineJournal::Update;
+    update.row = 0;
+    update.machines = {machine("A")};
+
+    MachineJournal::Entry remove;
+    remove.operation = MachineJournal::Remove;
+    remove.row = 3;
+    remove.count = 1;
+
+    MachineJournal::Entry move;
+    move.operation = MachineJournal::Move;
+    move.row = 0;
+    move.count = 1;
+    move.destination = 4;
+
+    QVERIFY(store.append({insert, update}));
+    QVERIFY(store.append({remove, move}));
+
+    QList<Machine> machines;
+    bool journalValid = false;
+    QVERIFY(store.restore(machines, &journalValid));
+    QVERIFY(journalValid);
+    QCOMPARE(names(machines), QStringList({"x", "y", "c", "A"}));
+}
+
+void TestMachineStore::stale_journal_is_ignored()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact({machine("a")}));
+
+    MachineJournal::Entry remove;
+    remove.operation = MachineJournal::Remove;
+    remove.row = 0;
+    remove.count = 1;
+    QVERIFY(store.append({remove}));
+
+    // Simulate a snapshot written without resetting the journal
+    QFile snapshot(store.snapshotFileName());
+    QVERIFY(snapshot.open(QFile::WriteOnly));
+    snapshot.write(R"([{"name": "b"}])");
+    snapshot.close();
+
+    QList<Machine> machines;
+    bool journalValid = true;
+    QVERIFY(store.restore(machines, &journalValid));
+    QVERIFY(!journalValid);
+    QCOMPARE(names(machines), QStringList({"b"}));
+
+    // The snapshot had no ID for the machine
+    QVERIFY(machines.first().idAssigned());
+}
+
+void TestMachineStore::incomplete_record_stops_replay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact({machine("a")}));
+
+    MachineJournal::Entry insert;
+    insert.operation = MachineJournal::Insert;
+    insert.row = 1;
+    insert.machines = {machine("b")};
+    QVERIFY(store.append({insert}));
+
+    // Simulate a write interrupted in the middle of a record
+    QFile journal(store.journalFileName());
+    QVERIFY(journal.open(QFile::WriteOnly | QFile::Append));
+    journal.write(R"({"op":"remove","ro)");
+    journal.close();
+
+    QList<Machine> machines;
+    bool journalValid = true;
+    QVERIFY(store.restore(machines, &journalValid));
+    QVERIFY(!journalValid);
+    QCOMPARE(names(machines), QStringList({"a", "b"}));
+}
+
+void TestMachineStore::writer_saves_queued_work()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    {
+        MachineStoreWriter writer(store);
+        writer.queueSnapshot({machine("old")});
+        writer.queueSnapshot({machine("a")});
+
+        MachineJournal::Entry insert;
+        insert.operation = MachineJournal::Insert;
+        insert.row = 1;
+        insert.machines = {machine("b")};
+        writer.queueChanges({insert});
+        writer.waitForIdle();
+        QVERIFY(!writer.compactionNeeded());
+    }
+
+    QList<Machine> machines;
+    bool journalValid = false;
+    QVERIFY(store.restore(machines, &journalValid));
+    QVERIFY(journalValid);
+    QCOMPARE(names(machines), QStringList({"a", "b"}));
+}
+
+void TestMachineStore::loader_restores_in_background()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact({machine("a"), machine("b")}));
+
+    MachineStoreLoader loader(store);
+    QSignalSpy finished(&loader, &MachineStoreLoader::finished);
+    loader.start();
+    QVERIFY(finished.wait());
+    QVERIFY(loader.isFinished());
+    QVERIFY(loader.restored());
+    QVERIFY(loader.journalValid());
+    QCOMPARE(names(loader.machines()), QStringList({"a", "b"}));
+
+    // Waiting after the signal must not emit it again
+    loader.wait();
+    QCOMPARE(finished.count(), 1);
+}
+
+void TestMachineStore::cbor_round_trip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QVariantMap config = {{"id", "0f8fad5b-d9cb-469f-a165-70867728950e"},
+                          {"configFile", "config-file"},
+                          {"iconName", "pc"},
+                          {"iconType", Machine::NoIcon},
+                          {"name", "Test machine"},
+                          {"settingsCommand", "settings-command"},
+                          {"startCommand", "start-command"},
+                          {"summary", "summary"},
+                          {"extra", "should keep this"}};
+
+    MachineStore store(dir.path(), MachineStore::CborFormat);
+    QVERIFY(store.compact({Machine(config)}));
+    QVERIFY(QFile::exists(dir.filePath("machines.cbor")));
+
+    QList<Machine> machines;
+    bool journalValid = false;
+    QVERIFY(store.restore(machines, &journalValid));
+    QVERIFY(journalValid);
+    QCOMPARE(machines.size(), 1);
+    QCOMPARE(machines.first().save(), config);
+}
+
+void TestMachineStore::corrupt_cbor_length_fails()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Signature tag and an array claiming 2^63 - 1 machines
+    MachineStore store(dir.path(), MachineStore::CborFormat);
+    QFile snapshot(store.snapshotFileName());
+    QVERIFY(snapshot.open(QFile::WriteOnly));
+    snapshot.write(QByteArray::fromHex("d9d9f79b7fffffffffffffff"));
+    snapshot.close();
+
+    QList<Machine> machines;
+    QVERIFY(!store.restore(machines));
+    QVERIFY(store.errorString().startsWith("CBOR error"));
+}
+
+void TestMachineStore::format_change_converts_snapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore jsonStore(dir.path(), MachineStore::JsonFormat);
+    QVERIFY(jsonStore.compact({machine("a"), machine("b")}));
+
+    MachineStore cborStore(dir.path(), MachineStore::CborFormat);
+    QList<Machine> machines;
+    bool journalValid = true;
+    QVERIFY(cborStore.restore(machines, &journalValid));
+    QVERIFY(!journalValid);
+    QCOMPARE(names(machines), QStringList({"a", "b"}));
+
+    QVERIFY(cborStore.compact(machines));
+    QVERIFY(QFile::exists(dir.filePath("machines.cbor")));
+    QVERIFY(!QFile::exists(dir.filePath("machines.json")));
+}
+
+void TestMachineStore::lazy_restore_keeps_records_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addRow("json") << int(MachineStore::JsonFormat);
+    QTest::addRow("cbor") << int(MachineStore::CborFormat);
+}
+
+void TestMachineStore::lazy_restore_keeps_records()
+{
+    QFETCH(int, format);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QVariantMap config = {{"id", "0f8fad5b-d9cb-469f-a165-70867728950e"},
+                          {"configFile", "config-file"},
+                          {"iconName", "pc"},
+                          {"iconType", Machine::NoIcon},
+                          {"name", "Test machine"},
+                          {"settingsCommand", "settings-command"},
+                          {"startCommand", "start-command"},
+                          {"summary", "summary"},
+                          {"extra", "should keep this"}};
+
+    MachineStore store(dir.path(), static_cast<MachineStore::Format>(format));
+    store.setLazyRestore(true);
+    const auto b = machine("b");
+    QVERIFY(store.compact({Machine(config), b}));
+
+    QList<Machine> machines;
+    QVERIFY(store.restore(machines));
+    QCOMPARE(names(machines), QStringList({"Test machine", "b"}));
+
+    // Changing a list property must not be undone by the deferred load
+    auto copy = machines.first();
+    copy.setName("Renamed");
+    QCOMPARE(copy.configFile(), QString("config-file"));
+    QCOMPARE(copy.name(), QString("Renamed"));
+
+    QCOMPARE(machines.first().save(), config);
+    QCOMPARE(machines.last().save(), b.save());
+}
+
+void TestMachineStore::backup_moves_files_aside()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineStore store(dir.path());
+    QVERIFY(store.compact({machine("a")}));
+
+    // Unreadable snapshot must stay as it is
+    QFile snapshot(store.snapshotFileName());
+    QVERIFY(snapshot.open(QFile::WriteOnly));
+    snapshot.write("[{");
+    snapshot.close();
+
+    QList<Machine> machines;
+    QVERIFY(!store.restore(machines));
+    QVERIFY(store.backup());
+    QVERIFY(!QFile::exists(store.snapshotFileName()));
+    QVERIFY(!QFile::exists(store.journalFileName()));
+
+    const auto backups = QDir(dir.path()).entryList({"machines.json.bak-*"}, QDir::Files);
+    QCOMPARE(backups.size(), 1);
+    QFile backup(dir.filePath(backups.first()));
+    QVERIFY(backup.open(QFile::ReadOnly));
+    QCOMPARE(backup.readAll(), QByteArray("[{"));
+
+    QVERIFY(store.restore(machines));
+    QVERIFY(machines.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestMachineStore)
+#include "test_machinestore.moc"
@@ -0,0 +1,259 @@
+#include "data/machinestore.h"
+#include "mvc/machinetreemodel.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class TestMachineTreeModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void folders_are_built_from_paths();
+    void rows_are_fetched_lazily();
+    void move_folder_updates_paths();
+    void folder_cannot_move_into_itself();
+    void move_keeps_sort_order();
+    void move_rejects_name_collisions();
+    void tree_is_restored_from_store();
+
+private:
+    static Machine machine(const QString &name, const QString &folder = {});
+    static QModelIndex find(MachineTreeModel &model, const QString &path);
+    static QStringList rowNames(MachineTreeModel &model, const QModelIndex &parent);
+};
+
+Machine TestMachineTreeModel::machine(const QString &name, const QString &folder)
+{
+    Machine machine;
+    machine.setName(name);
+    if (!folder.isEmpty()) {
+        machine.setExtraVariable(MachineTreeModel::FOLDER_VARIABLE, folder);
+    }
+    return machine;
+}
+
+QModelIndex TestMachineTreeModel::find(MachineTreeModel &model, const QString &path)
+{
+    QModelIndex index;
+    for (const auto &name : path.split('/')) {
+        while (model.canFetchMore(index)) {
+            model.fetchMore(index);
+        }
+        const auto matches = model.match(model.index(0, 0, index), Qt::DisplayRole, name, 1,
+                                         Qt::MatchExactly);
+        if (matches.isEmpty()) {
+            return {};
+        }
+        index = matches.first();
+    }
+    return index;
+}
+
+QStringList TestMachineTreeModel::rowNames(MachineTreeModel &model, const QModelIndex &parent)
+{
+    while (model.canFetchMore(parent)) {
+        model.fetchMore(parent);
+    }
+    QStringList names;
+    for (int row = 0; row < model.rowCount(parent); ++row) {
+        names.append(model.index(row, 0, parent).data().toString());
+    }
+    return names;
+}
+
+void TestMachineTreeModel::folders_are_built_from_paths()
+{
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro/DOS"),
+                       machine("b"),
+                       machine("c", "Retro"),
+                       machine("d", "/Retro//DOS/"),
+                       machine("e", "Modern")});
+
+    QCOMPARE(model.machineCount({}), 5);
+    model.fetchMore({});
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(model.index(0, 0).data().toString(), QString("Modern"));
+    QCOMPARE(model.index(1, 0).data().toString(), QString("Retro"));
+    QCOMPARE(model.index(2, 0).data().toString(), QString("b"));
+
+    const auto retro = model.index(1, 0);
+    QVERIFY(model.isFolder(retro));
+    QCOMPARE(model.machineCount(retro), 3);
+    QCOMPARE(retro.data(MachineTreeModel::MachineCountRole).toInt(), 3);
+
+    const auto dos = find(model, "Retro/DOS");
+    QVERIFY(dos.isValid());
+    QCOMPARE(dos.parent(), retro);
+    QCOMPARE(model.folderPath(dos), QString("Retro/DOS"));
+    QCOMPARE(model.rowCount(dos), 2);
+    QCOMPARE(model.machineForIndex(model.index(1, 0, dos)).name(), QString("d"));
+}
+
+void TestMachineTreeModel::rows_are_fetched_lazily()
+{
+    QList<Machine> machines;
+    for (int i = 0; i < 1000; ++i) {
+        machines.append(machine(QString::number(i), "Big"));
+    }
+    MachineTreeModel model;
+    model.setMachines(machines);
+
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(model.hasChildren());
+    QVERIFY(model.canFetchMore({}));
+    model.fetchMore({});
+    QCOMPARE(model.rowCount(), 1);
+
+    const auto big = model.index(0, 0);
+    QVERIFY(model.hasChildren(big));
+    QCOMPARE(model.rowCount(big), 0);
+    QCOMPARE(model.machineCount(big), 1000);
+
+    QSignalSpy inserted(&model, &MachineTreeModel::rowsInserted);
+    int fetches = 0;
+    while (model.canFetchMore(big)) {
+        model.fetchMore(big);
+        ++fetches;
+    }
+    QVERIFY(fetches > 1);
+    QCOMPARE(inserted.count(), fetches);
+    QCOMPARE(model.rowCount(big), 1000);
+}
+
+void TestMachineTreeModel::move_folder_updates_paths()
+{
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro/DOS"),
+                       machine("b", "Retro/DOS/Games"),
+                       machine("c", "Retro"),
+                       machine("d", "Archive")});
+    QSignalSpy moved(&model, &MachineTreeModel::rowsMoved);
+    QSignalSpy changed(&model, &MachineTreeModel::modelChanged);
+
+    const auto dos = find(model, "Retro/DOS");
+    const auto archive = find(model, "Archive");
+    QVERIFY(dos.isValid());
+    QVERIFY(archive.isValid());
+    QCOMPARE(model.machineCount(archive), 1);
+
+    QVERIFY(model.moveRows(dos.parent(), dos.row(), 1, archive, 0));
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(changed.count(), 1);
+
+    QCOMPARE(model.machineCount(find(model, "Retro")), 1);
+    QCOMPARE(model.machineCount(find(model, "Archive")), 3);
+    QVERIFY(find(model, "Archive/DOS/Games").isValid());
+
+    QStringList folders;
+    for (const auto &machine : model.machines()) {
+        folders.append(machine.extraVariables().value(MachineTreeModel::FOLDER_VARIABLE).toString());
+    }
+    QCOMPARE(folders, QStringList({"Archive/DOS", "Archive/DOS/Games", "Retro", "Archive"}));
+}
+
+void TestMachineTreeModel::folder_cannot_move_into_itself()
+{
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro/DOS")});
+
+    const auto retro = find(model, "Retro");
+    const auto dos = find(model, "Retro/DOS");
+    QVERIFY(!model.moveRows({}, retro.row(), 1, retro, 0));
+    QVERIFY(!model.moveRows({}, retro.row(), 1, dos, 0));
+    QCOMPARE(model.folderPath(find(model, "Retro/DOS")), QString("Retro/DOS"));
+
+    // Nothing is moved if any row of the batch cannot be moved
+    MachineTreeModel batch;
+    batch.setMachines({machine("a", "Archive"), machine("b", "Retro/DOS")});
+    QCOMPARE(rowNames(batch, {}), QStringList({"Archive", "Retro"}));
+    QVERIFY(!batch.moveRows({}, 0, 2, find(batch, "Retro/DOS"), 0));
+    QCOMPARE(rowNames(batch, {}), QStringList({"Archive", "Retro"}));
+    QCOMPARE(batch.folderPath(find(batch, "Archive")), QString("Archive"));
+}
+
+void TestMachineTreeModel::move_keeps_sort_order()
+{
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro"),
+                       machine("b"),
+                       machine("c", "Retro"),
+                       machine("x", "Retro/Zeta"),
+                       machine("y", "Retro/Alpha"),
+                       machine("z", "Beta")});
+    const auto retro = find(model, "Retro");
+    QCOMPARE(rowNames(model, retro), QStringList({"Alpha", "Zeta", "a", "c"}));
+
+    // Machine goes after the machines before it in the list, folder between the folders
+    QCOMPARE(rowNames(model, {}), QStringList({"Beta", "Retro", "b"}));
+    QVERIFY(model.moveRows({}, 2, 1, find(model, "Retro"), 0));
+    QVERIFY(model.moveRows({}, 0, 1, find(model, "Retro"), 4));
+    QCOMPARE(rowNames(model, find(model, "Retro")),
+             QStringList({"Alpha", "Beta", "Zeta", "a", "b", "c"}));
+
+    // The tree built from the saved machines looks the same
+    MachineTreeModel restored;
+    restored.setMachines(model.machines());
+    QCOMPARE(rowNames(restored, {}), rowNames(model, {}));
+    QCOMPARE(rowNames(restored, find(restored, "Retro")), rowNames(model, find(model, "Retro")));
+
+    // Rows cannot be reordered inside their folder
+    const auto moved = find(model, "Retro");
+    QVERIFY(!model.moveRows(moved, 3, 1, moved, 0));
+}
+
+void TestMachineTreeModel::move_rejects_name_collisions()
+{
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro/DOS"),
+                       machine("b", "Archive/DOS"),
+                       machine("m", "Retro"),
+                       machine("m")});
+
+    // Folder with the same name
+    const auto archiveDos = find(model, "Archive/DOS");
+    QVERIFY(!model.moveRows(archiveDos.parent(), archiveDos.row(), 1, find(model, "Retro"), 0));
+    QCOMPARE(model.machineCount(find(model, "Retro")), 2);
+    QCOMPARE(model.machineCount(find(model, "Archive")), 1);
+
+    // Machine with the same name
+    const auto rootRows = rowNames(model, {});
+    QCOMPARE(rootRows, QStringList({"Archive", "Retro", "m"}));
+    QVERIFY(!model.moveRows({}, 2, 1, find(model, "Retro"), 0));
+    QCOMPARE(rowNames(model, {}), rootRows);
+
+    QStringList folders;
+    for (const auto &machine : model.machines()) {
+        const auto variables = machine.extraVariables();
+        folders.append(variables.value(MachineTreeModel::FOLDER_VARIABLE).toString());
+    }
+    QCOMPARE(folders, QStringList({"Retro/DOS", "Archive/DOS", "Retro", ""}));
+}
+
+void TestMachineTreeModel::tree_is_restored_from_store()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    MachineTreeModel model;
+    model.setMachines({machine("a", "Retro"), machine("b")});
+    const auto retro = find(model, "Retro");
+    model.fetchMore({});
+    QVERIFY(model.moveRows({}, model.rowCount() - 1, 1, retro, 0));
+
+    MachineStore store(dir.path());
+    store.setLazyRestore(true);
+    QVERIFY(store.compact(model.machines()));
+
+    QList<Machine> machines;
+    QVERIFY(store.restore(machines));
+    MachineTreeModel restored;
+    restored.setMachines(machines);
+    restored.fetchMore({});
+    QCOMPARE(restored.rowCount(), 1);
+    QCOMPARE(restored.machineCount(find(restored, "Retro")), 2);
+}
+
+QTEST_GUILESS_MAIN(TestMachineTreeModel)
+#include "test_machinetreemodel.moc"
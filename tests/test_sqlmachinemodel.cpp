@@ -0,0 +1,188 @@
+#include "mvc/machinelistmodel.h"
+#include "mvc/sqlmachinemodel.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QtTest/QTest>
+
+class TestSqlMachineModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void rows_are_fetched_in_pages();
+    void machines_round_trip();
+    void search_matches_words();
+    void search_index_is_rebuilt();
+    void add_and_remove_machines();
+
+private:
+    static QList<Machine> machines(int count);
+    static void fetchAll(SqlMachineModel &model);
+};
+
+QList<Machine> TestSqlMachineModel::machines(int count)
+{
+    QList<Machine> machines;
+    for (int i = 0; i < count; ++i) {
+        Machine machine;
+        machine.setName(QString("Machine %1").arg(i));
+        machine.setSummary(i % 2 == 0 ? "Pentium MMX" : "486 DX2");
+        machines.append(machine);
+    }
+    return machines;
+}
+
+void TestSqlMachineModel::fetchAll(SqlMachineModel &model)
+{
+    while (model.canFetchMore({})) {
+        model.fetchMore({});
+    }
+}
+
+void TestSqlMachineModel::rows_are_fetched_in_pages()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SqlMachineModel model(dir.filePath("machines.sqlite"));
+    QVERIFY2(model.open(), qPrintable(model.errorString()));
+    model.setCacheSize(100);
+    model.setMachines(machines(1000));
+
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(model.canFetchMore({}));
+    model.fetchMore({});
+    QVERIFY(model.rowCount() > 0);
+    QVERIFY(model.rowCount() < 1000);
+
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 1000);
+
+    // Machines dropped from the cache are read again
+    QCOMPARE(model.index(0).data().toString(), QString("Machine 0"));
+    QCOMPARE(model.index(999).data().toString(), QString("Machine 999"));
+    QCOMPARE(model.index(1).data(MachineListModel::SummaryRole).toString(), QString("486 DX2"));
+}
+
+void TestSqlMachineModel::machines_round_trip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QVariantMap config = {{"id", "0f8fad5b-d9cb-469f-a165-70867728950e"},
+                          {"configFile", "config-file"},
+                          {"iconName", "pc"},
+                          {"iconType", Machine::NoIcon},
+                          {"name", "Test machine"},
+                          {"settingsCommand", "settings-command"},
+                          {"startCommand", "start-command"},
+                          {"summary", "summary"},
+                          {"extra", "should keep this"}};
+    {
+        SqlMachineModel model(dir.filePath("machines.sqlite"));
+        QVERIFY(model.open());
+        model.setMachines({Machine(config)});
+    }
+
+    SqlMachineModel model(dir.filePath("machines.sqlite"));
+    QVERIFY(model.open());
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(model.machineForIndex(model.index(0)).save(), config);
+    QCOMPARE(model.machines().size(), 1);
+    QCOMPARE(model.machines().first().save(), config);
+}
+
+void TestSqlMachineModel::search_matches_words()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SqlMachineModel model(dir.filePath("machines.sqlite"));
+    QVERIFY(model.open());
+    model.setMachines(machines(600));
+
+    model.setSearchText("pent");
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 300);
+    QCOMPARE(model.index(1).data().toString(), QString("Machine 2"));
+
+    model.setSearchText("machine 486");
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 300);
+    QCOMPARE(model.index(0).data().toString(), QString("Machine 1"));
+
+    model.setSearchText("\"quoted");
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 0);
+
+    model.setSearchText({});
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 600);
+}
+
+void TestSqlMachineModel::search_index_is_rebuilt()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.filePath("machines.sqlite");
+
+    {
+        SqlMachineModel model(fileName);
+        QVERIFY(model.open());
+        model.setMachines(machines(600));
+    }
+
+    // Simulate a database written before the full-text index existed
+    {
+        auto database = QSqlDatabase::addDatabase("QSQLITE", "without_fts");
+        database.setDatabaseName(fileName);
+        QVERIFY(database.open());
+        QSqlQuery query(database);
+        for (const auto *statement : {"DROP TRIGGER machines_fts_insert",
+                                      "DROP TRIGGER machines_fts_delete",
+                                      "DROP TRIGGER machines_fts_update",
+                                      "DROP TABLE machines_fts"}) {
+            QVERIFY(query.exec(statement));
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("without_fts");
+
+    SqlMachineModel model(fileName);
+    QVERIFY(model.open());
+    model.setSearchText("pent");
+    fetchAll(model);
+    QCOMPARE(model.rowCount(), 300);
+}
+
+void TestSqlMachineModel::add_and_remove_machines()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SqlMachineModel model(dir.filePath("machines.sqlite"));
+    QVERIFY(model.open());
+    model.setMachines(machines(5));
+    fetchAll(model);
+
+    model.addMachines(machines(2));
+    QCOMPARE(model.rowCount(), 7);
+    model.removeMachines({model.index(0), model.index(1), model.index(3)});
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.index(0).data().toString(), QString("Machine 2"));
+
+    auto machine = model.machineForIndex(model.index(0));
+    machine.setName("Renamed");
+    model.setMachineForIndex(model.index(0), machine);
+
+    QStringList names;
+    for (const auto &machine : model.machines()) {
+        names.append(machine.name());
+    }
+    QCOMPARE(names, QStringList({"Renamed", "Machine 4", "Machine 0", "Machine 1"}));
+}
+
+QTEST_GUILESS_MAIN(TestSqlMachineModel)
+#include "test_sqlmachinemodel.moc"